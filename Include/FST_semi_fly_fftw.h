@@ -0,0 +1,65 @@
+/***************************************************************************
+  **************************************************************************
+  
+                Spherical Harmonic Transform Kit 2.6
+  
+   Sean Moore, Dennis Healy, Dan Rockmore, Peter Kostelec
+   smoore@bbn.com, {healy,rockmore,geelong}@cs.dartmouth.edu
+  
+   Contact: Peter Kostelec
+            geelong@cs.dartmouth.edu
+  
+  
+   Copyright 1997-2003  Sean Moore, Dennis Healy,
+                        Dan Rockmore, Peter Kostelec
+  
+  
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published by
+     the Free Software Foundation; either version 2 of the License, or
+     (at your option) any later version.
+  
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+     GNU General Public License for more details.
+  
+     You should have received a copy of the GNU General Public License
+     along with this program; if not, write to the Free Software
+     Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+  
+  
+   Commercial use is absolutely prohibited.
+  
+   See the accompanying LICENSE file for details.
+  
+  ************************************************************************
+  ************************************************************************/
+
+
+/* external interface for FST_semi_fly_fftw.c */
+
+/*
+  Versions of FST_semi_memo_fftw and InvFST_semi_memo_fftw that do not
+  need the precomputed Legendre tables (which take O(bw^3) space), but
+  generate the cosine series of the P(m,l) of each order on the fly, as
+  FST_semi_fly does.
+
+  FST_semi_fly_fftw_TableSize() - the size of the tablespace needed by
+                                  the transforms
+
+  The transforms are otherwise called as the memo ones, with the phi
+  FFT plans returned by FST_semi_memo_fftw_plan and
+  InvFST_semi_memo_fftw_plan and the same workspace.
+*/
+
+#ifndef _FSTSEMI_FLY_FFTW_H
+#define _FSTSEMI_FLY_FFTW_H
+
+extern int  FST_semi_fly_fftw_TableSize	(int);
+extern void FST_semi_fly_fftw		(double *, fftw_complex *, int, double *, double *, fftw_plan);
+extern void FST_semi_fly_fftw		(float *, fftwf_complex *, int, float *, float *, fftwf_plan);
+extern void InvFST_semi_fly_fftw	(fftw_complex *, double *, int, double *, double *, fftw_plan);
+extern void InvFST_semi_fly_fftw	(fftwf_complex *, float *, int, float *, float *, fftwf_plan);
+
+#endif /* _FSTSEMI_FLY_FFTW_H */
@@ -52,5 +52,29 @@ extern void InvFST_semi_memo_fftw	(double *, double *, double *, int, double **,
 extern void InvFST_semi_memo_fftw	(fftw_complex *, double *, int, double **, double *);
 extern void InvFST_semi_memo_fftw	(float *, float *, float *, int, float **, float *);
 extern void InvFST_semi_memo_fftw	(fftwf_complex *, float *, int, float **, float *);
+// Versions taking the phi FFT plans, executed with the new-array interface
+extern fftw_plan  FST_semi_memo_fftw_plan	(double *, double *, int, unsigned);
+extern fftwf_plan FST_semi_memo_fftw_plan	(float *, float *, int, unsigned);
+extern fftw_plan  InvFST_semi_memo_fftw_plan	(double *, double *, int, unsigned);
+extern fftwf_plan InvFST_semi_memo_fftw_plan	(float *, float *, int, unsigned);
+extern void FST_semi_memo_fftw		(double *, fftw_complex *, int, double **, double *, fftw_plan);
+extern void FST_semi_memo_fftw		(float *, fftwf_complex *, int, float **, float *, fftwf_plan);
+extern void InvFST_semi_memo_fftw	(fftw_complex *, double *, int, double **, double *, fftw_plan);
+extern void InvFST_semi_memo_fftw	(fftwf_complex *, float *, int, float **, float *, fftwf_plan);
+// Batched forward transforms of several signals at once
+// The engines for the Legendre projections of each order
+#define FST_SEMINAIVE		0
+#define FST_FAST_LEGENDRE	1
+#define FST_NAIVE			2
+extern fftw_plan  FST_semi_memo_fftw_batch_plan	(double *, double *, int, int, unsigned);
+extern fftwf_plan FST_semi_memo_fftw_batch_plan	(float *, float *, int, int, unsigned);
+extern fftw_plan  FST_semi_memo_fftw_batch_dct_plan	(double *, int, int, int, unsigned);
+extern fftwf_plan FST_semi_memo_fftw_batch_dct_plan	(float *, int, int, int, unsigned);
+extern void FST_semi_memo_fftw_batch	(double *, fftw_complex **, int, int, int, double **, const int *, double **, int, double *, fftw_plan, fftw_plan);
+extern void FST_semi_memo_fftw_batch	(float *, fftwf_complex **, int, int, int, float **, const int *, float **, int, float *, fftwf_plan, fftwf_plan);
+extern void FST_semi_memo_fftw_batch_interleaved	(double *, fftw_complex *, int, int, int, double **, const int *, double **, int, double *, fftw_plan, fftw_plan);
+extern void FST_semi_memo_fftw_batch_interleaved	(float *, fftwf_complex *, int, int, int, float **, const int *, float **, int, float *, fftwf_plan, fftwf_plan);
+extern int  FST_semi_memo_fftw_batch_order	(double *, int, int, int, int, int, double **, double **, int);
+extern int  FST_semi_memo_fftw_batch_order	(float *, int, int, int, int, int, float **, float **, int);
 // Done misha added
 #endif /* _FSTSEMI_MEMO_FFTW_H */
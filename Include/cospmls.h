@@ -63,6 +63,10 @@ extern void CosPmlTableGen( int ,
 			    int ,
 			    double * ,
 			    double * ) ;
+extern void CosPmlTableGen( int ,
+			    int ,
+			    float * ,
+			    float * ) ;
 
 extern void CosPmlTableGenLim( int , 
 			       int ,
@@ -81,6 +85,10 @@ extern void Transpose_CosPmlTableGen( int ,
 				      int ,
 				      double * ,
 				      double * ) ;
+extern void Transpose_CosPmlTableGen( int ,
+				      int ,
+				      float * ,
+				      float * ) ;
 
 extern double **Spharmonic_Pml_Table( int ,
 				      double * ,
@@ -0,0 +1,47 @@
+/*
+  FFTW-based versions of kFCT and ExpIFCT (see newFCT.cpp), used for
+  transform sizes that are not powers of two (for which there are no
+  precomputed moduli tables).
+
+  kFCT_fftw() - computes the first k coefficients of the cosine
+                transform of n samples (DCT-II)
+  ExpIFCT_fftw() - evaluates a cosine series of length k at n
+                   points (DCT-III)
+
+  The arguments and the normalizations are as in kFCT and ExpIFCT,
+  except that the samples are always in natural order (there is no
+  permflag). The workspace needs to be of size 2*n.
+
+  The plans are created (with FFTW_ESTIMATE) the first time a size is
+  used, and are cached. Init_fftwFCT() can be used to create them
+  ahead of time, e.g. before the transforms are run in parallel.
+*/
+
+#ifndef _FFTWFCT_H
+#define _FFTWFCT_H
+
+extern void Init_fftwFCT( int ) ;
+
+extern void kFCT_fftw( double * ,
+		       double * ,
+		       double * ,
+		       int ,
+		       int ) ;
+extern void kFCT_fftw( float * ,
+		       float * ,
+		       float * ,
+		       int ,
+		       int ) ;
+
+extern void ExpIFCT_fftw( double * ,
+			  double * ,
+			  double * ,
+			  int ,
+			  int ) ;
+extern void ExpIFCT_fftw( float * ,
+			  float * ,
+			  float * ,
+			  int ,
+			  int ) ;
+
+#endif /* _FFTWFCT_H */
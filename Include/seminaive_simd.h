@@ -0,0 +1,100 @@
+/*
+  SIMD (AVX2/AVX-512) kernels for the projections in the seminaive
+  Legendre transforms, with runtime dispatch.
+
+  SemiNaiveProject() - forward projections: dot products of the rows
+                       of a cospml table with the (even or odd) cosine
+                       coefficients of the data
+  InvSemiNaiveProject() - inverse projections: dot products of the rows
+                       of a transposed cospml table with the (even or
+                       odd degree) associated Legendre coefficients
+
+  SemiNaiveDot() - the dot product of two contiguous arrays (e.g. the
+                   coefficients of two Fourier keys)
+
+  Both projection kernels project up to two columns (e.g. the real and
+  imaginary parts of the data) per pass over a table row.
+
+  SemiNaiveSIMDLevel() returns the instruction set used by the kernels:
+    0 = scalar, 1 = AVX2 + FMA, 2 = AVX-512
+  SetSemiNaiveSIMDLevel() can be used to lower it (e.g. for testing);
+  it is clamped to what the processor supports.
+*/
+
+#ifndef _SEMINAIVE_SIMD_H
+#define _SEMINAIVE_SIMD_H
+
+extern int SemiNaiveSIMDLevel( void ) ;
+
+extern void SetSemiNaiveSIMDLevel( int ) ;
+
+/*
+  cos_even, cos_odd: even and odd indexed cosine coefficients of the
+                     first column; column c starts at c*colStride
+  cols: number of columns (1 or 2)
+  bw, m: bandwidth and order
+  cos_pml_table: the cospml table for order m
+  result: the coefficient of degree m+i for column c is written to
+          result[i*resultStride+c]
+*/
+extern void SemiNaiveProject( const double * ,
+			      const double * ,
+			      int ,
+			      int ,
+			      int ,
+			      int ,
+			      const double * ,
+			      double * ,
+			      int ) ;
+extern void SemiNaiveProject( const float * ,
+			      const float * ,
+			      int ,
+			      int ,
+			      int ,
+			      int ,
+			      const float * ,
+			      float * ,
+			      int ) ;
+
+/*
+  even_series, odd_series: the associated Legendre coefficients of
+                           even and odd (relative) degree of the first
+                           column, i.e. coefficients m+2k and m+2k+1;
+                           column c starts at c*colStride
+  cols: number of columns (1 or 2)
+  bw, m: bandwidth and order
+  trans_cos_pml_table: the transposed cospml table for order m
+  fcos: the i-th cosine coefficient for column c is written to
+        fcos[i+c*fcosStride]
+*/
+extern void InvSemiNaiveProject( const double * ,
+				 const double * ,
+				 int ,
+				 int ,
+				 int ,
+				 int ,
+				 const double * ,
+				 double * ,
+				 int ) ;
+extern void InvSemiNaiveProject( const float * ,
+				 const float * ,
+				 int ,
+				 int ,
+				 int ,
+				 int ,
+				 const float * ,
+				 float * ,
+				 int ) ;
+
+/*
+  a, b: the arrays
+  n: their length
+*/
+extern double SemiNaiveDot( const double * ,
+			    const double * ,
+			    int ) ;
+extern float SemiNaiveDot( const float * ,
+			   const float * ,
+			   int ) ;
+
+#endif /* _SEMINAIVE_SIMD_H */
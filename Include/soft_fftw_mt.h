@@ -0,0 +1,109 @@
+/***************************************************************************
+  **************************************************************************
+  
+                SOFT: SO(3) Fourier transform code
+
+                Version 1.0
+
+  
+   Peter Kostelec, Dan Rockmore
+   {geelong,rockmore}@cs.dartmouth.edu
+  
+   Contact: Peter Kostelec
+            geelong@cs.dartmouth.edu
+  
+  
+   Copyright 2003 Peter Kostelec, Dan Rockmore
+  
+  
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published by
+     the Free Software Foundation; either version 2 of the License, or
+     (at your option) any later version.
+  
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+     GNU General Public License for more details.
+  
+     You should have received a copy of the GNU General Public License
+     along with this program; if not, write to the Free Software
+     Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+  
+  
+   Commercial use is absolutely prohibited.
+  
+   See the accompanying LICENSE file for details.
+  
+  ************************************************************************
+  ************************************************************************/
+
+/*
+  header file for the multithreaded inverse SO(3) transform using fftw
+
+  Inverse_SO3_Naive_fftw_mt() - as Inverse_SO3_Naive_fftw_pc() (or
+                                Inverse_SO3_Naive_fftw(), if no
+                                precomputed Wigner-ds are given), but
+                                with the order pairs and FFTs split
+                                over threads, in double (fftw_complex)
+                                or single (fftwf_complex) precision
+
+  Inverse_SO3_Naive_fftw_mt_real() - as Inverse_SO3_Naive_fftw_mt(), for
+                                REAL signals, synthesizing only half
+                                the order pairs and with complex-to-real
+                                FFTs
+
+  Inverse_SO3_Naive_fftw_mt_WorkspaceSize() - the size of the REAL
+                                workspace needed by each thread
+*/
+
+#ifndef _SOFT_FFTW_MT_H
+#define _SOFT_FFTW_MT_H
+
+extern int Inverse_SO3_Naive_fftw_mt_WorkspaceSize( int ) ;
+
+extern void Inverse_SO3_Naive_fftw_mt( int ,
+				       fftw_complex * ,
+				       fftw_complex * ,
+				       fftw_complex * ,
+				       fftw_complex * ,
+				       double * ,
+				       fftw_plan * ,
+				       double * ,
+				       int ,
+				       int ) ;
+
+extern void Inverse_SO3_Naive_fftw_mt( int ,
+				       fftwf_complex * ,
+				       fftwf_complex * ,
+				       fftwf_complex * ,
+				       fftwf_complex * ,
+				       double * ,
+				       fftwf_plan * ,
+				       float * ,
+				       int ,
+				       int ) ;
+
+extern void Inverse_SO3_Naive_fftw_mt_real( int ,
+					    fftw_complex * ,
+					    double * ,
+					    int ,
+					    fftw_complex * ,
+					    fftw_complex * ,
+					    double * ,
+					    fftw_plan * ,
+					    double * ,
+					    int ) ;
+
+extern void Inverse_SO3_Naive_fftw_mt_real( int ,
+					    fftwf_complex * ,
+					    float * ,
+					    int ,
+					    fftwf_complex * ,
+					    fftwf_complex * ,
+					    double * ,
+					    fftwf_plan * ,
+					    float * ,
+					    int ) ;
+
+#endif /* _SOFT_FFTW_MT_H */
@@ -0,0 +1,514 @@
+/*
+  A fast (Driscoll-Healy) Legendre transform, for the forward spherical
+  transforms at high band-widths.
+
+  For order m, the transform computes the projections
+
+    S(l) = sum_j data[j] * P(m,l)(x_j)    m <= l < bw
+
+  of samples at the 2*bw Chebyshev nodes x_j (for odd m, the P(m,l) are
+  divided by sin, as in the cospml tables, so the data is expected to
+  be weighted with the odd weights).
+
+  Writing G(l) for the product of the (interpolated) data with P(m,l),
+  S(l) is 2*bw times the constant Chebyshev coefficient of G(l). The
+  three-term recurrence gives polynomials A, B, C, D (of degree < s+1)
+  with
+
+    G(l+s)   = A * G(l+1) + B * G(l)
+    G(l+s+1) = C * G(l+1) + D * G(l)
+
+  and the constant coefficients of G(l), ..., G(l+K-1) only depend on
+  the first K Chebyshev coefficients of G(l) and G(l+1). So the degrees
+  [l,l+K) are split in half: the first half is computed from the
+  truncated coefficients of G(l) and G(l+1), and the second from those
+  of G(l+s) and G(l+s+1) (s = K/2), which are obtained by multiplying
+  with A, B, C and D at K Chebyshev nodes. Below FLT_LEAF_SIZE degrees,
+  the recurrence is run directly on the samples of G(l) and G(l+1).
+
+  The cost is O(bw log^2 bw) per order, rather than the O(bw^2) of the
+  seminaive transform, and the precomputed data (the values of A, B, C
+  and D at the nodes) is O(bw log bw) per order. However the constants
+  are much larger, so it only pays off at very high band-widths.
+
+  As with the original algorithm, the shifted polynomials grow quickly
+  where the P(m,l) are small, so the recursion is restarted from the
+  data at regular intervals (see FLT_ChunkSize), and the lowest degrees
+  of each order are left to the seminaive transform.
+
+  The cosine transforms are done with FFTW (see fftwFCT.h).
+*/
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fftwFCT.h"
+#include "primitive.h"
+#include "FLT_fftw.h"
+
+#ifndef PI
+#define PI 3.14159265358979
+#endif
+
+/* the number of degrees below which the recurrence is run directly */
+#ifndef FLT_LEAF_SIZE
+#define FLT_LEAF_SIZE 32
+#endif
+
+/* the chunks are kept below FLT_STABILITY * l / m degrees (see below) */
+#ifndef FLT_STABILITY
+#define FLT_STABILITY 16
+#endif
+
+/* the smallest number of degrees worth a restart */
+#ifndef FLT_MIN_CHUNK
+#define FLT_MIN_CHUNK 32
+#endif
+
+/*
+  The shifted polynomials from degree l to l+s grow like ((l+s)/l)^m
+  near the poles, which amplifies the round-off errors in the truncated
+  coefficients of G(l). So rather than running the recursion from m,
+  the degrees are split into chunks [l,l+K), with m*K <= FLT_STABILITY*l,
+  and each chunk is started from G(l) and G(l+1) computed from the data.
+  The degrees below the first chunk with at least FLT_MIN_CHUNK degrees
+  (i.e. below 2m) are left to the seminaive transform. With these
+  settings the relative error stays below 1e-9 in double precision
+  through bw=1024 (in single precision it is around 1e-4).
+*/
+
+/* the number of degrees in the chunk starting at l, a power of two */
+static int FLT_ChunkSize( int bw,
+			  int m,
+			  int l )
+{
+  int K;
+
+  for ( K = 2 ; K < bw - l ; K <<= 1 )
+    if ( m * (2*K) > FLT_STABILITY * l )
+      break;
+  return K;
+}
+
+int FLT_Start( int bw,
+	       int m,
+	       int crossover )
+{
+  int l;
+
+  l = ( m * FLT_MIN_CHUNK + FLT_STABILITY - 1 ) / FLT_STABILITY;
+  if ( l < m ) l = m;
+  if ( l < crossover ) l = crossover;
+  /* there should be enough degrees left */
+  if ( l + FLT_MIN_CHUNK > bw )
+    return bw;
+  return l;
+}
+
+/* the size of the precomputed data for the degrees [l,l+K) */
+static int FLT_NodeSize( int bw,
+			 int l,
+			 int K )
+{
+  int s = K/2;
+
+  if ( K <= FLT_LEAF_SIZE )
+    return 0;
+  if ( l + s >= bw )
+    return FLT_NodeSize( bw, l, s );
+  return 4*K + FLT_NodeSize( bw, l, s ) + FLT_NodeSize( bw, l + s, s );
+}
+
+/* the size of the precomputed data for the chunk starting at l:
+   G(l) and G(l+1) at the sample nodes, the leaf nodes and the shifted
+   polynomials */
+static int FLT_ChunkTableSize( int bw,
+			       int m,
+			       int l )
+{
+  int K = FLT_ChunkSize( bw, m, l );
+
+  return 4*bw + ( K < FLT_LEAF_SIZE ? K : FLT_LEAF_SIZE ) + FLT_NodeSize( bw, l, K );
+}
+
+int FLT_TableSize( int bw,
+		   int m,
+		   int crossover )
+{
+  int l, size;
+
+  l = FLT_Start( bw, m, crossover );
+  if ( l >= bw )
+    return 0;
+
+  /* the recurrence coefficients, then the chunks */
+  size = 2*(bw-m);
+  for ( ; l < bw ; l += FLT_ChunkSize( bw, m, l ) )
+    size += FLT_ChunkTableSize( bw, m, l );
+  return size;
+}
+
+int FLT_TablesSize( int bw,
+		    int crossover )
+{
+  int m, size = 0;
+
+  for ( m = 0 ; m < bw ; m ++ )
+    size += FLT_TableSize( bw, m, crossover );
+  return size;
+}
+
+/************************************************************************/
+/* precomputation */
+
+/* computes the shifted polynomials for the degrees [l,l+K) at the K
+   Chebyshev nodes, for the subtree in the order it is traversed:
+   [node][first half][second half] */
+template< class Real >
+static void _FLT_NodeGen( int bw,
+			  int m,
+			  int l,
+			  int K,
+			  const double *an,
+			  const double *cn,
+			  Real *table,
+			  double *workspace )
+{
+  int s = K/2, i, j, d;
+  double *x, *a0, *a1, *b0, *b1, t;
+  Real *A, *B, *C, *D;
+
+  if ( K <= FLT_LEAF_SIZE )
+    return;
+  if ( l + s >= bw )
+    {
+      _FLT_NodeGen( bw, m, l, s, an, cn, table, workspace );
+      return;
+    }
+
+  x = workspace;
+  a0 = x + K;
+  a1 = a0 + K;
+  b0 = a1 + K;
+  b1 = b0 + K;
+
+  A = table;
+  B = A + K;
+  C = B + K;
+  D = C + K;
+
+  for ( j = 0 ; j < K ; j ++ )
+    {
+      x[j] = cos( ((2.0*j+1.0) * PI) / (2.0*K) );
+      /* G(l) = 0, G(l+1) = 1 gives A and C; G(l) = 1, G(l+1) = 0 gives B and D */
+      a0[j] = 0.0;
+      a1[j] = 1.0;
+      b0[j] = 1.0;
+      b1[j] = 0.0;
+    }
+
+  /* advance both from degrees (l,l+1) to (l+s,l+s+1) */
+  for ( i = 0 ; i < s ; i ++ )
+    {
+      d = l + 1 + i - m;
+      for ( j = 0 ; j < K ; j ++ )
+	{
+	  t = an[d] * x[j] * a1[j] + cn[d] * a0[j];
+	  a0[j] = a1[j];
+	  a1[j] = t;
+	  t = an[d] * x[j] * b1[j] + cn[d] * b0[j];
+	  b0[j] = b1[j];
+	  b1[j] = t;
+	}
+    }
+
+  for ( j = 0 ; j < K ; j ++ )
+    {
+      A[j] = (Real) a0[j];
+      B[j] = (Real) b0[j];
+      C[j] = (Real) a1[j];
+      D[j] = (Real) b1[j];
+    }
+
+  _FLT_NodeGen( bw, m, l, s, an, cn, table + 4*K, workspace );
+  _FLT_NodeGen( bw, m, l + s, s, an, cn, table + 4*K + FLT_NodeSize( bw, l, s ), workspace );
+}
+
+template< class Real >
+static void _FLT_TableGen( int bw,
+			   int m,
+			   int crossover,
+			   Real *table )
+{
+  int i, j, n, l, lo, K, leaf;
+  double *an, *cn, *eval_args, *x, *p0, *p1, *workspace, t;
+  Real *tableptr;
+
+  n = 2*bw;
+  lo = FLT_Start( bw, m, crossover );
+  if ( lo >= bw )
+    return;
+
+  /* (the largest chunk is at the end) */
+  an = (double *) malloc( sizeof(double) * ( 2*bw + 4*n + 10*bw ) );
+  cn = an + bw;
+  eval_args = cn + bw;
+  x = eval_args + n;
+  p0 = x + n;
+  p1 = p0 + n;
+  workspace = p1 + n;
+
+  /* (the last shifted pair reaches degree bw) */
+  for ( i = 0 ; i <= bw - m ; i ++ )
+    {
+      an[i] = L2_an( m, m + i );
+      cn[i] = L2_cn( m, m + i );
+    }
+
+  tableptr = table;
+  for ( i = 0 ; i < bw - m ; i ++ )
+    {
+      tableptr[i] = (Real) an[i];
+      tableptr[bw-m+i] = (Real) cn[i];
+    }
+  tableptr += 2*(bw-m);
+
+  /* P(m,m-1) = 0 and P(m,m) at the sample nodes */
+  ArcCosEvalPts( n, eval_args );
+  for ( j = 0 ; j < n ; j ++ )
+    x[j] = cos( eval_args[j] );
+  if ( m == 0 )
+    for ( j = 0 ; j < n ; j ++ )
+      p1[j] = 1.0;
+  else
+    Pmm_L2( m, eval_args, n, p1 );
+  if ( (m % 2) == 1 )
+    for ( j = 0 ; j < n ; j ++ )
+      p1[j] /= sin( eval_args[j] );
+  for ( j = 0 ; j < n ; j ++ )
+    p0[j] = 0.0;
+
+  /* run the recurrence up to each chunk */
+  l = m;
+  while ( lo < bw )
+    {
+      for ( ; l < lo + 1 ; l ++ )
+	for ( j = 0 ; j < n ; j ++ )
+	  {
+	    t = an[l-m] * x[j] * p1[j] + cn[l-m] * p0[j];
+	    p0[j] = p1[j];
+	    p1[j] = t;
+	  }
+      /* now p0 = P(m,lo) and p1 = P(m,lo+1) */
+      for ( j = 0 ; j < n ; j ++ )
+	{
+	  tableptr[j] = (Real) p0[j];
+	  tableptr[n+j] = (Real) p1[j];
+	}
+      tableptr += 2*n;
+
+      K = FLT_ChunkSize( bw, m, lo );
+      leaf = K < FLT_LEAF_SIZE ? K : FLT_LEAF_SIZE;
+      for ( j = 0 ; j < leaf ; j ++ )
+	tableptr[j] = (Real) cos( ((2.0*j+1.0) * PI) / (2.0*leaf) );
+      tableptr += leaf;
+
+      _FLT_NodeGen( bw, m, lo, K, an, cn, tableptr, workspace );
+      tableptr += FLT_NodeSize( bw, lo, K );
+
+      lo += K;
+    }
+
+  free( an );
+}
+
+void FLT_TableGen( int bw, int m, int crossover, double *table ){ _FLT_TableGen( bw, m, crossover, table ); }
+void FLT_TableGen( int bw, int m, int crossover, float *table ){ _FLT_TableGen( bw, m, crossover, table ); }
+
+template< class Real >
+static Real **_FLT_Table( int bw,
+			  int crossover,
+			  Real *tablespace )
+{
+  Real **table;
+  int m;
+
+  table = (Real **) malloc( sizeof(Real *) * bw );
+  for ( m = 0 ; m < bw ; m ++ )
+    {
+      table[m] = 0;
+      if ( FLT_Start( bw, m, crossover ) < bw )
+	{
+	  table[m] = tablespace;
+	  FLT_TableGen( bw, m, crossover, tablespace );
+	  tablespace += FLT_TableSize( bw, m, crossover );
+	}
+    }
+  return table;
+}
+
+double **FLT_Table( int bw, int crossover, double *tablespace ){ return _FLT_Table( bw, crossover, tablespace ); }
+float **FLT_Table( int bw, int crossover, float *tablespace ){ return _FLT_Table( bw, crossover, tablespace ); }
+
+/************************************************************************/
+/* the transform */
+
+/* computes S(l), ..., S(l+K-1) (and only those below lim) from the
+   first K Chebyshev coefficients of G(l) and G(l+1) */
+template< class Real >
+static void _FLT_Node( int bw,
+		       int m,
+		       int l,
+		       int K,
+		       int lim,
+		       const Real *c0,
+		       const Real *c1,
+		       const Real *an,
+		       const Real *cn,
+		       const Real *leafNodes,
+		       const Real *table,
+		       Real scale,
+		       Real *result,
+		       int resultStride,
+		       Real *workspace )
+{
+  int s = K/2, r, j, d, count;
+  Real *v0, *v1, *fctws, *u0, *u1;
+  const Real *A, *B, *C, *D;
+  Real a, b, t, sum;
+
+  v0 = workspace;
+  v1 = v0 + K;
+  fctws = v1 + K;                    /* needs (2 * K) */
+
+  if ( K <= FLT_LEAF_SIZE )
+    {
+      /* G(l) and G(l+1) at K nodes, then the recurrence */
+      ExpIFCT_fftw( (Real *) c0, v0, fctws, K, K );
+      ExpIFCT_fftw( (Real *) c1, v1, fctws, K, K );
+
+      count = lim - l < K ? lim - l : K;
+      scale /= (Real) K;
+      for ( r = 0 ; r < count ; r ++ )
+	{
+	  if ( r > 1 )
+	    {
+	      d = l + r - 1 - m;
+	      for ( j = 0 ; j < K ; j ++ )
+		{
+		  t = an[d] * leafNodes[j] * v1[j] + cn[d] * v0[j];
+		  v0[j] = v1[j];
+		  v1[j] = t;
+		}
+	    }
+	  sum = 0;
+	  if ( r == 0 )
+	    for ( j = 0 ; j < K ; j ++ ) sum += v0[j];
+	  else
+	    for ( j = 0 ; j < K ; j ++ ) sum += v1[j];
+	  result[(l+r-m)*resultStride] = sum * scale;
+	}
+      return;
+    }
+
+  if ( l + s >= bw )
+    {
+      _FLT_Node( bw, m, l, s, lim, c0, c1, an, cn, leafNodes, table, scale, result, resultStride, workspace );
+      return;
+    }
+
+  /* the first half only needs the truncated coefficients */
+  _FLT_Node( bw, m, l, s, lim, c0, c1, an, cn, leafNodes, table + 4*K, scale, result, resultStride, workspace );
+  if ( l + s >= lim )
+    return;
+
+  A = table;
+  B = A + K;
+  C = B + K;
+  D = C + K;
+  u0 = fctws + 2*K;
+  u1 = u0 + s;
+
+  ExpIFCT_fftw( (Real *) c0, v0, fctws, K, K );
+  ExpIFCT_fftw( (Real *) c1, v1, fctws, K, K );
+  for ( j = 0 ; j < K ; j ++ )
+    {
+      a = v1[j];
+      b = v0[j];
+      v0[j] = A[j] * a + B[j] * b;
+      v1[j] = C[j] * a + D[j] * b;
+    }
+  kFCT_fftw( v0, u0, fctws, K, s );
+  kFCT_fftw( v1, u1, fctws, K, s );
+
+  _FLT_Node( bw, m, l + s, s, lim, u0, u1, an, cn, leafNodes, table + 4*K + FLT_NodeSize( bw, l, s ), scale, result, resultStride, u1 + s );
+}
+
+template< class Real >
+static void _FLT_fftw( Real *data,
+		       int signalStride,
+		       int howmany,
+		       int bw,
+		       int m,
+		       int crossover,
+		       int lim,
+		       Real *result,
+		       const Real *table,
+		       Real *workspace )
+{
+  int n, K, k, j, l, lo, cols, leaf;
+  const Real *an, *cn, *p0, *p1, *leafNodes, *tree;
+  Real *c0, *c1, *g0, *g1, *fctws;
+
+  n = 2*bw;
+  cols = 2*howmany;
+  lo = FLT_Start( bw, m, crossover );
+
+  an = table;
+  cn = an + (bw-m);
+
+  /* assign workspace */
+  c0 = workspace;                    /* needs (2 * bw) */
+  c1 = c0 + (2 * bw);                /* needs (2 * bw) */
+  g0 = c1 + (2 * bw);                /* needs (20 * bw), shared with the recursion */
+  g1 = g0 + n;
+  fctws = g1 + n;
+
+  p0 = cn + (bw-m);
+  for ( l = lo ; l < bw && l < lim ; l += K )
+    {
+      K = FLT_ChunkSize( bw, m, l );
+      leaf = K < FLT_LEAF_SIZE ? K : FLT_LEAF_SIZE;
+      p1 = p0 + n;
+      leafNodes = p1 + n;
+      tree = leafNodes + leaf;
+
+      for ( k = 0 ; k < cols ; k ++ )
+	{
+	  Real *signal = data + (k/2)*signalStride + (k%2);
+
+	  /* the Chebyshev coefficients of G(l) and G(l+1) */
+	  for ( j = 0 ; j < n ; j ++ )
+	    {
+	      g0[j] = signal[2*j] * p0[j];
+	      g1[j] = signal[2*j] * p1[j];
+	    }
+	  kFCT_fftw( g0, c0, fctws, n, K );
+	  kFCT_fftw( g1, c1, fctws, n, K );
+
+	  _FLT_Node( bw, m, l, K, lim, c0, c1, an, cn, leafNodes, tree, (Real) n, result + k, cols, g0 );
+	}
+
+      p0 = tree + FLT_NodeSize( bw, l, K );
+    }
+}
+
+void FLT_fftw( double *data, int signalStride, int howmany, int bw, int m, int crossover, int lim, double *result, const double *table, double *workspace )
+{
+  _FLT_fftw( data, signalStride, howmany, bw, m, crossover, lim, result, table, workspace );
+}
+void FLT_fftw( float *data, int signalStride, int howmany, int bw, int m, int crossover, int lim, float *result, const float *table, float *workspace )
+{
+  _FLT_fftw( data, signalStride, howmany, bw, m, crossover, lim, result, table, workspace );
+}
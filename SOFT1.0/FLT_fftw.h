@@ -0,0 +1,91 @@
+/*
+  A fast (Driscoll-Healy) Legendre transform, see FLT_fftw.cpp.
+
+  FLT_Start() - the first degree computed by the fast transform for
+                order m (the lower ones should be computed with the
+                seminaive transform), or bw if the fast transform is
+                not used for that order
+  FLT_TableSize() - the size of the precomputed data for order m
+  FLT_TablesSize() - the size of the precomputed data for all orders
+  FLT_TableGen() - computes the precomputed data for order m
+  FLT_Table() - computes the precomputed data for all orders into
+                tablespace, and returns an array of bw pointers to the
+                data of each order (0 for the orders that do not use
+                the fast transform), which should be freed
+  FLT_fftw() - computes the order m Legendre projections of the real
+               and imaginary parts of howmany complex signals, for the
+               degrees FLT_Start(bw,m,crossover) <= l < lim
+
+  The fast transform is only used from degree crossover on (and from
+  a higher one if that is needed for stability), so the crossover is
+  passed to all of the functions.
+
+  The arguments of FLT_fftw are as in SemiNaiveReduced_fftw_batch:
+
+  data - the (interleaved) weighted complex samples, with signal k
+         starting at data + k*signalStride (the 2*bw samples of a signal
+         are consecutive)
+  lim - only the coefficients of degree l < lim are computed (lim<=bw)
+  result - the projection onto P(m,m+i) of the real and imaginary parts
+           of signal k are written to result[2*(i*howmany+k)] and
+           result[2*(i*howmany+k)+1] (only for the degrees computed)
+  table - the precomputed data for order m
+  workspace - needs (24 * bw)
+
+  The projections are the sums of the samples times P(m,l) at the
+  Chebyshev nodes (without the normalizations of the seminaive
+  transform).
+*/
+
+#ifndef _FLT_FFTW_H
+#define _FLT_FFTW_H
+
+extern int FLT_Start( int ,
+		      int ,
+		      int ) ;
+
+extern int FLT_TableSize( int ,
+			  int ,
+			  int ) ;
+
+extern int FLT_TablesSize( int ,
+			   int ) ;
+
+extern void FLT_TableGen( int ,
+			  int ,
+			  int ,
+			  double * ) ;
+extern void FLT_TableGen( int ,
+			  int ,
+			  int ,
+			  float * ) ;
+
+extern double **FLT_Table( int ,
+			   int ,
+			   double * ) ;
+extern float **FLT_Table( int ,
+			  int ,
+			  float * ) ;
+
+extern void FLT_fftw( double * ,
+		      int ,
+		      int ,
+		      int ,
+		      int ,
+		      int ,
+		      int ,
+		      double * ,
+		      const double * ,
+		      double * ) ;
+extern void FLT_fftw( float * ,
+		      int ,
+		      int ,
+		      int ,
+		      int ,
+		      int ,
+		      int ,
+		      float * ,
+		      const float * ,
+		      float * ) ;
+
+#endif /* _FLT_FFTW_H */
@@ -0,0 +1,258 @@
+/***************************************************************************
+  **************************************************************************
+  
+                Spherical Harmonic Transform Kit 2.6
+  
+   Sean Moore, Dennis Healy, Dan Rockmore, Peter Kostelec
+   smoore@bbn.com, {healy,rockmore,geelong}@cs.dartmouth.edu
+  
+   Contact: Peter Kostelec
+            geelong@cs.dartmouth.edu
+  
+  
+   Copyright 1997-2003  Sean Moore, Dennis Healy,
+                        Dan Rockmore, Peter Kostelec
+  
+  
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published by
+     the Free Software Foundation; either version 2 of the License, or
+     (at your option) any later version.
+  
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+     GNU General Public License for more details.
+  
+     You should have received a copy of the GNU General Public License
+     along with this program; if not, write to the Free Software
+     Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+  
+  
+   Commercial use is absolutely prohibited.
+  
+   See the accompanying LICENSE file for details.
+  
+  ************************************************************************
+  ************************************************************************/
+
+
+/********************************************************************
+
+  FST_semi_fly_fftw.c - versions of the FST_semi_memo_fftw transforms
+  for band-widths at which the precomputed Legendre tables do not fit
+  in memory.
+
+  As in FST_semi_fly, the cosine series of the P(m,l) (and, for the
+  inverse transform, their transposes) are generated for one order at
+  a time, right before they are used, so only the tables of a single
+  order are kept. This takes O(bw^2) rather than O(bw^3) space, at the
+  cost of computing the tables anew for each transform.
+
+  1) FST_semi_fly_fftw() - computes the spherical harmonic expansion
+                           of a real signal.
+  2) InvFST_semi_fly_fftw() - computes the inverse spherical harmonic
+                              transform.
+
+  The data, coefficients, workspace and plans are as for the memo
+  versions (see FST_semi_memo_fftw.cpp), and tablespace needs
+  FST_semi_fly_fftw_TableSize(bw) entries.
+
+*/
+
+#include <math.h>
+#include <string.h>
+
+#include "cospmls.h"
+#include "primitive.h"
+#include "primitive_FST.h"
+#include "seminaive_fftw.h"
+#include <fftw3.h>
+#include "FST_semi_fly_fftw.h"
+
+/************************************************************************/
+/* the space needed for the tables of one order: the order 0 table is
+   the largest, and the inverse transform also needs its transpose */
+
+int FST_semi_fly_fftw_TableSize( int bw )
+{
+  return 2 * TableSize( 0, bw );
+}
+
+static void ExecuteFST( fftw_plan plan, double *data, double *res )
+{
+  fftw_execute_dft_r2c( plan, data, (fftw_complex *) res );
+}
+static void ExecuteFST( fftwf_plan plan, float *data, float *res )
+{
+  fftwf_execute_dft_r2c( plan, data, (fftwf_complex *) res );
+}
+static void ExecuteInvFST( fftw_plan plan, double *fourdata, double *data )
+{
+  fftw_execute_dft_c2r( plan, (fftw_complex *) fourdata, data );
+}
+static void ExecuteInvFST( fftwf_plan plan, float *fourdata, float *data )
+{
+  fftwf_execute_dft_c2r( plan, (fftwf_complex *) fourdata, data );
+}
+
+/************************************************************************/
+/* the forward transform: coeffs are the (interleaved) complex
+   coefficients, in the order of FST_semi_memo_fftw */
+
+template< class Real, class Plan >
+static void _FST_semi_fly_fftw( Real *data, Real *coeffs,
+				int size, Real *tablespace,
+				Real *workspace, Plan plan )
+{
+  int bw, m, i;
+  Real *res, *dataptr;
+  Real *fltres, *eval_pts, *scratchpad;
+  Real tmpA, tmpB, tmp;
+
+  bw = size/2;
+
+  /* assign space */
+  res = workspace;                    /* needs (4 * bw * (bw+1)) */
+  fltres = res + ( 4 * bw * (bw+1));  /* needs (2 * bw)  */
+  eval_pts = fltres + (2*bw);         /* needs (2*bw)  */
+  scratchpad = eval_pts + (2*bw);     /* needs (24 * bw)  */
+
+  /* do the FFTs along phi */
+  ExecuteFST( plan, data, res );
+
+  /* the normalization of FST_semi_memo_fftw */
+  tmpA = (Real) ( 2. * sqrt( PI ) / size );
+  tmpB = (Real) ( sqrt( 2. * PI ) / size );
+
+  /* point to start of output data buffers */
+  dataptr = coeffs;
+  for (m=0; m<bw; m++)
+    {
+      /* generate the cosine series of the pmls of this order */
+      CosPmlTableGen( bw, m, tablespace, scratchpad );
+
+      /* do the real and imaginary parts together */
+      SemiNaiveReduced_fftw_cx( res+(2*m*size),
+				bw,
+				m,
+				fltres,
+				tablespace,
+				scratchpad );
+
+      /* now load the normalized coefficients into output space */
+      tmp = ( m == 0 ) ? tmpA : tmpB;
+      for (i=0; i<2*(bw-m); i++)
+	dataptr[i] = fltres[i] * tmp;
+
+      dataptr += (bw-m)*2;
+    }
+}
+
+/************************************************************************/
+/* the inverse transform. Unlike InvFST_semi_memo_fftw, the
+   coefficients are normalized into the workspace, so they are not
+   modified */
+
+template< class Real, class Plan >
+static void _InvFST_semi_fly_fftw( Real *coeffs, Real *data,
+				   int size, Real *tablespace,
+				   Real *workspace, Plan plan )
+{
+  int bw, m, i, n;
+  Real *dataptr, *temp;
+  Real *fourdata, *transpose_table;
+  Real *invfltres, *scratchpad;
+  Real *sin_values, *mcoeffs;
+  Real tmpA, tmpB, tmp;
+
+  bw = size/2;
+
+  /* allocate space */
+  fourdata = workspace;                      /* needs (4 * bw * (bw+1)) */
+  invfltres = fourdata + (4 * bw * (bw+1));  /* needs (4 * bw) */
+  sin_values = invfltres + (4 * bw);         /* needs (2 * bw) */
+  mcoeffs = sin_values + (2 * bw);           /* needs (2 * bw) */
+  scratchpad = mcoeffs + (2 * bw);           /* needs (24 * bw) */
+
+  /* total workspace = (4 * bw^2) + (36 * bw) */
+
+  transpose_table = tablespace + TableSize( 0, bw );
+
+  /* load up the sin_values array */
+  n = 2*bw;
+
+  ArcCosEvalPts( n, scratchpad );
+  for (i=0; i<n; i++)
+    sin_values[i] = (Real) sin( scratchpad[i] );
+
+  /* the normalization of InvFST_semi_memo_fftw */
+  tmpA = (Real) ( 1. / ( 2. * sqrt( PI ) ) );
+  tmpB = (Real) ( 1. / sqrt( 2. * PI ) );
+
+  /* Now do all of the inverse Legendre transforms */
+  dataptr = coeffs;
+  for (m=0; m<bw; m++)
+    {
+      tmp = ( m == 0 ) ? tmpA : tmpB;
+      for (i=0; i<2*(bw-m); i++)
+	mcoeffs[i] = dataptr[i] * tmp;
+
+      /* generate the transposed cosine series of the pmls of this order */
+      CosPmlTableGen( bw, m, tablespace, scratchpad );
+      Transpose_CosPmlTableGen( bw, m, tablespace, transpose_table );
+
+      /* do the real and imaginary parts together */
+      InvSemiNaiveReduced_fftw_cx( mcoeffs,
+				   bw,
+				   m,
+				   invfltres,
+				   transpose_table,
+				   sin_values,
+				   scratchpad );
+
+      /* will store normal, then tranpose before doing inverse fft */
+      temp = fourdata + (2*m*size);
+      for (i=0; i<size; i++)
+	{
+	  temp[2*i  ] = invfltres[i];
+	  temp[2*i+1] = invfltres[size+i];
+	}
+
+      /* move to next set of coeffs */
+      dataptr += (bw-m)*2;
+    }
+
+  /* now fill in zero values where m = bw (from problem definition) */
+  memset( fourdata + (2*bw*size), 0, sizeof(Real) * size * 2 );
+
+  /* do the FFTs along phi */
+  ExecuteInvFST( plan, fourdata, data );
+}
+
+/************************************************************************/
+
+void FST_semi_fly_fftw( double *data, fftw_complex *coeffs,
+			int size, double *tablespace,
+			double *workspace, fftw_plan plan )
+{
+  _FST_semi_fly_fftw( data, (double *) coeffs, size, tablespace, workspace, plan );
+}
+void FST_semi_fly_fftw( float *data, fftwf_complex *coeffs,
+			int size, float *tablespace,
+			float *workspace, fftwf_plan plan )
+{
+  _FST_semi_fly_fftw( data, (float *) coeffs, size, tablespace, workspace, plan );
+}
+void InvFST_semi_fly_fftw( fftw_complex *coeffs, double *data,
+			   int size, double *tablespace,
+			   double *workspace, fftw_plan plan )
+{
+  _InvFST_semi_fly_fftw( (double *) coeffs, data, size, tablespace, workspace, plan );
+}
+void InvFST_semi_fly_fftw( fftwf_complex *coeffs, float *data,
+			   int size, float *tablespace,
+			   float *workspace, fftwf_plan plan )
+{
+  _InvFST_semi_fly_fftw( (float *) coeffs, data, size, tablespace, workspace, plan );
+}
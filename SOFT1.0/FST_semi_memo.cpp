@@ -172,8 +172,11 @@ void FST_semi_memo(double *rdata, double *idata,
 	dims1.n=dims2.n=size;
 	dims1.is=dims2.os=1;
 	dims1.os=dims2.is=size;
-	fftw_plan plan=fftw_plan_guru_split_dft(1,&dims1,1,&dims2,rdata,idata,rres,ires,FFTW_ESTIMATE);
+	fftw_plan plan;
+#pragma omp critical (FFTWPlanner)
+	plan=fftw_plan_guru_split_dft(1,&dims1,1,&dims2,rdata,idata,rres,ires,FFTW_ESTIMATE);
 	fftw_execute(plan);
+#pragma omp critical (FFTWPlanner)
 	fftw_destroy_plan(plan);
 	// Generate the FFTW plan
 #else // !USE_FFTW
@@ -601,7 +604,9 @@ void InvFST_semi_memo(double *rcoeffs, double *icoeffs,
 	dims1.is=dims2.os=size;
 	dims1.os=dims2.is=1;
 	// Generate the FFTW plan
-	fftw_plan plan=fftw_plan_guru_split_dft(1,&dims1,1,&dims2,ifourdata, rfourdata, idata, rdata,FFTW_ESTIMATE);
+	fftw_plan plan;
+#pragma omp critical (FFTWPlanner)
+	plan=fftw_plan_guru_split_dft(1,&dims1,1,&dims2,ifourdata, rfourdata, idata, rdata,FFTW_ESTIMATE);
 	// do the FFTs along phi
 	fftw_execute(plan);
 #else // !USE_FFTW
@@ -72,7 +72,11 @@
 #include "primitive_FST.h"
 #include "seminaive.h"
 #include "seminaive_fftw.h"
+#include "FLT_fftw.h"
+#include "weights.h"
+#include "oddweights.h"
 #include <fftw3.h>
+#include "FST_semi_memo_fftw.h"
 
 #define compmult(a,b,c,d,e,f) (e) = ((a)*(c))-((b)*(d)); (f) = ((a)*(d))+((b)*(c))
 
@@ -160,8 +164,11 @@ void FST_semi_memo_fftw(double *rdata,
 	dims1.n=dims2.n=size;
 	dims1.is=dims2.os=1;
 	dims1.os=dims2.is=size;
-	fftw_plan plan=fftw_plan_guru_split_dft_r2c(1,&dims1,1,&dims2,rdata,rres,ires,FFTW_ESTIMATE);
+	fftw_plan plan;
+#pragma omp critical (FFTWPlanner)
+	plan=fftw_plan_guru_split_dft_r2c(1,&dims1,1,&dims2,rdata,rres,ires,FFTW_ESTIMATE);
 	fftw_execute(plan);
+#pragma omp critical (FFTWPlanner)
 	fftw_destroy_plan(plan);
 
 	/* point to start of output data buffers */
@@ -226,16 +233,52 @@ void FST_semi_memo_fftw(double *rdata,
 			}
 		}
 }
+/* creates the plan for the FFTs along phi used by FST_semi_memo_fftw.
+   data and workspace are only used for planning (with FFTW_MEASURE they
+   are overwritten), so any arrays with the same alignment can be passed
+   to the transform. */
+fftw_plan FST_semi_memo_fftw_plan(double *data, double *workspace,
+								  int size, unsigned flags)
+{
+	fftw_iodim dims1,dims2;
+	dims1.n=dims2.n=size;
+	dims1.is=dims2.os=1;
+	dims1.os=dims2.is=size;
+	return fftw_plan_guru_dft_r2c(1,&dims1,1,&dims2,data,(fftw_complex*)workspace,flags);
+}
+fftwf_plan FST_semi_memo_fftw_plan(float *data, float *workspace,
+								   int size, unsigned flags)
+{
+	fftw_iodim dims1,dims2;
+	dims1.n=dims2.n=size;
+	dims1.is=dims2.os=1;
+	dims1.os=dims2.is=size;
+	return fftwf_plan_guru_dft_r2c(1,&dims1,1,&dims2,data,(fftwf_complex*)workspace,flags);
+}
 void FST_semi_memo_fftw(double *data, fftw_complex* coeffs,
 						int size, double **seminaive_naive_table,
 						double *workspace)
+{
+	fftw_plan plan;
+#pragma omp critical (FFTWPlanner)
+	plan=FST_semi_memo_fftw_plan(data,workspace,size,FFTW_ESTIMATE);
+	FST_semi_memo_fftw(data,coeffs,size,seminaive_naive_table,workspace,plan);
+#pragma omp critical (FFTWPlanner)
+	fftw_destroy_plan(plan);
+}
+/* same as above, but with the phi FFTs performed by a plan returned by
+   FST_semi_memo_fftw_plan. The plan is executed with the new-array
+   interface so that the same plan can be shared by concurrent calls
+   with distinct data and workspace arrays. */
+void FST_semi_memo_fftw(double *data, fftw_complex* coeffs,
+						int size, double **seminaive_naive_table,
+						double *workspace, fftw_plan plan)
 {
 	int bw, m;
 	double *res;
 	double *dataptr;
 	double *fltres, *scratchpad;
 	double *eval_pts;
-	double *cos_even;
 	int l, dummy ;
 	double tmpA, tmpB ;
 
@@ -246,38 +289,21 @@ void FST_semi_memo_fftw(double *data, fftw_complex* coeffs,
 	fltres = res + ( 4 * bw * (bw+1));  /* needs (2 * bw)  */
 	eval_pts = fltres + (2*bw);         /* needs (2*bw)  */
 	scratchpad = eval_pts + (2*bw);     /* needs (24 * bw)  */
-	cos_even = scratchpad + (24*bw);    /* needs (bw) */
 
 
 	/* total workspace is (4 * bw^2) + (32 * bw) */
-	fftw_iodim dims1,dims2;
-	fftw_plan plan;
-	dims1.n=dims2.n=size;
-	dims1.is=dims2.os=1;
-	dims1.os=dims2.is=size;
-	plan=fftw_plan_guru_dft_r2c(1,&dims1,1,&dims2,data,(fftw_complex*)res,FFTW_ESTIMATE);
-	fftw_execute(plan);
-	fftw_destroy_plan(plan);
+	fftw_execute_dft_r2c(plan,data,(fftw_complex*)res);
 
 	/* point to start of output data buffers */
 	dataptr = (double*)coeffs;
 	for (m=0; m<bw; m++) {
-		/* do the real part */
-		SemiNaiveReduced_fftw(res+(2*m*size), 
+		/* do the real and imaginary parts together */
+		SemiNaiveReduced_fftw_cx(res+(2*m*size), 
 			bw, 
 			m, 
 			fltres, 
 			seminaive_naive_table[m],
-			scratchpad,
-			cos_even);
-		/* do imaginary part */
-		SemiNaiveReduced_fftw(res+1+(2*m*size),
-			bw, 
-			m, 
-			fltres+1, 
-			seminaive_naive_table[m],
-			scratchpad,
-			cos_even);
+			scratchpad);
 		/* now load real and imaginary part of coefficients into output space */  
 		memcpy(dataptr, fltres, sizeof(double) * (bw - m) * 2);
 
@@ -315,13 +341,23 @@ void FST_semi_memo_fftw(double *data, fftw_complex* coeffs,
 void FST_semi_memo_fftw(float *data, fftwf_complex* coeffs,
 						int size, float **seminaive_naive_table,
 						float *workspace)
+{
+	fftwf_plan plan;
+#pragma omp critical (FFTWPlanner)
+	plan=FST_semi_memo_fftw_plan(data,workspace,size,FFTW_ESTIMATE);
+	FST_semi_memo_fftw(data,coeffs,size,seminaive_naive_table,workspace,plan);
+#pragma omp critical (FFTWPlanner)
+	fftwf_destroy_plan(plan);
+}
+void FST_semi_memo_fftw(float *data, fftwf_complex* coeffs,
+						int size, float **seminaive_naive_table,
+						float *workspace, fftwf_plan plan)
 {
 	int bw, m;
 	float *res;
 	float *dataptr;
 	float *fltres, *scratchpad;
 	float *eval_pts;
-	float *cos_even;
 	int l, dummy ;
 	float tmpA, tmpB ;
 
@@ -332,38 +368,21 @@ void FST_semi_memo_fftw(float *data, fftwf_complex* coeffs,
 	fltres = res + ( 4 * bw * (bw+1));  /* needs (2 * bw)  */
 	eval_pts = fltres + (2*bw);         /* needs (2*bw)  */
 	scratchpad = eval_pts + (2*bw);     /* needs (24 * bw)  */
-	cos_even = scratchpad + (24*bw);    /* needs (bw) */
 
 
 	/* total workspace is (4 * bw^2) + (32 * bw) */
-	fftw_iodim dims1,dims2;
-	fftwf_plan plan;
-	dims1.n=dims2.n=size;
-	dims1.is=dims2.os=1;
-	dims1.os=dims2.is=size;
-	plan=fftwf_plan_guru_dft_r2c(1,&dims1,1,&dims2,data,(fftwf_complex*)res,FFTW_ESTIMATE);
-	fftwf_execute(plan);
-	fftwf_destroy_plan(plan);
+	fftwf_execute_dft_r2c(plan,data,(fftwf_complex*)res);
 
 	/* point to start of output data buffers */
 	dataptr = (float*)coeffs;
 	for (m=0; m<bw; m++) {
-		/* do the real part */
-		SemiNaiveReduced_fftw(res+(2*m*size), 
+		/* do the real and imaginary parts together */
+		SemiNaiveReduced_fftw_cx(res+(2*m*size), 
 			bw, 
 			m, 
 			fltres, 
 			seminaive_naive_table[m],
-			scratchpad,
-			cos_even);
-		/* do imaginary part */
-		SemiNaiveReduced_fftw(res+1+(2*m*size),
-			bw, 
-			m, 
-			fltres+1, 
-			seminaive_naive_table[m],
-			scratchpad,
-			cos_even);
+			scratchpad);
 		/* now load real and imaginary part of coefficients into output space */  
 		memcpy(dataptr, fltres, sizeof(float) * (bw - m) * 2);
 
@@ -431,8 +450,11 @@ void FST_semi_memo_fftw(float *rdata,
 	dims1.n=dims2.n=size;
 	dims1.is=dims2.os=1;
 	dims1.os=dims2.is=size;
-	fftwf_plan plan=fftwf_plan_guru_split_dft_r2c(1,&dims1,1,&dims2,rdata,rres,ires,FFTW_ESTIMATE);
+	fftwf_plan plan;
+#pragma omp critical (FFTWPlanner)
+	plan=fftwf_plan_guru_split_dft_r2c(1,&dims1,1,&dims2,rdata,rres,ires,FFTW_ESTIMATE);
 	fftwf_execute(plan);
+#pragma omp critical (FFTWPlanner)
 	fftwf_destroy_plan(plan);
 
 	/* point to start of output data buffers */
@@ -498,10 +520,42 @@ void FST_semi_memo_fftw(float *rdata,
 		}
 }
 
+/* creates the plan for the inverse FFTs along phi used by
+   InvFST_semi_memo_fftw (see FST_semi_memo_fftw_plan) */
+fftw_plan InvFST_semi_memo_fftw_plan(double *data, double *workspace,
+									 int size, unsigned flags)
+{
+	fftw_iodim dims1,dims2;
+	dims1.n=dims2.n=size;
+	dims1.is=dims2.os=size;
+	dims1.os=dims2.is=1;
+	return fftw_plan_guru_dft_c2r(1,&dims1,1,&dims2,(fftw_complex*)workspace,data,flags);
+}
+fftwf_plan InvFST_semi_memo_fftw_plan(float *data, float *workspace,
+									  int size, unsigned flags)
+{
+	fftw_iodim dims1,dims2;
+	dims1.n=dims2.n=size;
+	dims1.is=dims2.os=size;
+	dims1.os=dims2.is=1;
+	return fftwf_plan_guru_dft_c2r(1,&dims1,1,&dims2,(fftwf_complex*)workspace,data,flags);
+}
 void InvFST_semi_memo_fftw(fftw_complex *coeffs,double *data, 
 					  int size, 
 					  double **transpose_seminaive_naive_table,
 					  double *workspace)
+{
+	fftw_plan plan;
+#pragma omp critical (FFTWPlanner)
+	plan=InvFST_semi_memo_fftw_plan(data,workspace,size,FFTW_ESTIMATE);
+	InvFST_semi_memo_fftw(coeffs,data,size,transpose_seminaive_naive_table,workspace,plan);
+#pragma omp critical (FFTWPlanner)
+	fftw_destroy_plan(plan);
+}
+void InvFST_semi_memo_fftw(fftw_complex *coeffs,double *data, 
+					  int size, 
+					  double **transpose_seminaive_naive_table,
+					  double *workspace, fftw_plan plan)
 {
 	int bw, m, i, n;
 	double *dataptr;
@@ -561,8 +615,8 @@ void InvFST_semi_memo_fftw(fftw_complex *coeffs,double *data,
 
 		for (m=0; m<bw; m++)
 		{
-			/* do real part first */ 
-			InvSemiNaiveReduced_fftw(dataptr,
+			/* do the real and imaginary parts together */
+			InvSemiNaiveReduced_fftw_cx(dataptr,
 				bw,
 				m,
 				invfltres,
@@ -570,16 +624,6 @@ void InvFST_semi_memo_fftw(fftw_complex *coeffs,double *data,
 				sin_values,
 				scratchpad);
 
-			/* now do imaginary part */
-
-			InvSemiNaiveReduced_fftw(dataptr+1,
-				bw,
-				m,
-				invfltres+2*bw,
-				transpose_seminaive_naive_table[m],
-				sin_values,
-				scratchpad);
-
 			/* will store normal, then tranpose before doing inverse fft */
 			double *temp=fourdata+(2*m*size);
 			for(int i=0;i<size;i++){
@@ -598,15 +642,8 @@ void InvFST_semi_memo_fftw(fftw_complex *coeffs,double *data,
 		memset(fourdata + (2*bw*size),0,sizeof(double) * size *2);
 
 		/* now do inverse fourier grid computation */
-		fftw_iodim dims1,dims2;
-		dims1.n=dims2.n=size;
-		dims1.is=dims2.os=size;
-		dims1.os=dims2.is=1;
-		// Generate the FFTW plan
-		fftw_plan plan=fftw_plan_guru_dft_c2r(1,&dims1,1,&dims2, (fftw_complex*)fourdata, data,FFTW_ESTIMATE);
 		// do the FFTs along phi
-		fftw_execute(plan);
-		fftw_destroy_plan(plan);
+		fftw_execute_dft_c2r(plan,(fftw_complex*)fourdata,data);
 		/* amscray */
 }
 
@@ -614,6 +651,18 @@ void InvFST_semi_memo_fftw(fftwf_complex *coeffs,float *data,
 					  int size, 
 					  float **transpose_seminaive_naive_table,
 					  float *workspace)
+{
+	fftwf_plan plan;
+#pragma omp critical (FFTWPlanner)
+	plan=InvFST_semi_memo_fftw_plan(data,workspace,size,FFTW_ESTIMATE);
+	InvFST_semi_memo_fftw(coeffs,data,size,transpose_seminaive_naive_table,workspace,plan);
+#pragma omp critical (FFTWPlanner)
+	fftwf_destroy_plan(plan);
+}
+void InvFST_semi_memo_fftw(fftwf_complex *coeffs,float *data, 
+					  int size, 
+					  float **transpose_seminaive_naive_table,
+					  float *workspace, fftwf_plan plan)
 {
 	int bw, m, i, n;
 	float *dataptr;
@@ -673,8 +722,8 @@ void InvFST_semi_memo_fftw(fftwf_complex *coeffs,float *data,
 
 		for (m=0; m<bw; m++)
 		{
-			/* do real part first */ 
-			InvSemiNaiveReduced_fftw(dataptr,
+			/* do the real and imaginary parts together */
+			InvSemiNaiveReduced_fftw_cx(dataptr,
 				bw,
 				m,
 				invfltres,
@@ -682,16 +731,6 @@ void InvFST_semi_memo_fftw(fftwf_complex *coeffs,float *data,
 				sin_values,
 				scratchpad);
 
-			/* now do imaginary part */
-
-			InvSemiNaiveReduced_fftw(dataptr+1,
-				bw,
-				m,
-				invfltres+2*bw,
-				transpose_seminaive_naive_table[m],
-				sin_values,
-				scratchpad);
-
 			/* will store normal, then tranpose before doing inverse fft */
 			float *temp=fourdata+(2*m*size);
 			for(int i=0;i<size;i++){
@@ -710,19 +749,522 @@ void InvFST_semi_memo_fftw(fftwf_complex *coeffs,float *data,
 		memset(fourdata + (2*bw*size),0,sizeof(float) * size *2);
 
 		/* now do inverse fourier grid computation */
-		fftw_iodim dims1,dims2;
-		dims1.n=dims2.n=size;
-		dims1.is=dims2.os=size;
-		dims1.os=dims2.is=1;
-		// Generate the FFTW plan
-		fftwf_plan plan=fftwf_plan_guru_dft_c2r(1,&dims1,1,&dims2, (fftwf_complex*)fourdata, data,FFTW_ESTIMATE);
 		// do the FFTs along phi
-		fftwf_execute(plan);
-		fftwf_destroy_plan(plan);
+		fftwf_execute_dft_c2r(plan,(fftwf_complex*)fourdata,data);
 		/* amscray */
 
 }
 
+/************************************************************************/
+/* batched versions of FST_semi_memo_fftw, transforming howmany signals
+   at once.
+
+   data - the howmany (size x size) signals, stored consecutively
+   coeffs - an array of howmany pointers to the coefficients of the
+            signals (in the same order as FST_semi_memo_fftw)
+   lim - only the coefficients of degree l < lim are computed, the
+         others are set to zero (lim = bw computes all of them)
+   engines - the Legendre projections used for each of the bw orders
+             (FST_SEMINAIVE, FST_FAST_LEGENDRE or FST_NAIVE), or NULL
+             to only use the seminaive transform
+   flt_table - the fast Legendre transform data returned by FLT_Table
+               (only needed for the orders using FST_FAST_LEGENDRE, the
+               others can have a 0 pointer), or NULL
+   crossover - the crossover degree the fast transform data was
+               computed for (see FLT_fftw.h)
+   workspace - needs (4 * bw * (bw+1) * howmany) + (4 * bw * bw * howmany) + (6 * bw * howmany) + (24 * bw)
+   plan - the plan returned by FST_semi_memo_fftw_batch_plan
+   dctPlan - the plan returned by FST_semi_memo_fftw_batch_dct_plan, for
+             (at least) the first min(lim,bw) orders
+
+   FST_semi_memo_fftw_batch_interleaved takes the same arguments, but
+   writes the coefficients of all the signals into the single array
+   coeffs, ordered by degree and then order, with the signals innermost:
+   the coefficient of degree l and order m (0<=m<=l) of signal k is at
+   coeffs[((l*(l+1))/2 + m)*howmany + k]. (This is the layout of
+   FourierKeyS2Array, so that the shells do not have to be copied.)
+
+   The phi FFTs of all the signals are performed by a single plan. The
+   weighted theta samples of all the orders (below the cut-off), signals
+   and real/imaginary parts are then cosine transformed by a single
+   (DCT-II) plan, rather than by one kFCT call per vector, and for each
+   order m the coefficients of all the signals are projected together by
+   SemiNaiveReduced_fftw_batch. With FST_FAST_LEGENDRE, the degrees
+   from FLT_Start on are computed by FLT_fftw instead, and with
+   FST_NAIVE all of the degrees are computed by Naive_Analysis_fftw_batch,
+   both from the weighted samples.
+
+   FST_semi_memo_fftw_batch_order computes the projections of order m
+   with the given engine, from the weighted samples and their cosine
+   transforms in the workspace (as left by FST_semi_memo_fftw_batch),
+   into the workspace at offset (4 * bw * (bw+1) * howmany) + (4 * bw * bw * howmany).
+   The projections of degree l are at offset (l-m) * (2 * howmany), and
+   it returns the first degree whose projections are plain sums over
+   the samples, without the factor of 2 of the DCT. (This is used to
+   time the engines for each order, see HarmonicTransform.) */
+
+fftw_plan FST_semi_memo_fftw_batch_plan(double *data, double *workspace,
+										int size, int howmany, unsigned flags)
+{
+	fftw_iodim dims,howmany_dims[2];
+	dims.n=size;
+	dims.is=1;
+	dims.os=size;
+	howmany_dims[0].n=size;
+	howmany_dims[0].is=size;
+	howmany_dims[0].os=1;
+	howmany_dims[1].n=howmany;
+	howmany_dims[1].is=size*size;
+	howmany_dims[1].os=(size/2+1)*size;
+	return fftw_plan_guru_dft_r2c(1,&dims,2,howmany_dims,data,(fftw_complex*)workspace,flags);
+}
+fftwf_plan FST_semi_memo_fftw_batch_plan(float *data, float *workspace,
+										 int size, int howmany, unsigned flags)
+{
+	fftw_iodim dims,howmany_dims[2];
+	dims.n=size;
+	dims.is=1;
+	dims.os=size;
+	howmany_dims[0].n=size;
+	howmany_dims[0].is=size;
+	howmany_dims[0].os=1;
+	howmany_dims[1].n=howmany;
+	howmany_dims[1].is=size*size;
+	howmany_dims[1].os=(size/2+1)*size;
+	return fftwf_plan_guru_dft_r2c(1,&dims,2,howmany_dims,data,(fftwf_complex*)workspace,flags);
+}
+fftw_plan FST_semi_memo_fftw_batch_dct_plan(double *workspace,
+										int size, int howmany, int orders, unsigned flags)
+{
+	fftw_iodim dims,howmany_dims[3];
+	fftw_r2r_kind kind=FFTW_REDFT10;
+	int bw=size/2, cols=2*howmany;
+	double *res = workspace;
+	double *cos_data = res + (4 * bw * (bw+1) * howmany);
+
+	/* the real parts of the theta samples are interleaved with the imaginary
+	   ones, and the coefficients are written with the columns innermost
+	   (the samples are preserved for the fast Legendre transform) */
+	dims.n=size;
+	dims.is=2;
+	dims.os=cols;
+	/* real/imaginary part */
+	howmany_dims[0].n=2;
+	howmany_dims[0].is=1;
+	howmany_dims[0].os=1;
+	/* signal */
+	howmany_dims[1].n=howmany;
+	howmany_dims[1].is=4*bw*(bw+1);
+	howmany_dims[1].os=2;
+	/* order (only the ones below the cut-off are transformed) */
+	howmany_dims[2].n=orders;
+	howmany_dims[2].is=2*size;
+	howmany_dims[2].os=size*cols;
+	return fftw_plan_guru_r2r(1,&dims,3,howmany_dims,res,cos_data,&kind,flags|FFTW_PRESERVE_INPUT);
+}
+fftwf_plan FST_semi_memo_fftw_batch_dct_plan(float *workspace,
+										int size, int howmany, int orders, unsigned flags)
+{
+	fftw_iodim dims,howmany_dims[3];
+	fftw_r2r_kind kind=FFTW_REDFT10;
+	int bw=size/2, cols=2*howmany;
+	float *res = workspace;
+	float *cos_data = res + (4 * bw * (bw+1) * howmany);
+
+	/* the real parts of the theta samples are interleaved with the imaginary
+	   ones, and the coefficients are written with the columns innermost
+	   (the samples are preserved for the fast Legendre transform) */
+	dims.n=size;
+	dims.is=2;
+	dims.os=cols;
+	/* real/imaginary part */
+	howmany_dims[0].n=2;
+	howmany_dims[0].is=1;
+	howmany_dims[0].os=1;
+	/* signal */
+	howmany_dims[1].n=howmany;
+	howmany_dims[1].is=4*bw*(bw+1);
+	howmany_dims[1].os=2;
+	/* order (only the ones below the cut-off are transformed) */
+	howmany_dims[2].n=orders;
+	howmany_dims[2].is=2*size;
+	howmany_dims[2].os=size*cols;
+	return fftwf_plan_guru_r2r(1,&dims,3,howmany_dims,res,cos_data,&kind,flags|FFTW_PRESERVE_INPUT);
+}
+int FST_semi_memo_fftw_batch_order(double *workspace,
+								   int size, int howmany, int m, int lim,
+								   int engine,
+								   double **seminaive_naive_table,
+								   double **flt_table, int crossover)
+{
+	int bw, cols, lo;
+	double *res, *cos_data, *result, *ws;
+
+	bw = size/2;
+	cols = 2*howmany;
+	res = workspace;
+	cos_data = res + (4 * bw * (bw+1) * howmany);
+	result = cos_data + (4 * bw * bw * howmany);
+	ws = result + (2 * bw * howmany);
+
+	/* the degrees from lo on are computed from the samples */
+	if (engine == FST_NAIVE)
+		lo = m;
+	else if (engine == FST_FAST_LEGENDRE && flt_table && flt_table[m])
+		lo = FLT_Start(bw, m, crossover);
+	else
+		lo = bw;
+	if (lo > lim)
+		lo = lim;
+
+	/* the real and imaginary parts of all signals at once */
+	if (m < lo)
+		SemiNaiveReduced_fftw_batch(cos_data+(m*size*cols),
+			cols,
+			m,
+			lo,
+			result,
+			seminaive_naive_table[m]);
+	if (lo < lim)
+	{
+		if (engine == FST_NAIVE)
+			Naive_Analysis_fftw_batch(res+(2*m*size),
+				4*bw*(bw+1),
+				howmany,
+				bw,
+				m,
+				lim,
+				result,
+				ws);
+		else
+			FLT_fftw(res+(2*m*size),
+				4*bw*(bw+1),
+				howmany,
+				bw,
+				m,
+				crossover,
+				lim,
+				result,
+				flt_table[m],
+				ws);
+	}
+	return lo;
+}
+static void FST_semi_memo_fftw_batch_load(double *data, fftw_complex **coeffs, fftw_complex *icoeffs,
+										   int size, int howmany, int lim,
+										   double **seminaive_naive_table,
+										   const int *engines,
+										   double **flt_table, int crossover,
+										   double *workspace, fftw_plan plan, fftw_plan dctPlan)
+{
+	int bw, m, i, k, cols, lo;
+	const double *weights;
+	double *res, *cos_data, *result, *dataptr;
+	double scale, tmp, sampleTmp;
+
+	bw = size/2;
+	/* the real and imaginary parts are treated as separate columns */
+	cols = 2*howmany;
+
+	/* assign space */
+	res = workspace;                               /* needs (4 * bw * (bw+1) * howmany) */
+	cos_data = res + (4 * bw * (bw+1) * howmany);  /* needs (4 * bw * bw * howmany) */
+	result = cos_data + (4 * bw * bw * howmany);   /* needs (2 * bw * howmany) */
+	                                               /* the rest needs (4 * bw * howmany) + (24 * bw) */
+
+	/* do the FFTs along phi */
+	fftw_execute_dft_r2c(plan,data,(fftw_complex*)res);
+
+	/* weight the samples in place. The normalizations of the cosine
+	   transform (see SemiNaiveReduced_fftw) are folded into the weights:
+	   with FFTW's REDFT10 both the constant and the other coefficients
+	   are then scaled by bw/size (bw/(2*size) for m=0) */
+	for (m=0; m<bw && m<lim; m++)
+	{
+		weights = (m % 2) ? get_oddweights(bw) : get_weights(bw);
+		scale = (double)( ( m==0 ? bw*0.5 : bw ) / size );
+		for(k=0; k<howmany; k++)
+		{
+			dataptr = res + k*(4*bw*(bw+1)) + 2*m*size;
+			for(i=0; i<size; i++)
+			{
+				tmp = (double)( weights[i] * scale );
+				dataptr[2*i  ] *= tmp;
+				dataptr[2*i+1] *= tmp;
+			}
+		}
+	}
+
+	/* the cosine transforms of all the orders and columns at once */
+	fftw_execute_r2r(dctPlan,res,cos_data);
+
+	/* the interleaved coefficients are stored by degree, so the ones
+	   above the cut-off are contiguous */
+	if (icoeffs && lim < bw)
+		memset(icoeffs + ((lim*lim+lim)/2)*howmany, 0,
+			sizeof(icoeffs[0]) * ((bw*bw+bw)/2 - (lim*lim+lim)/2) * howmany);
+
+	for (m=0; m<bw; m++)
+	{
+		/* the orders above the cut-off have no coefficients to compute */
+		if (m >= lim)
+		{
+			if (!icoeffs)
+				for(k=0; k<howmany; k++)
+					memset(coeffs[k] + seanindex(m,m,bw), 0, sizeof(coeffs[k][0]) * (bw - m));
+			continue;
+		}
+
+		lo = FST_semi_memo_fftw_batch_order(workspace, size, howmany, m, lim,
+			engines ? engines[m] : FST_SEMINAIVE,
+			seminaive_naive_table, flt_table, crossover);
+
+		/* load the normalized coefficients into output space */
+		tmp = double( ( m==0 ? 2. * sqrt( PI ) : sqrt( 2. * PI ) ) / size );
+		/* (the sums over the samples do not include the factor of 2 of the DCT) */
+		sampleTmp = 2 * tmp;
+		if (icoeffs)
+		{
+			for(i=0; i<lim-m; i++)
+			{
+				fftw_complex *cptr = icoeffs + (((m+i)*(m+i+1))/2 + m)*howmany;
+				double *rptr = result + i*cols;
+				double t = i<lo-m ? tmp : sampleTmp;
+				for(k=0; k<howmany; k++)
+				{
+					cptr[k][0] = rptr[2*k  ] * t;
+					cptr[k][1] = rptr[2*k+1] * t;
+				}
+			}
+			continue;
+		}
+		for(k=0; k<howmany; k++)
+		{
+			fftw_complex *cptr = coeffs[k] + seanindex(m,m,bw);
+			for(i=0; i<lo-m; i++)
+			{
+				cptr[i][0] = result[i*cols+2*k  ] * tmp;
+				cptr[i][1] = result[i*cols+2*k+1] * tmp;
+			}
+			for(; i<lim-m; i++)
+			{
+				cptr[i][0] = result[i*cols+2*k  ] * sampleTmp;
+				cptr[i][1] = result[i*cols+2*k+1] * sampleTmp;
+			}
+			for(; i<bw-m; i++)
+				cptr[i][0] = cptr[i][1] = 0;
+		}
+	}
+}
+void FST_semi_memo_fftw_batch(double *data, fftw_complex **coeffs,
+							  int size, int howmany, int lim,
+							  double **seminaive_naive_table,
+							  const int *engines,
+							  double **flt_table, int crossover,
+							  double *workspace, fftw_plan plan, fftw_plan dctPlan)
+{
+	FST_semi_memo_fftw_batch_load(data, coeffs, NULL, size, howmany, lim,
+		seminaive_naive_table, engines, flt_table, crossover,
+		workspace, plan, dctPlan);
+}
+void FST_semi_memo_fftw_batch_interleaved(double *data, fftw_complex *coeffs,
+										  int size, int howmany, int lim,
+										  double **seminaive_naive_table,
+										  const int *engines,
+										  double **flt_table, int crossover,
+										  double *workspace, fftw_plan plan, fftw_plan dctPlan)
+{
+	FST_semi_memo_fftw_batch_load(data, NULL, coeffs, size, howmany, lim,
+		seminaive_naive_table, engines, flt_table, crossover,
+		workspace, plan, dctPlan);
+}
+int FST_semi_memo_fftw_batch_order(float *workspace,
+								   int size, int howmany, int m, int lim,
+								   int engine,
+								   float **seminaive_naive_table,
+								   float **flt_table, int crossover)
+{
+	int bw, cols, lo;
+	float *res, *cos_data, *result, *ws;
+
+	bw = size/2;
+	cols = 2*howmany;
+	res = workspace;
+	cos_data = res + (4 * bw * (bw+1) * howmany);
+	result = cos_data + (4 * bw * bw * howmany);
+	ws = result + (2 * bw * howmany);
+
+	/* the degrees from lo on are computed from the samples */
+	if (engine == FST_NAIVE)
+		lo = m;
+	else if (engine == FST_FAST_LEGENDRE && flt_table && flt_table[m])
+		lo = FLT_Start(bw, m, crossover);
+	else
+		lo = bw;
+	if (lo > lim)
+		lo = lim;
+
+	/* the real and imaginary parts of all signals at once */
+	if (m < lo)
+		SemiNaiveReduced_fftw_batch(cos_data+(m*size*cols),
+			cols,
+			m,
+			lo,
+			result,
+			seminaive_naive_table[m]);
+	if (lo < lim)
+	{
+		if (engine == FST_NAIVE)
+			Naive_Analysis_fftw_batch(res+(2*m*size),
+				4*bw*(bw+1),
+				howmany,
+				bw,
+				m,
+				lim,
+				result,
+				ws);
+		else
+			FLT_fftw(res+(2*m*size),
+				4*bw*(bw+1),
+				howmany,
+				bw,
+				m,
+				crossover,
+				lim,
+				result,
+				flt_table[m],
+				ws);
+	}
+	return lo;
+}
+static void FST_semi_memo_fftw_batch_load(float *data, fftwf_complex **coeffs, fftwf_complex *icoeffs,
+										   int size, int howmany, int lim,
+										   float **seminaive_naive_table,
+										   const int *engines,
+										   float **flt_table, int crossover,
+										   float *workspace, fftwf_plan plan, fftwf_plan dctPlan)
+{
+	int bw, m, i, k, cols, lo;
+	const double *weights;
+	float *res, *cos_data, *result, *dataptr;
+	float scale, tmp, sampleTmp;
+
+	bw = size/2;
+	/* the real and imaginary parts are treated as separate columns */
+	cols = 2*howmany;
+
+	/* assign space */
+	res = workspace;                               /* needs (4 * bw * (bw+1) * howmany) */
+	cos_data = res + (4 * bw * (bw+1) * howmany);  /* needs (4 * bw * bw * howmany) */
+	result = cos_data + (4 * bw * bw * howmany);   /* needs (2 * bw * howmany) */
+	                                               /* the rest needs (4 * bw * howmany) + (24 * bw) */
+
+	/* do the FFTs along phi */
+	fftwf_execute_dft_r2c(plan,data,(fftwf_complex*)res);
+
+	/* weight the samples in place. The normalizations of the cosine
+	   transform (see SemiNaiveReduced_fftw) are folded into the weights:
+	   with FFTW's REDFT10 both the constant and the other coefficients
+	   are then scaled by bw/size (bw/(2*size) for m=0) */
+	for (m=0; m<bw && m<lim; m++)
+	{
+		weights = (m % 2) ? get_oddweights(bw) : get_weights(bw);
+		scale = (float)( ( m==0 ? bw*0.5 : bw ) / size );
+		for(k=0; k<howmany; k++)
+		{
+			dataptr = res + k*(4*bw*(bw+1)) + 2*m*size;
+			for(i=0; i<size; i++)
+			{
+				tmp = (float)( weights[i] * scale );
+				dataptr[2*i  ] *= tmp;
+				dataptr[2*i+1] *= tmp;
+			}
+		}
+	}
+
+	/* the cosine transforms of all the orders and columns at once */
+	fftwf_execute_r2r(dctPlan,res,cos_data);
+
+	/* the interleaved coefficients are stored by degree, so the ones
+	   above the cut-off are contiguous */
+	if (icoeffs && lim < bw)
+		memset(icoeffs + ((lim*lim+lim)/2)*howmany, 0,
+			sizeof(icoeffs[0]) * ((bw*bw+bw)/2 - (lim*lim+lim)/2) * howmany);
+
+	for (m=0; m<bw; m++)
+	{
+		/* the orders above the cut-off have no coefficients to compute */
+		if (m >= lim)
+		{
+			if (!icoeffs)
+				for(k=0; k<howmany; k++)
+					memset(coeffs[k] + seanindex(m,m,bw), 0, sizeof(coeffs[k][0]) * (bw - m));
+			continue;
+		}
+
+		lo = FST_semi_memo_fftw_batch_order(workspace, size, howmany, m, lim,
+			engines ? engines[m] : FST_SEMINAIVE,
+			seminaive_naive_table, flt_table, crossover);
+
+		/* load the normalized coefficients into output space */
+		tmp = float( ( m==0 ? 2. * sqrt( PI ) : sqrt( 2. * PI ) ) / size );
+		/* (the sums over the samples do not include the factor of 2 of the DCT) */
+		sampleTmp = 2 * tmp;
+		if (icoeffs)
+		{
+			for(i=0; i<lim-m; i++)
+			{
+				fftwf_complex *cptr = icoeffs + (((m+i)*(m+i+1))/2 + m)*howmany;
+				float *rptr = result + i*cols;
+				float t = i<lo-m ? tmp : sampleTmp;
+				for(k=0; k<howmany; k++)
+				{
+					cptr[k][0] = rptr[2*k  ] * t;
+					cptr[k][1] = rptr[2*k+1] * t;
+				}
+			}
+			continue;
+		}
+		for(k=0; k<howmany; k++)
+		{
+			fftwf_complex *cptr = coeffs[k] + seanindex(m,m,bw);
+			for(i=0; i<lo-m; i++)
+			{
+				cptr[i][0] = result[i*cols+2*k  ] * tmp;
+				cptr[i][1] = result[i*cols+2*k+1] * tmp;
+			}
+			for(; i<lim-m; i++)
+			{
+				cptr[i][0] = result[i*cols+2*k  ] * sampleTmp;
+				cptr[i][1] = result[i*cols+2*k+1] * sampleTmp;
+			}
+			for(; i<bw-m; i++)
+				cptr[i][0] = cptr[i][1] = 0;
+		}
+	}
+}
+void FST_semi_memo_fftw_batch(float *data, fftwf_complex **coeffs,
+							  int size, int howmany, int lim,
+							  float **seminaive_naive_table,
+							  const int *engines,
+							  float **flt_table, int crossover,
+							  float *workspace, fftwf_plan plan, fftwf_plan dctPlan)
+{
+	FST_semi_memo_fftw_batch_load(data, coeffs, NULL, size, howmany, lim,
+		seminaive_naive_table, engines, flt_table, crossover,
+		workspace, plan, dctPlan);
+}
+void FST_semi_memo_fftw_batch_interleaved(float *data, fftwf_complex *coeffs,
+										  int size, int howmany, int lim,
+										  float **seminaive_naive_table,
+										  const int *engines,
+										  float **flt_table, int crossover,
+										  float *workspace, fftwf_plan plan, fftwf_plan dctPlan)
+{
+	FST_semi_memo_fftw_batch_load(data, NULL, coeffs, size, howmany, lim,
+		seminaive_naive_table, engines, flt_table, crossover,
+		workspace, plan, dctPlan);
+}
 void InvFST_semi_memo_fftw(double *rcoeffs, double *icoeffs, 
 					  double *rdata, 
 					  int size, 
@@ -830,9 +1372,12 @@ void InvFST_semi_memo_fftw(double *rcoeffs, double *icoeffs,
 		dims1.is=dims2.os=size;
 		dims1.os=dims2.is=1;
 		// Generate the FFTW plan
-		fftw_plan plan=fftw_plan_guru_split_dft_c2r(1,&dims1,1,&dims2, rfourdata, ifourdata, rdata,FFTW_ESTIMATE);
+		fftw_plan plan;
+#pragma omp critical (FFTWPlanner)
+		plan=fftw_plan_guru_split_dft_c2r(1,&dims1,1,&dims2, rfourdata, ifourdata, rdata,FFTW_ESTIMATE);
 		// do the FFTs along phi
 		fftw_execute(plan);
+#pragma omp critical (FFTWPlanner)
 		fftw_destroy_plan(plan);
 		/* amscray */
 
@@ -944,9 +1489,12 @@ void InvFST_semi_memo_fftw(float *rcoeffs, float *icoeffs,
 		dims1.is=dims2.os=size;
 		dims1.os=dims2.is=1;
 		// Generate the FFTW plan
-		fftwf_plan plan=fftwf_plan_guru_split_dft_c2r(1,&dims1,1,&dims2, rfourdata, ifourdata, rdata,FFTW_ESTIMATE);
+		fftwf_plan plan;
+#pragma omp critical (FFTWPlanner)
+		plan=fftwf_plan_guru_split_dft_c2r(1,&dims1,1,&dims2, rfourdata, ifourdata, rdata,FFTW_ESTIMATE);
 		// do the FFTs along phi
 		fftwf_execute(plan);
+#pragma omp critical (FFTWPlanner)
 		fftwf_destroy_plan(plan);
 		/* amscray */
 
@@ -0,0 +1,176 @@
+/*
+  FFTW-based versions of kFCT and ExpIFCT, for transform sizes that
+  are not powers of two.
+
+  With FFTW's conventions,
+    REDFT10: Y[i] = 2 * sum_j X[j] * cos(pi*i*(2j+1)/(2n))
+    REDFT01: Y[j] = X[0] + 2 * sum_{i>0} X[i] * cos(pi*i*(2j+1)/(2n))
+  so the (normalized) coefficients of kFCT are Y[0]/(2n) and Y[i]/n,
+  and ExpIFCT is REDFT01 applied to the series with the coefficients
+  past the first halved.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "fftw3.h"
+#include "fftwFCT.h"
+
+/* the plans for one transform size */
+struct fct_plans {
+  int n;
+  fftw_plan dct, idct;
+  fftwf_plan dctf, idctf;
+  struct fct_plans *next;
+};
+
+static struct fct_plans *fct_plans_list = 0;
+
+static struct fct_plans *get_fct_plans( int n )
+{
+  struct fct_plans *p, *head;
+
+  /* read the head between flushes, since it may have just been
+     published by another thread */
+#pragma omp flush
+  head = fct_plans_list;
+#pragma omp flush
+  for ( p = head ; p ; p = p->next )
+    if ( p->n == n )
+      return p;
+
+  /* FFTW's planner is not thread-safe */
+#pragma omp critical (FFTWPlanner)
+  {
+    for ( p = fct_plans_list ; p ; p = p->next )
+      if ( p->n == n )
+	break;
+
+    if ( !p )
+      {
+	double *in, *out;
+	float *inf, *outf;
+
+	in = (double *) fftw_malloc( sizeof(double) * 2 * n );
+	out = in + n;
+	inf = (float *) fftwf_malloc( sizeof(float) * 2 * n );
+	outf = inf + n;
+
+	/* the transforms are executed on (possibly unaligned) workspaces */
+	p = (struct fct_plans *) malloc( sizeof(struct fct_plans) );
+	p->n = n;
+	p->dct = fftw_plan_r2r_1d( n, in, out, FFTW_REDFT10, FFTW_ESTIMATE | FFTW_UNALIGNED );
+	p->idct = fftw_plan_r2r_1d( n, in, out, FFTW_REDFT01, FFTW_ESTIMATE | FFTW_UNALIGNED );
+	p->dctf = fftwf_plan_r2r_1d( n, inf, outf, FFTW_REDFT10, FFTW_ESTIMATE | FFTW_UNALIGNED );
+	p->idctf = fftwf_plan_r2r_1d( n, inf, outf, FFTW_REDFT01, FFTW_ESTIMATE | FFTW_UNALIGNED );
+
+	fftw_free( in );
+	fftwf_free( inf );
+
+	/* only publish the entry once the plans are created and flushed */
+	p->next = fct_plans_list;
+#pragma omp flush
+	fct_plans_list = p;
+#pragma omp flush
+      }
+  }
+  return p;
+}
+
+void Init_fftwFCT( int n )
+{
+  get_fct_plans( n );
+}
+
+/************************************************************************/
+
+void kFCT_fftw( double *data,
+		double *result,
+		double *workspace,
+		int n,
+		int k )
+{
+  struct fct_plans *p = get_fct_plans( n );
+  double *in, *out, dn;
+  int i;
+
+  in = workspace;
+  out = workspace + n;
+
+  /* the plan may overwrite its input */
+  memcpy( in, data, sizeof(double) * n );
+  fftw_execute_r2r( p->dct, in, out );
+
+  dn = 1.0 / ((double) n);
+  result[0] = out[0] * dn * 0.5;
+  for ( i = 1 ; i < k ; i ++ )
+    result[i] = out[i] * dn;
+}
+
+void kFCT_fftw( float *data,
+		float *result,
+		float *workspace,
+		int n,
+		int k )
+{
+  struct fct_plans *p = get_fct_plans( n );
+  float *in, *out, dn;
+  int i;
+
+  in = workspace;
+  out = workspace + n;
+
+  memcpy( in, data, sizeof(float) * n );
+  fftwf_execute_r2r( p->dctf, in, out );
+
+  dn = (float) ( 1.0 / ((double) n) );
+  result[0] = out[0] * dn * 0.5f;
+  for ( i = 1 ; i < k ; i ++ )
+    result[i] = out[i] * dn;
+}
+
+void ExpIFCT_fftw( double *data,
+		   double *result,
+		   double *workspace,
+		   int n,
+		   int k )
+{
+  struct fct_plans *p = get_fct_plans( n );
+  double *in, *out;
+  int i;
+
+  in = workspace;
+  out = workspace + n;
+
+  in[0] = data[0];
+  for ( i = 1 ; i < k ; i ++ )
+    in[i] = data[i] * 0.5;
+  for ( ; i < n ; i ++ )
+    in[i] = 0.0;
+
+  fftw_execute_r2r( p->idct, in, out );
+  memcpy( result, out, sizeof(double) * n );
+}
+
+void ExpIFCT_fftw( float *data,
+		   float *result,
+		   float *workspace,
+		   int n,
+		   int k )
+{
+  struct fct_plans *p = get_fct_plans( n );
+  float *in, *out;
+  int i;
+
+  in = workspace;
+  out = workspace + n;
+
+  in[0] = data[0];
+  for ( i = 1 ; i < k ; i ++ )
+    in[i] = data[i] * 0.5f;
+  for ( ; i < n ; i ++ )
+    in[i] = 0.0f;
+
+  fftwf_execute_r2r( p->idctf, in, out );
+  memcpy( result, out, sizeof(float) * n );
+}
@@ -45,6 +45,7 @@
 */
 
 
+#include <float.h>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -879,3 +880,141 @@ void Naive_SynthesizeX(double *coeffs,
 
 
 }
+
+/************************************************************************/
+/* Batched naive analysis, used by FST_semi_memo_fftw_batch for the
+   orders where it is faster than the seminaive transform (it needs no
+   precomputed data, and no cosine transform of the samples).
+
+   The projections onto P(m,l) of the real and imaginary parts of
+   howmany complex signals are computed by running the recurrence at
+   the sample nodes. Since P(m,l)(-x) = (-1)^(l-m) P(m,l)(x), the
+   samples at x and -x are first folded into their sum and difference,
+   so the recurrence and the sums only run over half of the nodes. The
+   nodes near the poles, where P(m,m) is below the smallest normalized
+   number, are skipped (they stay negligible for all degrees).
+
+   data - the (interleaved) weighted complex samples, with signal k
+          starting at data + k*signalStride (the 2*bw samples of a
+          signal are consecutive). For odd m, the P(m,l) are divided
+          by sin, as in the cospml tables, so the data is expected to
+          be weighted with the odd weights.
+   lim - only the coefficients of degree l < lim are computed (lim<=bw)
+   result - the projection onto P(m,m+i) of the real and imaginary parts
+            of signal k are written to result[2*(i*howmany+k)] and
+            result[2*(i*howmany+k)+1]
+   workspace - needs (4 * bw * howmany) + (3 * bw)
+
+   As with FLT_fftw, the projections are the sums of the samples times
+   P(m,l) at the Chebyshev nodes (without the normalizations of the
+   seminaive transform).
+*/
+
+template< class Real >
+static void _Naive_Analysis_fftw_batch( Real *data,
+					int signalStride,
+					int howmany,
+					int bw,
+					int m,
+					int lim,
+					Real *result,
+					Real *workspace,
+					double tiny )
+{
+  int n, cols, i, j, k, l, j0;
+  Real *even, *odd, *x, *p0, *p1, *fold, *res;
+  const Real *signal;
+  Real an, cn, p, t;
+  double md, id, mcons, theta, pmm;
+
+  n = 2*bw;
+  cols = 2*howmany;
+
+  /* assign workspace */
+  even = workspace;                  /* needs (2 * bw * howmany) */
+  odd = even + (bw * cols);          /* needs (2 * bw * howmany) */
+  x = odd + (bw * cols);             /* needs (bw) */
+  p0 = x + bw;                       /* needs (bw) */
+  p1 = p0 + bw;                      /* needs (bw) */
+
+  /* the norming constant of Pmm (see ns_Pmm_L2) */
+  id = 0.0;
+  md = (double) m;
+  mcons = sqrt(md + 0.5);
+  for ( i = 0 ; i < m ; i ++ )
+    {
+      mcons *= sqrt((md-(id/2.0))/(md-id));
+      id += 1.0;
+    }
+  if ( m != 0 )
+    mcons *= pow(2.0,-md/2.0);
+  if ( (m % 2) != 0 )
+    mcons *= -1.0;
+
+  /* P(m,m-1) = 0 and P(m,m) at the nodes of the first half */
+  j0 = bw;
+  for ( j = bw - 1 ; j >= 0 ; j -- )
+    {
+      theta = ((2.0*j+1.0) * PI) / ((double) (2*n));
+      if ( m == 0 )
+	pmm = 1.0;
+      else
+	pmm = mcons * pow(sin(theta), md);
+      if ( (m % 2) == 1 )
+	pmm /= sin(theta);
+      if ( fabs(pmm) < tiny )
+	break;
+      x[j] = (Real) cos(theta);
+      p0[j] = 0;
+      p1[j] = (Real) pmm;
+      j0 = j;
+    }
+
+  /* fold the samples, with the columns innermost */
+  for ( k = 0 ; k < cols ; k ++ )
+    {
+      signal = data + (k/2)*signalStride + (k%2);
+      for ( j = j0 ; j < bw ; j ++ )
+	{
+	  even[j*cols+k] = signal[2*j] + signal[2*(n-1-j)];
+	  odd[j*cols+k] = signal[2*j] - signal[2*(n-1-j)];
+	}
+    }
+
+  for ( l = m ; l < lim ; l ++ )
+    {
+      res = result + (l-m)*cols;
+      for ( k = 0 ; k < cols ; k ++ )
+	res[k] = 0;
+
+      /* p1 holds P(m,l) */
+      fold = ( (l-m) % 2 ) ? odd : even;
+      for ( j = j0 ; j < bw ; j ++ )
+	{
+	  p = p1[j];
+	  for ( k = 0 ; k < cols ; k ++ )
+	    res[k] += p * fold[j*cols+k];
+	}
+
+      if ( l + 1 < lim )
+	{
+	  an = (Real) ns_L2_an(m, l);
+	  cn = (Real) ns_L2_cn(m, l);
+	  for ( j = j0 ; j < bw ; j ++ )
+	    {
+	      t = an * x[j] * p1[j] + cn * p0[j];
+	      p0[j] = p1[j];
+	      p1[j] = t;
+	    }
+	}
+    }
+}
+
+void Naive_Analysis_fftw_batch( double *data, int signalStride, int howmany, int bw, int m, int lim, double *result, double *workspace )
+{
+  _Naive_Analysis_fftw_batch( data, signalStride, howmany, bw, m, lim, result, workspace, DBL_MIN );
+}
+void Naive_Analysis_fftw_batch( float *data, int signalStride, int howmany, int bw, int m, int lim, float *result, float *workspace )
+{
+  _Naive_Analysis_fftw_batch( data, signalStride, howmany, bw, m, lim, result, workspace, FLT_MIN );
+}
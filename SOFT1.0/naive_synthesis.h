@@ -87,5 +87,22 @@ extern void Naive_Analysis_TimingX( double *,
 				    int ,
 				    double *);
 
+extern void Naive_Analysis_fftw_batch( double * ,
+				       int ,
+				       int ,
+				       int ,
+				       int ,
+				       int ,
+				       double * ,
+				       double * ) ;
+extern void Naive_Analysis_fftw_batch( float * ,
+				       int ,
+				       int ,
+				       int ,
+				       int ,
+				       int ,
+				       float * ,
+				       float * ) ;
+
 #endif /* _NAIVE_SYNTHESIS_H */
 
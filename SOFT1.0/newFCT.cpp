@@ -172,6 +172,7 @@
 #include "OURperms.h"
 #include "OURmods.h"
 #include "newFCT.h"
+#include "fftwFCT.h"
 
 
 /************************************************************************
@@ -456,6 +457,13 @@ void kFCT(double *data,
     double modptr0;
     double e0, e1, f0, f1;
 
+    /* the moduli are only tabulated for powers of two */
+    if ( (n & (n-1)) || (k & (k-1)) )
+      {
+        kFCT_fftw(data, result, workspace, n, k);
+        return;
+      }
+
     lowpoly = workspace; 
     lowptr = lowpoly;
     highpoly = workspace + n; 
@@ -591,6 +599,13 @@ void kFCT(float *data,
 	double modptr0;
 	float e0, e1, f0, f1;
 
+	/* the moduli are only tabulated for powers of two */
+	if ( (n & (n-1)) || (k & (k-1)) )
+	  {
+	    kFCT_fftw(data, result, workspace, n, k);
+	    return;
+	  }
+
 	lowpoly = workspace; 
 	lowptr = lowpoly;
 	highpoly = workspace + n; 
@@ -1113,6 +1128,13 @@ void ExpIFCT( double *data,
   double divptr0, divptr1, divptr2, divptr3;
   double tmpmod, tmpmod2;
 
+  /* the moduli are only tabulated for powers of two */
+  if ( (n & (n-1)) || (k & (k-1)) )
+    {
+      ExpIFCT_fftw(data, result, workspace, n, k);
+      return;
+    }
+
   /* assign workspace locations */
   remres = workspace;
   dividend = workspace + n;
@@ -1275,6 +1297,13 @@ void ExpIFCT( float *data,
 	float divptr0, divptr1, divptr2, divptr3;
 	double tmpmod, tmpmod2;
 
+	/* the moduli are only tabulated for powers of two */
+	if ( (n & (n-1)) || (k & (k-1)) )
+	  {
+	    ExpIFCT_fftw(data, result, workspace, n, k);
+	    return;
+	  }
+
 	/* assign workspace locations */
 	remres = workspace;
 	dividend = workspace + n;
@@ -37,6 +37,9 @@
   ************************************************************************/
 
 
+#include "weights.h"
+#include "oddweights.h"
+
 /* quadrature weights file */
 
 
@@ -1116,6 +1119,6 @@ const double *get_oddweights( int bw )
     case 256: return ow256;
     case 512: return ow512;
     case 1024: return ow1024;
-    default: return 0;
+    default: return bw > 0 ? get_computed_weights(bw) + 2*bw : 0;
     }
 }
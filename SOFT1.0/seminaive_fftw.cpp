@@ -79,6 +79,7 @@
 #include "newFCT.h"
 #include "oddweights.h"
 #include "weights.h"
+#include "seminaive_simd.h"
 
 
 /********************************************************************
@@ -167,7 +168,7 @@ void SemiNaiveReduced_fftw(double *data,
 						   double *workspace,
 						   double *cos_even)
 {
-	int i, j, n;
+	int i, n;
 	const double *weights;
 	double *weighted_data;
 	double *cos_data;
@@ -175,10 +176,6 @@ void SemiNaiveReduced_fftw(double *data,
 
 	double *cos_odd;
 
-	double eresult0, eresult1, eresult2, eresult3;
-	double oresult0, oresult1;  
-	double *pml_ptr_even, *pml_ptr_odd;
-
 	int ctr;
 	double d_bw;
 
@@ -241,63 +238,9 @@ void SemiNaiveReduced_fftw(double *data,
 	/*
 	do the projections; Note that the cos_pml_table has
 	had all the zeroes stripped out so the indexing is
-	complicated somewhat
-	*/
-	/*
-	this loop is unrolled to compute two coefficients
-	at a time (for efficiency)
+	complicated somewhat (see seminaive_simd.cpp)
 	*/
-
-	for(i = 0; i < (bw - m) - ( (bw - m) % 2 ); i += 2)
-	{
-		/* get ptrs to precomputed data */
-		pml_ptr_even = cos_pml_table + NewTableOffset(m, m + i);
-		pml_ptr_odd  = cos_pml_table + NewTableOffset(m, m + i + 1);
-
-		eresult0 = 0.0; eresult1 = 0.0;
-		oresult0 = 0.0; oresult1 = 0.0;
-
-		for(j = 0; j < (((m + i)/2) + 1) % 2; ++j)
-		{
-			eresult0 += cos_even[j] * pml_ptr_even[j];
-			oresult0 += cos_odd[j] * pml_ptr_odd[j];
-		}
-		for( ;  j < ((m + i)/2) + 1; j += 2)
-		{
-			eresult0 += cos_even[j] * pml_ptr_even[j];
-			eresult1 += cos_even[j + 1] * pml_ptr_even[j + 1];
-			oresult0 += cos_odd[j] * pml_ptr_odd[j];
-			oresult1 += cos_odd[j + 1] * pml_ptr_odd[j + 1];
-		}
-
-		/* save the result */
-		result[2*i] = eresult0 + eresult1;
-		result[2*(i + 1)] = oresult0 + oresult1;
-	}
-
-	/* if there are an odd number of coefficients to compute
-	at this order, get that last coefficient! */
-	if( ( (bw - m) % 2 ) == 1)
-	{
-		pml_ptr_even = cos_pml_table + NewTableOffset(m, bw - 1);
-
-		eresult0 = 0.0; eresult1 = 0.0;
-		eresult2 = 0.0; eresult3 = 0.0;
-
-		for(j = 0; j < (((bw - 1)/2) + 1) % 4; ++j)
-		{
-			eresult0 += cos_even[j] * pml_ptr_even[j];
-		}
-
-		for( ;  j < ((bw - 1)/2) + 1; j += 4)
-		{
-			eresult0 += cos_even[j] * pml_ptr_even[j];
-			eresult1 += cos_even[j + 1] * pml_ptr_even[j + 1];
-			eresult2 += cos_even[j + 2] * pml_ptr_even[j + 2];
-			eresult3 += cos_even[j + 3] * pml_ptr_even[j + 3];
-		}
-		result[(bw - m - 1)*2] = eresult0 + eresult1 + eresult2 + eresult3;
-	}
+	SemiNaiveProject(cos_even, cos_odd, 0, 1, bw, m, cos_pml_table, result, 2);
 }
 
 
@@ -310,7 +253,7 @@ void SemiNaiveReduced_fftw(float *data,
 						   float *workspace,
 						   float *cos_even)
 {
-	int i, j, n;
+	int i, n;
 	const double *weights;
 	float *weighted_data;
 	float *cos_data;
@@ -318,10 +261,6 @@ void SemiNaiveReduced_fftw(float *data,
 
 	float *cos_odd;
 
-	float eresult0, eresult1, eresult2, eresult3;
-	float oresult0, oresult1;  
-	float *pml_ptr_even, *pml_ptr_odd;
-
 	int ctr;
 	float d_bw;
 
@@ -384,63 +323,9 @@ void SemiNaiveReduced_fftw(float *data,
 	/*
 	do the projections; Note that the cos_pml_table has
 	had all the zeroes stripped out so the indexing is
-	complicated somewhat
+	complicated somewhat (see seminaive_simd.cpp)
 	*/
-	/*
-	this loop is unrolled to compute two coefficients
-	at a time (for efficiency)
-	*/
-
-	for(i = 0; i < (bw - m) - ( (bw - m) % 2 ); i += 2)
-	{
-		/* get ptrs to precomputed data */
-		pml_ptr_even = cos_pml_table + NewTableOffset(m, m + i);
-		pml_ptr_odd  = cos_pml_table + NewTableOffset(m, m + i + 1);
-
-		eresult0 = 0.0; eresult1 = 0.0;
-		oresult0 = 0.0; oresult1 = 0.0;
-
-		for(j = 0; j < (((m + i)/2) + 1) % 2; ++j)
-		{
-			eresult0 += cos_even[j] * pml_ptr_even[j];
-			oresult0 += cos_odd[j] * pml_ptr_odd[j];
-		}
-		for( ;  j < ((m + i)/2) + 1; j += 2)
-		{
-			eresult0 += cos_even[j] * pml_ptr_even[j];
-			eresult1 += cos_even[j + 1] * pml_ptr_even[j + 1];
-			oresult0 += cos_odd[j] * pml_ptr_odd[j];
-			oresult1 += cos_odd[j + 1] * pml_ptr_odd[j + 1];
-		}
-
-		/* save the result */
-		result[2*i] = eresult0 + eresult1;
-		result[2*(i + 1)] = oresult0 + oresult1;
-	}
-
-	/* if there are an odd number of coefficients to compute
-	at this order, get that last coefficient! */
-	if( ( (bw - m) % 2 ) == 1)
-	{
-		pml_ptr_even = cos_pml_table + NewTableOffset(m, bw - 1);
-
-		eresult0 = 0.0; eresult1 = 0.0;
-		eresult2 = 0.0; eresult3 = 0.0;
-
-		for(j = 0; j < (((bw - 1)/2) + 1) % 4; ++j)
-		{
-			eresult0 += cos_even[j] * pml_ptr_even[j];
-		}
-
-		for( ;  j < ((bw - 1)/2) + 1; j += 4)
-		{
-			eresult0 += cos_even[j] * pml_ptr_even[j];
-			eresult1 += cos_even[j + 1] * pml_ptr_even[j + 1];
-			eresult2 += cos_even[j + 2] * pml_ptr_even[j + 2];
-			eresult3 += cos_even[j + 3] * pml_ptr_even[j + 3];
-		}
-		result[(bw - m - 1)*2] = eresult0 + eresult1 + eresult2 + eresult3;
-	}
+	SemiNaiveProject(cos_even, cos_odd, 0, 1, bw, m, cos_pml_table, result, 2);
 }
 void InvSemiNaiveReduced_fftw(double *assoc_legendre_series, 
 							  int bw, 
@@ -699,3 +584,220 @@ void InvSemiNaiveReduced_fftw(float *assoc_legendre_series,
 	/* amscray */
 
 }
+
+/************************************************************************/
+/* SemiNaiveReduced_fftw_batch computes the order m Legendre transforms
+   of cols signals at once (e.g. the real and imaginary parts of several
+   complex signals), given their cosine coefficients. The projections
+   onto the cos_pml_table rows are done as a matrix-matrix product over
+   blocks of columns, so that each row of the table is read once per
+   block rather than once per signal.
+
+   cos_data - the cosine coefficients of the weighted data, already
+              scaled (i.e. including the factors applied after the kFCT
+              in SemiNaiveReduced_fftw); coefficient i of column c is
+              cos_data[i*cols+c]
+   cols - the number of columns
+   lim - only the coefficients of degree l < lim are computed (lim<=bw)
+   result - the coefficient of P(m,m+i) for column c is written to
+            result[i*cols+c] (i<lim-m)
+
+   Otherwise the arguments are as in SemiNaiveReduced_fftw. Since the
+   cosine transforms are done by the caller, all of them can be computed
+   by a single (batched) FFTW plan, see FST_semi_memo_fftw_batch.
+*/
+
+#define BATCH_BLOCK_SIZE 32
+
+template< class Real >
+static void _SemiNaiveReduced_fftw_batch( Real *cos_data,
+										 int cols,
+										 int m,
+										 int lim,
+										 Real *result,
+										 Real *cos_pml_table )
+{
+	int i, j, k, k0, blockSize, length;
+	Real *pml_ptr, *cos_ptr, *res_ptr;
+	Real acc[BATCH_BLOCK_SIZE];
+
+	for( k0=0 ; k0<cols ; k0+=BATCH_BLOCK_SIZE )
+	{
+		blockSize = cols-k0 < BATCH_BLOCK_SIZE ? cols-k0 : BATCH_BLOCK_SIZE;
+
+		for( i=0 ; i<lim-m ; i++ )
+		{
+			/* rows of even (odd) relative degree use the even (odd) indexed coefficients */
+			pml_ptr = cos_pml_table + NewTableOffset(m, m + i);
+			cos_ptr = cos_data + (i%2)*cols + k0;
+			length = RowSize(m, m + i);
+
+			for( k=0 ; k<BATCH_BLOCK_SIZE ; k++ ) acc[k] = 0;
+			if( blockSize==BATCH_BLOCK_SIZE )
+				/* (a fixed trip count, so that the compiler can unroll/vectorize) */
+				for( j=0 ; j<length ; j++ )
+				{
+					Real p = pml_ptr[j];
+					Real *c = cos_ptr + 2*j*cols;
+					for( k=0 ; k<BATCH_BLOCK_SIZE ; k++ ) acc[k] += p * c[k];
+				}
+			else
+				for( j=0 ; j<length ; j++ )
+				{
+					Real p = pml_ptr[j];
+					Real *c = cos_ptr + 2*j*cols;
+					for( k=0 ; k<blockSize ; k++ ) acc[k] += p * c[k];
+				}
+
+			res_ptr = result + i*cols + k0;
+			for( k=0 ; k<blockSize ; k++ ) res_ptr[k] = acc[k];
+		}
+	}
+}
+#undef BATCH_BLOCK_SIZE
+
+void SemiNaiveReduced_fftw_batch(double *cos_data, int cols, int m, int lim, double *result, double *cos_pml_table)
+{
+	_SemiNaiveReduced_fftw_batch(cos_data, cols, m, lim, result, cos_pml_table);
+}
+void SemiNaiveReduced_fftw_batch(float *cos_data, int cols, int m, int lim, float *result, float *cos_pml_table)
+{
+	_SemiNaiveReduced_fftw_batch(cos_data, cols, m, lim, result, cos_pml_table);
+}
+
+/************************************************************************/
+/* SemiNaiveReduced_fftw_cx and InvSemiNaiveReduced_fftw_cx are the
+   complex counterparts of SemiNaiveReduced_fftw and
+   InvSemiNaiveReduced_fftw: the real and imaginary parts of the
+   (interleaved) input are transformed together, so that each row of
+   the (transposed) cospml table is traversed once for both of them.
+
+   SemiNaiveReduced_fftw_cx:
+   data - the interleaved real and imaginary samples (as
+          in SemiNaiveReduced_fftw, the real part of the i-th
+	  sample is data[2*i])
+   result - the interleaved real and imaginary coefficients
+   workspace - of size (10 * bw) + 2
+
+   InvSemiNaiveReduced_fftw_cx:
+   assoc_legendre_series - the interleaved real and imaginary
+                           coefficients
+   result - the (2*bw) samples of the real part, followed by
+            the (2*bw) samples of the imaginary part
+   workspace - of size (10 * bw)
+*/
+
+template< class Real >
+static void _SemiNaiveReduced_fftw_cx( Real *data,
+									  int bw,
+									  int m,
+									  Real *result,
+									  Real *cos_pml_table,
+									  Real *workspace )
+{
+	int i, c, n, half;
+	const double *weights;
+	Real *weighted_data, *cos_data, *scratchpad;
+	Real *cos_even, *cos_odd;
+	Real scale;
+
+	n = 2*bw;
+	half = (bw+1)/2;
+
+	/* assign workspace */
+	weighted_data = workspace;
+	cos_data = weighted_data + (2*bw);
+	scratchpad = cos_data + (2*bw);     /* needs (4*bw) */
+	cos_even = scratchpad + (4*bw);     /* needs (2*half) */
+	cos_odd = cos_even + (2*half);      /* needs (2*half) */
+	/* total workspace = (8 * bw) + (4 * half) <= (10 * bw) + 2 */
+
+	if( (m % 2) == 0)
+		weights = get_weights(bw);
+	else
+		weights = get_oddweights(bw);
+
+	scale = (Real)( m==0 ? bw*0.5 : bw );
+
+	/* weight and cosine-transform the real and imaginary parts */
+	for( c=0 ; c<2 ; c++ )
+	{
+		for( i=0 ; i<n ; i++ )
+			weighted_data[i] = (Real)( data[2*i+c] * weights[i] );
+
+		kFCT(weighted_data, cos_data, scratchpad, n, bw, 1);
+
+		for( i=0 ; i<bw ; i++ )
+			cos_data[i] *= scale;
+		cos_data[0] *= 2;
+
+		for( i=0 ; i<half ; i++ )
+		{
+			cos_even[c*half+i] = cos_data[2*i  ];
+			cos_odd [c*half+i] = cos_data[2*i+1];
+		}
+	}
+
+	/* and project both onto the table rows at once */
+	SemiNaiveProject(cos_even, cos_odd, half, 2, bw, m, cos_pml_table, result, 2);
+}
+
+template< class Real >
+static void _InvSemiNaiveReduced_fftw_cx( Real *assoc_legendre_series,
+										 int bw,
+										 int m,
+										 Real *result,
+										 Real *trans_cos_pml_table,
+										 Real *sin_values,
+										 Real *workspace )
+{
+	int i, j, c, n, half;
+	Real *fcos, *scratchpad;
+	Real *even_series, *odd_series;
+
+	n = 2*bw;
+	half = (bw-m+1)/2;
+
+	fcos = workspace;                   /* needs (2*bw) */
+	scratchpad = fcos + (2*bw);         /* needs (4*bw) */
+	even_series = scratchpad + (4*bw);  /* needs (2*half) */
+	odd_series = even_series + (2*half);/* needs (2*half) */
+	/* total workspace <= (10 * bw) */
+
+	/* split the coefficients by the parity of the degree, so that
+	   the ones multiplying a row of the transposed table are contiguous */
+	for( c=0 ; c<2 ; c++ )
+		for( i=0 ; i<bw-m ; i++ )
+			if( (i%2)==0 ) even_series[c*half+i/2] = assoc_legendre_series[2*i+c];
+			else           odd_series [c*half+i/2] = assoc_legendre_series[2*i+c];
+
+	InvSemiNaiveProject(even_series, odd_series, half, 2, bw, m, trans_cos_pml_table, fcos, bw);
+
+	/* evaluate the cosine series at the Chebyshev nodes */
+	for( c=0 ; c<2 ; c++ )
+	{
+		ExpIFCT(fcos+c*bw, result+c*n, scratchpad, n, bw, 1);
+
+		/* if m is odd, then need to multiply by sin(x) at Chebyshev nodes */
+		if( (m % 2) == 1 )
+			for( j=0 ; j<n ; j++ )
+				result[c*n+j] *= sin_values[j];
+	}
+}
+
+void SemiNaiveReduced_fftw_cx(double *data, int bw, int m, double *result, double *cos_pml_table, double *workspace)
+{
+	_SemiNaiveReduced_fftw_cx(data, bw, m, result, cos_pml_table, workspace);
+}
+void SemiNaiveReduced_fftw_cx(float *data, int bw, int m, float *result, float *cos_pml_table, float *workspace)
+{
+	_SemiNaiveReduced_fftw_cx(data, bw, m, result, cos_pml_table, workspace);
+}
+void InvSemiNaiveReduced_fftw_cx(double *assoc_legendre_series, int bw, int m, double *result, double *trans_cos_pml_table, double *sin_values, double *workspace)
+{
+	_InvSemiNaiveReduced_fftw_cx(assoc_legendre_series, bw, m, result, trans_cos_pml_table, sin_values, workspace);
+}
+void InvSemiNaiveReduced_fftw_cx(float *assoc_legendre_series, int bw, int m, float *result, float *trans_cos_pml_table, float *sin_values, float *workspace)
+{
+	_InvSemiNaiveReduced_fftw_cx(assoc_legendre_series, bw, m, result, trans_cos_pml_table, sin_values, workspace);
+}
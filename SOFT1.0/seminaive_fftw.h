@@ -70,4 +70,45 @@ extern void InvSemiNaiveReduced_fftw( float * ,
 				 float * ,
 				 float * ) ;
 
+extern void SemiNaiveReduced_fftw_batch( double * ,
+				    int ,
+				    int ,
+				    int ,
+				    double * ,
+				    double * ) ;
+extern void SemiNaiveReduced_fftw_batch( float * ,
+				    int ,
+				    int ,
+				    int ,
+				    float * ,
+				    float * ) ;
+
+extern void SemiNaiveReduced_fftw_cx( double * ,
+				 int ,
+				 int ,
+				 double * ,
+				 double * ,
+				 double * ) ;
+extern void SemiNaiveReduced_fftw_cx( float * ,
+				 int ,
+				 int ,
+				 float * ,
+				 float * ,
+				 float * ) ;
+
+extern void InvSemiNaiveReduced_fftw_cx( double * ,
+				    int ,
+				    int ,
+				    double * ,
+				    double * ,
+				    double * ,
+				    double * ) ;
+extern void InvSemiNaiveReduced_fftw_cx( float * ,
+				    int ,
+				    int ,
+				    float * ,
+				    float * ,
+				    float * ,
+				    float * ) ;
+
 #endif /* _SEMINAIVE_FFTW_H */
@@ -0,0 +1,328 @@
+/*
+  SIMD (AVX2/AVX-512) kernels for the projections in the seminaive
+  Legendre transforms, with runtime dispatch.
+
+  The kernels themselves are in seminaive_simd_kernels.h, and are
+  compiled once per instruction set. The intrinsics are enabled with
+  function attributes (gcc/clang) rather than compiler flags, so that
+  the rest of the library does not require the instruction sets and
+  the choice can be made at runtime.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "cospmls.h"
+#include "seminaive_simd.h"
+
+#if defined( _M_X64 ) || defined( _M_IX86 ) || defined( __x86_64__ ) || defined( __i386__ )
+#define SEMINAIVE_SIMD 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#else
+#define SEMINAIVE_SIMD 0
+#endif
+
+/* AVX-512 intrinsics (e.g. the reductions) need a recent compiler */
+#if SEMINAIVE_SIMD && ( defined( __GNUC__ ) || ( defined( _MSC_VER ) && _MSC_VER >= 1911 ) )
+#define SEMINAIVE_AVX512 1
+#else
+#define SEMINAIVE_AVX512 0
+#endif
+
+#if defined( __GNUC__ )
+#define SEMINAIVE_TARGET_AVX2   __attribute__(( target( "avx2,fma" ) ))
+#define SEMINAIVE_TARGET_AVX512 __attribute__(( target( "avx512f,avx2,fma" ) ))
+#else
+#define SEMINAIVE_TARGET_AVX2
+#define SEMINAIVE_TARGET_AVX512
+#endif
+
+/************************************************************************/
+/* scalar */
+
+namespace SemiNaiveScalar
+{
+  template< class _Real >
+    struct Ops
+    {
+      typedef _Real Real;
+      typedef _Real Vector;
+      enum { Size = 1 };
+      static inline Vector Zero( void ){ return 0; }
+      static inline Vector Load( const Real *p ){ return *p; }
+      static inline Vector MulAdd( Vector a, Vector b, Vector c ){ return a*b + c; }
+      static inline Real Sum( Vector v ){ return v; }
+    };
+  typedef Ops< double > DoubleOps;
+  typedef Ops< float > FloatOps;
+
+#define SIMD_TARGET
+#include "seminaive_simd_kernels.h"
+#undef SIMD_TARGET
+}
+
+#if SEMINAIVE_SIMD
+/************************************************************************/
+/* AVX2 + FMA */
+
+namespace SemiNaiveAVX2
+{
+  struct DoubleOps
+  {
+    typedef double Real;
+    typedef __m256d Vector;
+    enum { Size = 4 };
+    SEMINAIVE_TARGET_AVX2 static inline Vector Zero( void ){ return _mm256_setzero_pd( ); }
+    SEMINAIVE_TARGET_AVX2 static inline Vector Load( const Real *p ){ return _mm256_loadu_pd( p ); }
+    SEMINAIVE_TARGET_AVX2 static inline Vector MulAdd( Vector a, Vector b, Vector c ){ return _mm256_fmadd_pd( a, b, c ); }
+    SEMINAIVE_TARGET_AVX2 static inline Real Sum( Vector v )
+    {
+      __m128d s = _mm_add_pd( _mm256_castpd256_pd128( v ), _mm256_extractf128_pd( v, 1 ) );
+      s = _mm_add_sd( s, _mm_unpackhi_pd( s, s ) );
+      return _mm_cvtsd_f64( s );
+    }
+  };
+  struct FloatOps
+  {
+    typedef float Real;
+    typedef __m256 Vector;
+    enum { Size = 8 };
+    SEMINAIVE_TARGET_AVX2 static inline Vector Zero( void ){ return _mm256_setzero_ps( ); }
+    SEMINAIVE_TARGET_AVX2 static inline Vector Load( const Real *p ){ return _mm256_loadu_ps( p ); }
+    SEMINAIVE_TARGET_AVX2 static inline Vector MulAdd( Vector a, Vector b, Vector c ){ return _mm256_fmadd_ps( a, b, c ); }
+    SEMINAIVE_TARGET_AVX2 static inline Real Sum( Vector v )
+    {
+      __m128 s = _mm_add_ps( _mm256_castps256_ps128( v ), _mm256_extractf128_ps( v, 1 ) );
+      s = _mm_add_ps( s, _mm_movehl_ps( s, s ) );
+      s = _mm_add_ss( s, _mm_shuffle_ps( s, s, 1 ) );
+      return _mm_cvtss_f32( s );
+    }
+  };
+
+#define SIMD_TARGET SEMINAIVE_TARGET_AVX2
+#include "seminaive_simd_kernels.h"
+#undef SIMD_TARGET
+}
+#endif /* SEMINAIVE_SIMD */
+
+#if SEMINAIVE_AVX512
+/************************************************************************/
+/* AVX-512 */
+
+namespace SemiNaiveAVX512
+{
+  struct DoubleOps
+  {
+    typedef double Real;
+    typedef __m512d Vector;
+    enum { Size = 8 };
+    SEMINAIVE_TARGET_AVX512 static inline Vector Zero( void ){ return _mm512_setzero_pd( ); }
+    SEMINAIVE_TARGET_AVX512 static inline Vector Load( const Real *p ){ return _mm512_loadu_pd( p ); }
+    SEMINAIVE_TARGET_AVX512 static inline Vector MulAdd( Vector a, Vector b, Vector c ){ return _mm512_fmadd_pd( a, b, c ); }
+    SEMINAIVE_TARGET_AVX512 static inline Real Sum( Vector v ){ return _mm512_reduce_add_pd( v ); }
+  };
+  struct FloatOps
+  {
+    typedef float Real;
+    typedef __m512 Vector;
+    enum { Size = 16 };
+    SEMINAIVE_TARGET_AVX512 static inline Vector Zero( void ){ return _mm512_setzero_ps( ); }
+    SEMINAIVE_TARGET_AVX512 static inline Vector Load( const Real *p ){ return _mm512_loadu_ps( p ); }
+    SEMINAIVE_TARGET_AVX512 static inline Vector MulAdd( Vector a, Vector b, Vector c ){ return _mm512_fmadd_ps( a, b, c ); }
+    SEMINAIVE_TARGET_AVX512 static inline Real Sum( Vector v ){ return _mm512_reduce_add_ps( v ); }
+  };
+
+#define SIMD_TARGET SEMINAIVE_TARGET_AVX512
+#include "seminaive_simd_kernels.h"
+#undef SIMD_TARGET
+}
+#endif /* SEMINAIVE_AVX512 */
+
+/************************************************************************/
+/* runtime dispatch */
+
+/* the instruction sets supported by the processor (and the OS) */
+static int SupportedSIMDLevel( void )
+{
+#if SEMINAIVE_SIMD
+#if defined( _MSC_VER )
+  int info[4];
+  unsigned long long xcr0;
+
+  __cpuid( info, 0 );
+  if ( info[0] < 7 )
+    return 0;
+
+  /* AVX, FMA and OS support for saving the ymm registers */
+  __cpuid( info, 1 );
+  if ( !( info[2] & ( 1<<27 ) ) || !( info[2] & ( 1<<28 ) ) || !( info[2] & ( 1<<12 ) ) )
+    return 0;
+  xcr0 = _xgetbv( 0 );
+  if ( ( xcr0 & 0x6 ) != 0x6 )
+    return 0;
+
+  __cpuidex( info, 7, 0 );
+  if ( !( info[1] & ( 1<<5 ) ) )
+    return 0;
+  /* AVX-512F and OS support for saving the zmm and mask registers */
+  if ( SEMINAIVE_AVX512 && ( info[1] & ( 1<<16 ) ) && ( xcr0 & 0xe6 ) == 0xe6 )
+    return 2;
+  return 1;
+#elif defined( __GNUC__ )
+  __builtin_cpu_init( );
+  if ( SEMINAIVE_AVX512 && __builtin_cpu_supports( "avx512f" ) )
+    return 2;
+  if ( __builtin_cpu_supports( "avx2" ) && __builtin_cpu_supports( "fma" ) )
+    return 1;
+  return 0;
+#else
+  return 0;
+#endif
+#else
+  return 0;
+#endif
+}
+
+/* -1 until the first query */
+static int simdLevel = -1;
+
+int SemiNaiveSIMDLevel( void )
+{
+  if ( simdLevel < 0 )
+    simdLevel = SupportedSIMDLevel( );
+  return simdLevel;
+}
+
+void SetSemiNaiveSIMDLevel( int level )
+{
+  int supported = SupportedSIMDLevel( );
+
+  if ( level < 0 )
+    level = 0;
+  simdLevel = ( level < supported ) ? level : supported;
+}
+
+/* dispatches on the instruction set and the number of columns */
+#define SEMINAIVE_DISPATCH( KERNEL , OPS , ARGS )				\
+  {									\
+    switch ( 4*SemiNaiveSIMDLevel( ) + cols )				\
+      {									\
+      AVX512_CASES( KERNEL , OPS , ARGS )				\
+      AVX2_CASES( KERNEL , OPS , ARGS )					\
+      case 2: SemiNaiveScalar::KERNEL< SemiNaiveScalar::OPS , 2 > ARGS ; break; \
+      default: SemiNaiveScalar::KERNEL< SemiNaiveScalar::OPS , 1 > ARGS ; break; \
+      }									\
+  }
+#if SEMINAIVE_SIMD
+#define AVX2_CASES( KERNEL , OPS , ARGS )				\
+  case 5: SemiNaiveAVX2::KERNEL< SemiNaiveAVX2::OPS , 1 > ARGS ; break;	\
+  case 6: SemiNaiveAVX2::KERNEL< SemiNaiveAVX2::OPS , 2 > ARGS ; break;
+#else
+#define AVX2_CASES( KERNEL , OPS , ARGS )
+#endif
+#if SEMINAIVE_AVX512
+#define AVX512_CASES( KERNEL , OPS , ARGS )				\
+  case 9:  SemiNaiveAVX512::KERNEL< SemiNaiveAVX512::OPS , 1 > ARGS ; break; \
+  case 10: SemiNaiveAVX512::KERNEL< SemiNaiveAVX512::OPS , 2 > ARGS ; break;
+#else
+#define AVX512_CASES( KERNEL , OPS , ARGS )
+#endif
+
+void SemiNaiveProject( const double *cos_even,
+		       const double *cos_odd,
+		       int colStride,
+		       int cols,
+		       int bw,
+		       int m,
+		       const double *cos_pml_table,
+		       double *result,
+		       int resultStride )
+{
+  SEMINAIVE_DISPATCH( Project , DoubleOps , ( cos_even, cos_odd, colStride, bw, m, cos_pml_table, result, resultStride ) )
+}
+
+void SemiNaiveProject( const float *cos_even,
+		       const float *cos_odd,
+		       int colStride,
+		       int cols,
+		       int bw,
+		       int m,
+		       const float *cos_pml_table,
+		       float *result,
+		       int resultStride )
+{
+  SEMINAIVE_DISPATCH( Project , FloatOps , ( cos_even, cos_odd, colStride, bw, m, cos_pml_table, result, resultStride ) )
+}
+
+void InvSemiNaiveProject( const double *even_series,
+			  const double *odd_series,
+			  int colStride,
+			  int cols,
+			  int bw,
+			  int m,
+			  const double *trans_cos_pml_table,
+			  double *fcos,
+			  int fcosStride )
+{
+  SEMINAIVE_DISPATCH( InvProject , DoubleOps , ( even_series, odd_series, colStride, bw, m, trans_cos_pml_table, fcos, fcosStride ) )
+}
+
+void InvSemiNaiveProject( const float *even_series,
+			  const float *odd_series,
+			  int colStride,
+			  int cols,
+			  int bw,
+			  int m,
+			  const float *trans_cos_pml_table,
+			  float *fcos,
+			  int fcosStride )
+{
+  SEMINAIVE_DISPATCH( InvProject , FloatOps , ( even_series, odd_series, colStride, bw, m, trans_cos_pml_table, fcos, fcosStride ) )
+}
+
+/* dispatches the array dot product on the instruction set */
+#define SEMINAIVE_DOT_DISPATCH( OPS )					\
+  {									\
+    switch ( SemiNaiveSIMDLevel( ) )					\
+      {									\
+      AVX512_DOT_CASE( OPS )						\
+      AVX2_DOT_CASE( OPS )						\
+      default: return SemiNaiveScalar::ArrayDot< SemiNaiveScalar::OPS >( a, b, n ); \
+      }									\
+  }
+#if SEMINAIVE_SIMD
+#define AVX2_DOT_CASE( OPS )						\
+  case 1: return SemiNaiveAVX2::ArrayDot< SemiNaiveAVX2::OPS >( a, b, n );
+#else
+#define AVX2_DOT_CASE( OPS )
+#endif
+#if SEMINAIVE_AVX512
+#define AVX512_DOT_CASE( OPS )						\
+  case 2: return SemiNaiveAVX512::ArrayDot< SemiNaiveAVX512::OPS >( a, b, n );
+#else
+#define AVX512_DOT_CASE( OPS )
+#endif
+
+double SemiNaiveDot( const double *a,
+		     const double *b,
+		     int n )
+{
+  SEMINAIVE_DOT_DISPATCH( DoubleOps )
+}
+
+float SemiNaiveDot( const float *a,
+		    const float *b,
+		    int n )
+{
+  SEMINAIVE_DOT_DISPATCH( FloatOps )
+}
+
+#undef SEMINAIVE_DISPATCH
+#undef AVX2_CASES
+#undef AVX512_CASES
+#undef SEMINAIVE_DOT_DISPATCH
+#undef AVX2_DOT_CASE
+#undef AVX512_DOT_CASE
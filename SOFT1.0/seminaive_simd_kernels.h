@@ -0,0 +1,199 @@
+/*
+  The seminaive projection kernels, written in terms of a vector
+  type and its operations (Ops).
+
+  This file is included by seminaive_simd.cpp once for each instruction
+  set, inside a namespace that defines the DoubleOps and FloatOps
+  structures, with SIMD_TARGET defined as the function attribute that
+  enables the instruction set.
+
+  NOT to be included anywhere else!!!
+*/
+
+/*
+  Computes the dot products of Rows table rows with Cols source columns;
+  the product of row r and column c is written to out[r*Cols+c].
+  Only the first min(lengths) entries are vectorized, the (short)
+  remainders are done one at a time.
+*/
+template< class Ops , int Rows , int Cols >
+SIMD_TARGET static inline void Dot( const typename Ops::Real * const *rows,
+				    const int *lengths,
+				    const typename Ops::Real * const *sources,
+				    typename Ops::Real *out )
+{
+  typedef typename Ops::Real Real;
+  typedef typename Ops::Vector Vector;
+  Vector acc[Rows][Cols], src[Cols], row;
+  int r, c, j, n;
+
+  n = lengths[0];
+  for ( r = 1 ; r < Rows ; r ++ )
+    if ( lengths[r] < n ) n = lengths[r];
+
+  for ( r = 0 ; r < Rows ; r ++ )
+    for ( c = 0 ; c < Cols ; c ++ )
+      acc[r][c] = Ops::Zero( );
+
+  for ( j = 0 ; j + Ops::Size <= n ; j += Ops::Size )
+    {
+      for ( c = 0 ; c < Cols ; c ++ )
+	src[c] = Ops::Load( sources[c] + j );
+      for ( r = 0 ; r < Rows ; r ++ )
+	{
+	  row = Ops::Load( rows[r] + j );
+	  for ( c = 0 ; c < Cols ; c ++ )
+	    acc[r][c] = Ops::MulAdd( row, src[c], acc[r][c] );
+	}
+    }
+
+  for ( r = 0 ; r < Rows ; r ++ )
+    for ( c = 0 ; c < Cols ; c ++ )
+      {
+	Real sum = Ops::Sum( acc[r][c] );
+	for ( int jj = j ; jj < lengths[r] ; jj ++ )
+	  sum += rows[r][jj] * sources[c][jj];
+	out[r*Cols+c] = sum;
+      }
+}
+
+/*
+  Computes the dot product of two arrays of length n. Unlike Dot, the
+  sum is split over several vector accumulators, since a single row
+  does not provide the independent chains that hide the latency of
+  the multiply-adds.
+*/
+template< class Ops >
+SIMD_TARGET static inline typename Ops::Real ArrayDot( const typename Ops::Real *a,
+						       const typename Ops::Real *b,
+						       int n )
+{
+  typedef typename Ops::Real Real;
+  typedef typename Ops::Vector Vector;
+  Vector acc0, acc1, acc2, acc3;
+  Real sum;
+  int j;
+
+  acc0 = acc1 = acc2 = acc3 = Ops::Zero( );
+  for ( j = 0 ; j + 4*Ops::Size <= n ; j += 4*Ops::Size )
+    {
+      acc0 = Ops::MulAdd( Ops::Load( a + j              ), Ops::Load( b + j              ), acc0 );
+      acc1 = Ops::MulAdd( Ops::Load( a + j +   Ops::Size ), Ops::Load( b + j +   Ops::Size ), acc1 );
+      acc2 = Ops::MulAdd( Ops::Load( a + j + 2*Ops::Size ), Ops::Load( b + j + 2*Ops::Size ), acc2 );
+      acc3 = Ops::MulAdd( Ops::Load( a + j + 3*Ops::Size ), Ops::Load( b + j + 3*Ops::Size ), acc3 );
+    }
+  for ( ; j + Ops::Size <= n ; j += Ops::Size )
+    acc0 = Ops::MulAdd( Ops::Load( a + j ), Ops::Load( b + j ), acc0 );
+
+  sum = ( Ops::Sum( acc0 ) + Ops::Sum( acc1 ) ) + ( Ops::Sum( acc2 ) + Ops::Sum( acc3 ) );
+  for ( ; j < n ; j ++ )
+    sum += a[j] * b[j];
+  return sum;
+}
+
+/*
+  Forward projections for order m. Rows of the same parity (degrees
+  l and l+2) are projected together, so that the loads of the cosine
+  coefficients are shared.
+*/
+template< class Ops , int Cols >
+SIMD_TARGET static void Project( const typename Ops::Real *cos_even,
+				 const typename Ops::Real *cos_odd,
+				 int colStride,
+				 int bw,
+				 int m,
+				 const typename Ops::Real *cos_pml_table,
+				 typename Ops::Real *result,
+				 int resultStride )
+{
+  typedef typename Ops::Real Real;
+  const Real *sources[2][Cols];
+  const Real *rows[2];
+  int lengths[2];
+  Real out[2*Cols];
+  int i, p, r, c, count;
+
+  for ( c = 0 ; c < Cols ; c ++ )
+    {
+      sources[0][c] = cos_even + c*colStride;
+      sources[1][c] = cos_odd  + c*colStride;
+    }
+
+  count = bw - m;
+
+  /* rows i, i+2 and then i+1, i+3 */
+  for ( i = 0 ; i + 3 < count ; i += 4 )
+    for ( p = 0 ; p < 2 ; p ++ )
+      {
+	for ( r = 0 ; r < 2 ; r ++ )
+	  {
+	    rows[r] = cos_pml_table + NewTableOffset( m, m + i + p + 2*r );
+	    lengths[r] = RowSize( m, m + i + p + 2*r );
+	  }
+	Dot< Ops , 2 , Cols >( rows, lengths, sources[p], out );
+	for ( r = 0 ; r < 2 ; r ++ )
+	  for ( c = 0 ; c < Cols ; c ++ )
+	    result[(i+p+2*r)*resultStride+c] = out[r*Cols+c];
+      }
+
+  for ( ; i < count ; i ++ )
+    {
+      rows[0] = cos_pml_table + NewTableOffset( m, m + i );
+      lengths[0] = RowSize( m, m + i );
+      Dot< Ops , 1 , Cols >( rows, lengths, sources[i%2], out );
+      for ( c = 0 ; c < Cols ; c ++ )
+	result[i*resultStride+c] = out[c];
+    }
+}
+
+/*
+  Inverse projections for order m: the rows of the transposed table
+  are traversed in order, and each one is projected onto all the
+  columns.
+*/
+template< class Ops , int Cols >
+SIMD_TARGET static void InvProject( const typename Ops::Real *even_series,
+				    const typename Ops::Real *odd_series,
+				    int colStride,
+				    int bw,
+				    int m,
+				    const typename Ops::Real *trans_cos_pml_table,
+				    typename Ops::Real *fcos,
+				    int fcosStride )
+{
+  typedef typename Ops::Real Real;
+  const Real *sources[Cols];
+  const Real *row;
+  int rowsize;
+  Real out[Cols];
+  int i, c, start;
+
+  row = trans_cos_pml_table;
+  for ( i = 0 ; i < bw ; i ++ )
+    {
+      /* if m odd, the last row is all zeroes */
+      if ( ( i == bw - 1 ) && ( ( m % 2 ) == 1 ) )
+	{
+	  for ( c = 0 ; c < Cols ; c ++ )
+	    fcos[i+c*fcosStride] = 0;
+	  break;
+	}
+
+      rowsize = Transpose_RowSize( i, m, bw );
+
+      /* the (relative) degree of the first Legendre coefficient */
+      if ( i <= m )
+	start = i % 2;
+      else
+	start = ( i - m ) + ( m % 2 );
+
+      for ( c = 0 ; c < Cols ; c ++ )
+	sources[c] = ( ( start % 2 ) ? odd_series : even_series ) + start/2 + c*colStride;
+
+      Dot< Ops , 1 , Cols >( &row, &rowsize, sources, out );
+      for ( c = 0 ; c < Cols ; c ++ )
+	fcos[i+c*fcosStride] = out[c];
+
+      row += rowsize;
+    }
+}
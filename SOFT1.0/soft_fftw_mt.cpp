@@ -0,0 +1,966 @@
+/***************************************************************************
+  **************************************************************************
+  
+                SOFT: SO(3) Fourier transform code
+
+                Version 1.0
+
+  
+   Peter Kostelec, Dan Rockmore
+   {geelong,rockmore}@cs.dartmouth.edu
+  
+   Contact: Peter Kostelec
+            geelong@cs.dartmouth.edu
+  
+  
+   Copyright 2003 Peter Kostelec, Dan Rockmore
+  
+  
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published by
+     the Free Software Foundation; either version 2 of the License, or
+     (at your option) any later version.
+  
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+     GNU General Public License for more details.
+  
+     You should have received a copy of the GNU General Public License
+     along with this program; if not, write to the Free Software
+     Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+  
+  
+   Commercial use is absolutely prohibited.
+  
+   See the accompanying LICENSE file for details.
+  
+  ************************************************************************
+  ************************************************************************/
+
+/*
+
+  the INVERSE transform on the full group SO(3) via fftw, with the
+  work split over threads (via OpenMP)
+
+  sample size = (2*bw)^3
+  coefficient size = on the order of bw^3 (a little more, actually)
+
+  functions in here:
+
+  Inverse_SO3_Naive_fftw_mt_WorkspaceSize();
+  Inverse_SO3_Naive_fftw_mt();
+  Inverse_SO3_Naive_fftw_mt_real();
+
+  The synthesis of the order pairs follows Inverse_SO3_Naive_fftw_pc():
+  the Wigner-ds of the order (m1, m2), 0 <= m1 <= m2, are used for
+  up to eight order pairs. Those eight synthesis only ever write into
+  their own rows of the data array, so the (m1, m2) are independent
+  and are distributed over the threads. The transposes and the FFTs
+  of the two final stages are split over the (2*bw) slabs of the data.
+
+  Inverse_SO3_Naive_fftw_mt_real() is the version for REAL signals
+  (flag = 1): it only synthesizes the order pairs (m1, m2) with m2 >= 0,
+  which are written (conjugated) straight into the half-spectrum of
+  each beta, and takes one (2*bw) x (2*bw) complex-to-real FFT per beta.
+  This needs about half the synthesis, half the FFT work and half the
+  memory of the complex transform. It only reads the coefficients with
+  m1 >= 0 (the first half of the coefficient array), and the samples
+  of the betas can be interleaved in the output.
+
+  Inverse_SO3_Naive_fftw_mt() comes in a double precision (fftw) and
+  a single precision (fftwf) version. The single precision version
+  keeps the coefficients, the samples, the complex workspaces and the
+  precomputed Wigner-ds in floats, so it needs half the memory. The
+  sums of the Wigner synthesis are always accumulated in doubles, and
+  the Wigner-ds generated on the fly are always doubles.
+
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <omp.h>
+#include "fftw3.h"
+
+#include "complex.h"
+
+#include "utils_so3.h"
+#include "makeWigner.h"
+#include "soft_fftw_mt.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* the kinds of (m1, m2) orders for which Wigner-ds are computed */
+#define SLAB_DIAGONAL 0 /* (m, m), m >= 0 */
+#define SLAB_AXIS     1 /* (m, 0), m >= 1 */
+#define SLAB_GENERAL  2 /* (m1, m2), 1 <= m1 < m2 */
+
+typedef struct {
+  int kind, m1, m2 ;
+  long offset ; /* where the Wigner-ds of the order start in the
+		   precomputed table */
+} wignerSlab ;
+
+/************************************************************************/
+/* the REAL workspace of a thread: the sample points and the Wigner-ds
+   of one order (at most bw*n) plus the scratch used to generate them,
+   as in Inverse_SO3_Naive_fftw() */
+
+int Inverse_SO3_Naive_fftw_mt_WorkspaceSize( int bw )
+{
+  return 12 * (2*bw) + (2*bw) * bw ;
+}
+
+/************************************************************************/
+/* list the orders for which Wigner-ds are computed, in the order of
+   the precomputed table, with the offsets of their Wigner-ds in it */
+
+static wignerSlab *listSlabs( int bw,
+			      int *slabCount )
+{
+  int n, m1, m2, s ;
+  long offset ;
+  wignerSlab *slabs ;
+
+  n = 2 * bw ;
+  *slabCount = bw + (bw-1) + ((bw-1)*(bw-2))/2 ;
+  slabs = (wignerSlab *) malloc( sizeof(wignerSlab) * (*slabCount) ) ;
+
+  s = 0 ;
+  offset = 0 ;
+  for ( m1 = 0 ; m1 < bw ; m1 ++ )
+    {
+      slabs[s].kind = SLAB_DIAGONAL ;
+      slabs[s].m1 = slabs[s].m2 = m1 ;
+      slabs[s++].offset = offset ;
+      offset += n * (bw-m1) ;
+    }
+  for ( m1 = 1 ; m1 < bw ; m1 ++ )
+    {
+      slabs[s].kind = SLAB_AXIS ;
+      slabs[s].m1 = m1 ;
+      slabs[s].m2 = 0 ;
+      slabs[s++].offset = offset ;
+      offset += n * (bw-m1) ;
+    }
+  for ( m1 = 1 ; m1 < bw ; m1 ++ )
+    for ( m2 = m1 + 1 ; m2 < bw ; m2 ++ )
+      {
+	slabs[s].kind = SLAB_GENERAL ;
+	slabs[s].m1 = m1 ;
+	slabs[s].m2 = m2 ;
+	slabs[s++].offset = offset ;
+	offset += n * (bw-m2) ;
+      }
+
+  return slabs ;
+}
+
+/************************************************************************/
+/*
+  the inverse Wigner transforms of wignerTransforms_fftw.c, for either
+  precision of the samples and of the Wigner-ds:
+
+  wigNaiveSynthesis_mt() is wigNaiveSynthesis_fftw()
+  wigNaiveSynthesisX_mt() is wigNaiveSynthesis_fftwX()
+  wigNaiveSynthesisY_mt() is wigNaiveSynthesis_fftwY()
+
+  (see there for the details)
+*/
+
+template< class Real , class WReal >
+static void wigNaiveSynthesis_mt( int m1,
+				  int m2,
+				  int bw,
+				  Real (*coeffs)[2],
+				  const WReal *wignersTrans,
+				  Real (*signal)[2] )
+{
+  int i, j, m, n ;
+  const WReal *wignersTransPtr ;
+  double tmpA, tmpB ;
+
+  m = MAX( ABS( m1 ) , ABS( m2 ) ) ;
+  n = 2 * bw ;
+
+  wignersTransPtr = wignersTrans ;
+
+  for ( i = 0 ; i < n ; i ++ )
+    {
+      tmpA = 0.0 ;
+      tmpB = 0.0 ;
+      for ( j = 0 ; j < (bw - m) ; j ++ )
+	{
+	  tmpA += *wignersTransPtr * coeffs[j][0] ;
+	  tmpB += *wignersTransPtr * coeffs[j][1] ;
+	  wignersTransPtr++ ;
+	}
+      signal[ i ][0] = (Real) tmpA ;
+      signal[ i ][1] = (Real) tmpB ;
+    }
+}
+
+template< class Real , class WReal >
+static void wigNaiveSynthesisX_mt( int m1,
+				   int m2,
+				   int bw,
+				   Real (*coeffs)[2],
+				   const WReal *wignersTrans,
+				   Real (*signal)[2] )
+{
+  int i, j, m, n ;
+  int fudge ;
+  const WReal *wignersTransPtr ;
+  double tmpA, tmpB ;
+
+  m = MAX( ABS( m1 ) , ABS( m2 ) ) ;
+  n = 2 * bw ;
+
+  if ( ABS( m1 - m2 ) % 2 )
+    fudge = -1 ;
+  else
+    fudge = 1 ;
+
+  wignersTransPtr = wignersTrans ;
+
+  for ( i = 0 ; i < n ; i ++ )
+    {
+      tmpA = 0.0 ;
+      tmpB = 0.0 ;
+      for ( j = 0 ; j < (bw - m) ; j ++ )
+	{
+	  tmpA += *wignersTransPtr * coeffs[j][0] ;
+	  tmpB += *wignersTransPtr * coeffs[j][1] ;
+	  wignersTransPtr++ ;
+	}
+      signal[ i ][0] = (Real) ( fudge * tmpA ) ;
+      signal[ i ][1] = (Real) ( fudge * tmpB ) ;
+    }
+}
+
+/* only the (bw - m) coefficients that are used are copied into the
+   workspace, which must hold at least bw COMPLEX numbers */
+
+template< class Real , class WReal >
+static void wigNaiveSynthesisY_mt( int m1,
+				   int m2,
+				   int bw,
+				   Real (*coeffs)[2],
+				   const WReal *wignersTrans,
+				   Real (*signal)[2],
+				   Real (*workspace)[2] )
+{
+  int i, j, m, n ;
+  int fudge ;
+  const WReal *wignersTransPtr ;
+  double tmpA, tmpB ;
+
+  m = MAX( ABS( m1 ) , ABS( m2 ) ) ;
+  n = 2 * bw ;
+
+  if ( m1 < 0 )
+    {
+      if ( (m - m2) % 2 )
+	fudge = -1 ;
+      else
+	fudge = 1 ;
+    }
+  else
+    {
+      if ( (m + m1) % 2 )
+	fudge = -1 ;
+      else
+	fudge = 1 ;
+    }
+
+  for ( j = 0 ; j < (bw - m) ; j ++ )
+    {
+      workspace[j][0] = coeffs[j][0] * fudge ;
+      workspace[j][1] = coeffs[j][1] * fudge ;
+      fudge *= -1 ;
+    }
+
+  /* the rows of the Wigner-ds are used from the last to the first */
+  for ( i = 0 ; i < n ; i ++ )
+    {
+      wignersTransPtr = wignersTrans + (n - i - 1)*(bw - m) ;
+      tmpA = 0.0 ;
+      tmpB = 0.0 ;
+      for ( j = 0 ; j < (bw - m) ; j ++ )
+	{
+	  tmpA += *wignersTransPtr * workspace[ j ][0] ;
+	  tmpB += *wignersTransPtr * workspace[ j ][1] ;
+	  wignersTransPtr++ ;
+	}
+      signal[ i ][0] = (Real) tmpA ;
+      signal[ i ][1] = (Real) tmpB ;
+    }
+}
+
+/************************************************************************/
+/* the samples of a real signal at order (-m1,-m2) are the conjugates
+   of those at order (m1,m2) */
+
+template< class Real >
+static void conjugateSamples( Real (*data)[2],
+			      int from,
+			      int to,
+			      int n )
+{
+  int j ;
+
+  for ( j = 0 ; j < n ; j ++ )
+    {
+      data[to+j][0] = data[from+j][0] ;
+      data[to+j][1] = -data[from+j][1] ;
+    }
+}
+
+/************************************************************************/
+/* synthesize all the order pairs that use the Wigner-ds of the slab
+   (see Inverse_SO3_Naive_fftw_pc() for the details) */
+
+template< class Real , class WReal >
+static void synthesizeSlab( int bw,
+			    const wignerSlab *slab,
+			    Real (*coeffs)[2],
+			    Real (*data)[2],
+			    const WReal *wigners,
+			    Real (*workspace)[2],
+			    int flag )
+{
+  int m1, m2, n ;
+
+  m1 = slab->m1 ;
+  m2 = slab->m2 ;
+  n = 2 * bw ;
+
+  switch ( slab->kind )
+    {
+    case SLAB_DIAGONAL:
+      wigNaiveSynthesis_mt( m1, m1, bw, coeffs + coefLoc_so3( m1, m1, bw ),
+			    wigners, data + sampLoc_so3( m1, m1, bw ) ) ;
+      if ( m1 == 0 )
+	break ;
+
+      if ( flag == 0 ) /* if data is complex */
+	wigNaiveSynthesis_mt( -m1, -m1, bw, coeffs + coefLoc_so3( -m1, -m1, bw ),
+			      wigners, data + sampLoc_so3( -m1, -m1, bw ) ) ;
+      else
+	conjugateSamples( data, sampLoc_so3( m1, m1, bw ), sampLoc_so3( -m1, -m1, bw ), n ) ;
+
+      wigNaiveSynthesisY_mt( -m1, m1, bw, coeffs + coefLoc_so3( -m1, m1, bw ),
+			     wigners, data + sampLoc_so3( -m1, m1, bw ),
+			     workspace ) ;
+
+      if ( flag == 0 )
+	wigNaiveSynthesisY_mt( m1, -m1, bw, coeffs + coefLoc_so3( m1, -m1, bw ),
+			       wigners, data + sampLoc_so3( m1, -m1, bw ),
+			       workspace ) ;
+      else
+	conjugateSamples( data, sampLoc_so3( -m1, m1, bw ), sampLoc_so3( m1, -m1, bw ), n ) ;
+      break ;
+
+    case SLAB_AXIS:
+      wigNaiveSynthesis_mt( m1, 0, bw, coeffs + coefLoc_so3( m1, 0, bw ),
+			    wigners, data + sampLoc_so3( m1, 0, bw ) ) ;
+
+      if ( flag == 0 )
+	wigNaiveSynthesisX_mt( -m1, 0, bw, coeffs + coefLoc_so3( -m1, 0, bw ),
+			       wigners, data + sampLoc_so3( -m1, 0, bw ) ) ;
+      else
+	conjugateSamples( data, sampLoc_so3( m1, 0, bw ), sampLoc_so3( -m1, 0, bw ), n ) ;
+
+      wigNaiveSynthesisX_mt( 0, m1, bw, coeffs + coefLoc_so3( 0, m1, bw ),
+			     wigners, data + sampLoc_so3( 0, m1, bw ) ) ;
+
+      if ( flag == 0 )
+	wigNaiveSynthesis_mt( 0, -m1, bw, coeffs + coefLoc_so3( 0, -m1, bw ),
+			      wigners, data + sampLoc_so3( 0, -m1, bw ) ) ;
+      else
+	conjugateSamples( data, sampLoc_so3( 0, m1, bw ), sampLoc_so3( 0, -m1, bw ), n ) ;
+      break ;
+
+    case SLAB_GENERAL:
+      wigNaiveSynthesis_mt( m1, m2, bw, coeffs + coefLoc_so3( m1, m2, bw ),
+			    wigners, data + sampLoc_so3( m1, m2, bw ) ) ;
+
+      if ( flag == 0 )
+	wigNaiveSynthesisX_mt( -m1, -m2, bw, coeffs + coefLoc_so3( -m1, -m2, bw ),
+			       wigners, data + sampLoc_so3( -m1, -m2, bw ) ) ;
+      else
+	conjugateSamples( data, sampLoc_so3( m1, m2, bw ), sampLoc_so3( -m1, -m2, bw ), n ) ;
+
+      wigNaiveSynthesisY_mt( m1, -m2, bw, coeffs + coefLoc_so3( m1, -m2, bw ),
+			     wigners, data + sampLoc_so3( m1, -m2, bw ),
+			     workspace ) ;
+
+      if ( flag == 0 )
+	wigNaiveSynthesisY_mt( -m1, m2, bw, coeffs + coefLoc_so3( -m1, m2, bw ),
+			       wigners, data + sampLoc_so3( -m1, m2, bw ),
+			       workspace ) ;
+      else
+	conjugateSamples( data, sampLoc_so3( m1, -m2, bw ), sampLoc_so3( -m1, m2, bw ), n ) ;
+
+      wigNaiveSynthesisX_mt( m2, m1, bw, coeffs + coefLoc_so3( m2, m1, bw ),
+			     wigners, data + sampLoc_so3( m2, m1, bw ) ) ;
+
+      if ( flag == 0 )
+	wigNaiveSynthesis_mt( -m2, -m1, bw, coeffs + coefLoc_so3( -m2, -m1, bw ),
+			      wigners, data + sampLoc_so3( -m2, -m1, bw ) ) ;
+      else
+	conjugateSamples( data, sampLoc_so3( m2, m1, bw ), sampLoc_so3( -m2, -m1, bw ), n ) ;
+
+      wigNaiveSynthesisY_mt( m1, -m2, bw, coeffs + coefLoc_so3( m2, -m1, bw ),
+			     wigners, data + sampLoc_so3( m2, -m1, bw ),
+			     workspace ) ;
+
+      if ( flag == 0 )
+	wigNaiveSynthesisY_mt( -m1, m2, bw, coeffs + coefLoc_so3( -m2, m1, bw ),
+			       wigners, data + sampLoc_so3( -m2, m1, bw ),
+			       workspace ) ;
+      else
+	conjugateSamples( data, sampLoc_so3( m2, -m1, bw ), sampLoc_so3( -m2, m1, bw ), n ) ;
+      break ;
+    }
+}
+
+/************************************************************************/
+/* write the samples of order (m1, m2), m2 >= 0, into the half-spectra
+   of the betas, which are stored one after the other, each as a
+   (2*bw) x (bw+1) array with the (wrapped-around) m1 as the row. If
+   "conjugate" is set, the conjugates of the samples are written. */
+
+template< class Real >
+static void scatterSamples( Real (*samples)[2],
+			    Real (*halfSpectra)[2],
+			    int m1,
+			    int m2,
+			    int bw,
+			    int conjugate )
+{
+  int j, n, stride ;
+  double sign ;
+  Real (*halfSpectrum)[2] ;
+
+  n = 2 * bw ;
+  stride = n * (bw+1) ;
+  halfSpectrum = halfSpectra + ( ( m1 < 0 ) ? m1 + n : m1 ) * (bw+1) + m2 ;
+  sign = conjugate ? -1. : 1. ;
+
+  for ( j = 0 ; j < n ; j ++ )
+    {
+      halfSpectrum[j*stride][0] = samples[j][0] ;
+      halfSpectrum[j*stride][1] = (Real) ( sign * samples[j][1] ) ;
+    }
+}
+
+/************************************************************************/
+/* synthesize the order pairs (m1, m2) with m2 >= 0 that use the
+   Wigner-ds of the slab, for a REAL signal (so that the samples at
+   (-m1,-m2) are the conjugates of those at (m1,m2)).
+
+   The FFTs of the complex transform are forward ones, but FFTW's
+   complex-to-real FFTs are backward ones, so the half-spectra hold the
+   conjugates of the samples: the backward FFT of the conjugates is the
+   conjugate of the forward FFT, which is real. The order pairs are
+   those of synthesizeSlab() with flag = 1, except that (-m, m) is
+   the conjugate of (m, -m), so that only the coefficients with
+   m1 >= 0 are used. */
+
+template< class Real , class WReal >
+static void synthesizeSlabHalf( int bw,
+				const wignerSlab *slab,
+				Real (*coeffs)[2],
+				Real (*halfSpectra)[2],
+				const WReal *wigners,
+				Real (*samples)[2],
+				Real (*workspace)[2] )
+{
+  int m1, m2 ;
+
+  m1 = slab->m1 ;
+  m2 = slab->m2 ;
+
+  switch ( slab->kind )
+    {
+    case SLAB_DIAGONAL:
+      wigNaiveSynthesis_mt( m1, m1, bw, coeffs + coefLoc_so3( m1, m1, bw ),
+			    wigners, samples ) ;
+      scatterSamples( samples, halfSpectra, m1, m1, bw, 1 ) ;
+      if ( m1 == 0 )
+	break ;
+
+      /* (-m1, m1) is the conjugate of (m1, -m1) */
+      wigNaiveSynthesisY_mt( m1, -m1, bw, coeffs + coefLoc_so3( m1, -m1, bw ),
+			     wigners, samples, workspace ) ;
+      scatterSamples( samples, halfSpectra, -m1, m1, bw, 0 ) ;
+      break ;
+
+    case SLAB_AXIS:
+      wigNaiveSynthesis_mt( m1, 0, bw, coeffs + coefLoc_so3( m1, 0, bw ),
+			    wigners, samples ) ;
+      scatterSamples( samples, halfSpectra, m1, 0, bw, 1 ) ;
+      scatterSamples( samples, halfSpectra, -m1, 0, bw, 0 ) ;
+
+      wigNaiveSynthesisX_mt( 0, m1, bw, coeffs + coefLoc_so3( 0, m1, bw ),
+			     wigners, samples ) ;
+      scatterSamples( samples, halfSpectra, 0, m1, bw, 1 ) ;
+      break ;
+
+    case SLAB_GENERAL:
+      wigNaiveSynthesis_mt( m1, m2, bw, coeffs + coefLoc_so3( m1, m2, bw ),
+			    wigners, samples ) ;
+      scatterSamples( samples, halfSpectra, m1, m2, bw, 1 ) ;
+
+      /* (-m1, m2) is the conjugate of (m1, -m2) */
+      wigNaiveSynthesisY_mt( m1, -m2, bw, coeffs + coefLoc_so3( m1, -m2, bw ),
+			     wigners, samples, workspace ) ;
+      scatterSamples( samples, halfSpectra, -m1, m2, bw, 0 ) ;
+
+      wigNaiveSynthesisX_mt( m2, m1, bw, coeffs + coefLoc_so3( m2, m1, bw ),
+			     wigners, samples ) ;
+      scatterSamples( samples, halfSpectra, m2, m1, bw, 1 ) ;
+
+      /* (-m2, m1) is the conjugate of (m2, -m1) */
+      wigNaiveSynthesisY_mt( m1, -m2, bw, coeffs + coefLoc_so3( m2, -m1, bw ),
+			     wigners, samples, workspace ) ;
+      scatterSamples( samples, halfSpectra, -m2, m1, bw, 0 ) ;
+      break ;
+    }
+}
+
+/************************************************************************/
+/*
+  Stage 1 of the inverse transforms: the inverse Wigner transforms, one
+  task per order for which Wigner-ds are computed, listed in the order
+  of the precomputed table. If "half" is set, the order pairs are
+  synthesized into the half-spectra of a REAL signal, with
+  synthesizeSlabHalf() (and then each thread needs 2*(2*bw) COMPLEX
+  numbers of workspace_cx2, rather than 2*bw).
+*/
+
+template< class Real >
+static void synthesizeOrders( int bw,
+			      Real (*coeffs)[2],
+			      Real (*data)[2],
+			      const Real *wigners,
+			      Real (*workspace_cx2)[2],
+			      double *workspace_re,
+			      int flag,
+			      int half,
+			      int threads )
+{
+  int n, s, slabCount ;
+  wignerSlab *slabs ;
+
+  n = 2 * bw ;
+  slabs = listSlabs( bw, &slabCount ) ;
+
+#pragma omp parallel num_threads( threads )
+  {
+    int t ;
+    double *sinPts, *cosPts, *sinPts2, *cosPts2 ;
+    double *wignersTrans, *scratch ;
+    Real (*workspace)[2], (*samples)[2] ;
+
+    t = omp_get_thread_num( ) ;
+    if ( half )
+      {
+	samples = workspace_cx2 + t * 2 * n ;
+	workspace = samples + n ;
+      }
+    else
+      {
+	samples = NULL ;
+	workspace = workspace_cx2 + t * n ;
+      }
+    sinPts = workspace_re + t * Inverse_SO3_Naive_fftw_mt_WorkspaceSize( bw ) ;
+    cosPts = sinPts + n ;
+    sinPts2 = cosPts + n ;
+    cosPts2 = sinPts2 + n ;
+    wignersTrans = cosPts2 + n ;
+    scratch = wignersTrans + ( bw * n ) ;
+
+    if ( wigners == NULL )
+      {
+	SinEvalPts( n, sinPts ) ;
+	CosEvalPts( n, cosPts ) ;
+	SinEvalPts2( n, sinPts2 ) ;
+	CosEvalPts2( n, cosPts2 ) ;
+      }
+
+#pragma omp for schedule( dynamic )
+    for ( s = 0 ; s < slabCount ; s ++ )
+      {
+	if ( wigners == NULL )
+	  {
+	    genWigTrans_L2( slabs[s].m1, slabs[s].m2, bw,
+			    sinPts, cosPts,
+			    sinPts2, cosPts2,
+			    wignersTrans, scratch ) ;
+	    if ( half )
+	      synthesizeSlabHalf( bw, slabs + s, coeffs, data, (const double *) wignersTrans, samples, workspace ) ;
+	    else
+	      synthesizeSlab( bw, slabs + s, coeffs, data, (const double *) wignersTrans, workspace, flag ) ;
+	  }
+	else if ( half )
+	  synthesizeSlabHalf( bw, slabs + s, coeffs, data, wigners + slabs[s].offset, samples, workspace ) ;
+	else
+	  synthesizeSlab( bw, slabs + s, coeffs, data, wigners + slabs[s].offset, workspace, flag ) ;
+      }
+  }
+
+  free( slabs ) ;
+}
+
+/************************************************************************/
+/* transpose the m x n COMPLEX matrix arrayIn into arrayOut, as
+   transpose_cx() does, with the columns split over the threads */
+
+template< class Real >
+static void transpose_cx_mt( Real (*arrayIn)[2],
+			     Real (*arrayOut)[2],
+			     int m,
+			     int n,
+			     int threads )
+{
+  const int block = 32 ;
+  int j0 ;
+
+#pragma omp parallel for num_threads( threads )
+  for ( j0 = 0 ; j0 < n ; j0 += block )
+    {
+      int i, j, j1 ;
+
+      j1 = ( j0 + block < n ) ? j0 + block : n ;
+      for ( i = 0 ; i < m ; i ++ )
+	for ( j = j0 ; j < j1 ; j ++ )
+	  {
+	    arrayOut[j*m+i][0] = arrayIn[i*n+j][0] ;
+	    arrayOut[j*m+i][1] = arrayIn[i*n+j][1] ;
+	  }
+    }
+}
+
+/************************************************************************/
+/* execute the plan of one slab, in either precision (complex-to-complex
+   for the complex transform and complex-to-real for the real one) */
+
+static void executeSlabPlan( fftw_plan p,
+			     fftw_complex *in,
+			     fftw_complex *out )
+{
+  fftw_execute_dft( p, in, out ) ;
+}
+
+static void executeSlabPlan( fftwf_plan p,
+			     fftwf_complex *in,
+			     fftwf_complex *out )
+{
+  fftwf_execute_dft( p, in, out ) ;
+}
+
+static void executeSlabPlan( fftw_plan p,
+			     fftw_complex *in,
+			     double *out )
+{
+  fftw_execute_dft_c2r( p, in, out ) ;
+}
+
+static void executeSlabPlan( fftwf_plan p,
+			     fftwf_complex *in,
+			     float *out )
+{
+  fftwf_execute_dft_c2r( p, in, out ) ;
+}
+
+/************************************************************************/
+/*
+  Inverse_SO3_Naive_fftw_mt: computes the inverse SO(3) transform, as
+  Inverse_SO3_Naive_fftw_pc(), with the work split over "threads"
+  threads.
+
+  bw = bandwidth of transform
+
+  coeffs: COMPLEX array of coefficients, arranged as for
+          Inverse_SO3_Naive_fftw_pc()
+
+  data: COMPLEX array of length (2*bw)^3, which will hold the samples
+
+  workspace_cx: COMPLEX scratch space of size (2*bw)^3
+
+  workspace_cx2: COMPLEX scratch space of size threads * (2*bw)
+
+  workspace_re: (double) REAL scratch space of size
+                threads * Inverse_SO3_Naive_fftw_mt_WorkspaceSize(bw)
+
+  p1: pointer to an FFTW plan for taking the (2*bw) FFTs, each of
+      length (2*bw), of ONE slab of (2*bw)^2 samples, from workspace_cx
+      into data (with fftw_plan_many_dft or fftwf_plan_many_dft). The
+      plan is executed on all the slabs, with fftw_execute_dft() (or
+      fftwf_execute_dft()).
+
+  wigners: pointer to the Wigner little-d's precomputed by
+           genWigAllTrans() (converted to floats for the single
+           precision version). If this is NULL, the Wigner-ds of each
+           order are generated when they are needed.
+
+  flag: = 0 data is COMPLEX
+        = 1 data is REAL
+
+  threads: the number of threads
+
+  The COMPLEX arrays are fftw_complex for the double precision version
+  and fftwf_complex for the single precision one.
+*/
+
+template< class Real , class Plan >
+static void _Inverse_SO3_Naive_fftw_mt( int bw,
+					Real (*coeffs)[2],
+					Real (*data)[2],
+					Real (*workspace_cx)[2],
+					Real (*workspace_cx2)[2],
+					double *workspace_re,
+					Plan *p1,
+					const Real *wigners,
+					int flag,
+					int threads )
+{
+  int j, n, m1, s ;
+  Real (*dataPtr)[2] ;
+  double dn ;
+
+  n = 2 * bw ;
+  if ( threads < 1 )
+    threads = 1 ;
+
+  /* Stage 1: the inverse Wigner transforms */
+
+  synthesizeOrders( bw, coeffs, data, wigners, workspace_cx2, workspace_re,
+		    flag, 0, threads ) ;
+
+
+  /* I need to set some zeros
+     so that I can take the fft correctly */
+
+  dataPtr = data + (n)*(bw) ;
+  for ( m1 = 0 ; m1 < bw  ; m1 ++ )
+    {
+      memset( dataPtr, 0, sizeof(Real) * 2 * n );
+      dataPtr += (2*n)*(bw) ;
+    }
+
+  dataPtr = data + bw*n*(n);
+  memset( dataPtr, 0, sizeof(Real) * 2 * n * n );
+  dataPtr += n * n + n*bw;
+
+  for ( m1 = 1 ; m1 < bw  ; m1 ++ )
+    {
+      memset( dataPtr, 0, sizeof(Real) * 2 * n );
+      dataPtr += (2*n)*(bw) ;
+    }
+
+  /*
+    Stages 2-5: transpose, FFT the "rows", transpose and FFT again
+    (see Inverse_SO3_Naive_fftw_pc()). The FFTs of each slab of n^2
+    samples are independent.
+  */
+
+  transpose_cx_mt( data, workspace_cx, n, n*n, threads ) ;
+
+#pragma omp parallel for num_threads( threads )
+  for ( s = 0 ; s < n ; s ++ )
+    executeSlabPlan( *p1, workspace_cx + s*n*n, data + s*n*n ) ;
+
+  transpose_cx_mt( data, workspace_cx, n, n*n, threads ) ;
+
+#pragma omp parallel for num_threads( threads )
+  for ( s = 0 ; s < n ; s ++ )
+    executeSlabPlan( *p1, workspace_cx + s*n*n, data + s*n*n ) ;
+
+  /* normalize the Fourier coefficients (sorry, have to do it) */
+
+  dn = 1./( (double) n );
+  dn *= ( ((double) bw) / M_PI ) ;
+
+#pragma omp parallel for num_threads( threads )
+  for ( j = 0 ; j < n*n*n; j++ )
+    {
+      data[ j ][0] = (Real) ( data[ j ][0] * dn ) ;
+      data[ j ][1] = (Real) ( data[ j ][1] * dn ) ;
+    }
+
+  /* and that's all, folks */
+}
+
+/************************************************************************/
+
+void Inverse_SO3_Naive_fftw_mt( int bw,
+				fftw_complex *coeffs,
+				fftw_complex *data,
+				fftw_complex *workspace_cx,
+				fftw_complex *workspace_cx2,
+				double *workspace_re,
+				fftw_plan *p1,
+				double *wigners,
+				int flag,
+				int threads )
+{
+  _Inverse_SO3_Naive_fftw_mt( bw, coeffs, data, workspace_cx, workspace_cx2,
+			      workspace_re, p1, (const double *) wigners,
+			      flag, threads ) ;
+}
+
+void Inverse_SO3_Naive_fftw_mt( int bw,
+				fftwf_complex *coeffs,
+				fftwf_complex *data,
+				fftwf_complex *workspace_cx,
+				fftwf_complex *workspace_cx2,
+				double *workspace_re,
+				fftwf_plan *p1,
+				float *wigners,
+				int flag,
+				int threads )
+{
+  _Inverse_SO3_Naive_fftw_mt( bw, coeffs, data, workspace_cx, workspace_cx2,
+			      workspace_re, p1, (const float *) wigners,
+			      flag, threads ) ;
+}
+
+/************************************************************************/
+/*
+  Inverse_SO3_Naive_fftw_mt_real: computes the inverse SO(3) transform
+  of a REAL signal, as Inverse_SO3_Naive_fftw_mt() with flag = 1, but
+  only synthesizes the order pairs (m1, m2) with m2 >= 0 and uses
+  complex-to-real FFTs.
+
+  bw = bandwidth of transform
+
+  coeffs: COMPLEX array of coefficients, arranged as for
+          Inverse_SO3_Naive_fftw_pc(). Only the coefficients with
+          m1 >= 0, which come first, are used, so the array need only
+          hold (4*bw^3 + 3*bw^2 - bw)/6 of them.
+
+  data: REAL array of length (2*bw)^3, which will hold the samples.
+        The (2*bw) x (2*bw) samples of the beta with index s start at
+        data + s*dist, laid out as the plan p1 writes them.
+
+  dist: the distance between the samples of consecutive betas: (2*bw)^2
+        for the layout of the real parts of the samples of
+        Inverse_SO3_Naive_fftw_mt(), or (2*bw) if the betas are
+        interleaved (and the plan writes the rows (2*bw)^2 apart)
+
+  workspace_cx: COMPLEX scratch space of size (2*bw)^2 * (bw+1), which
+                will hold the half-spectra of the (2*bw) betas
+
+  workspace_cx2: COMPLEX scratch space of size threads * 2 * (2*bw)
+
+  workspace_re: (double) REAL scratch space of size
+                threads * Inverse_SO3_Naive_fftw_mt_WorkspaceSize(bw)
+
+  p1: pointer to an FFTW plan for taking the (2*bw) x (2*bw)
+      complex-to-real FFT of ONE beta, from the (2*bw) x (bw+1)
+      half-spectrum in workspace_cx into the (2*bw) x (2*bw) samples in
+      data (with fftw_plan_dft_c2r_2d, or fftw_plan_many_dft_c2r if the
+      rows of the output are strided, or their fftwf versions). The
+      plan is executed on all the betas, with fftw_execute_dft_c2r()
+      (or fftwf_execute_dft_c2r()), so unless dist is (2*bw)^2 it
+      should be created with FFTW_UNALIGNED.
+
+  wigners: as for Inverse_SO3_Naive_fftw_mt()
+
+  threads: the number of threads
+*/
+
+template< class Real , class Plan >
+static void _Inverse_SO3_Naive_fftw_mt_real( int bw,
+					     Real (*coeffs)[2],
+					     Real *data,
+					     int dist,
+					     Real (*workspace_cx)[2],
+					     Real (*workspace_cx2)[2],
+					     double *workspace_re,
+					     Plan *p1,
+					     const Real *wigners,
+					     int threads )
+{
+  int j, n, s, stride ;
+  double dn ;
+
+  n = 2 * bw ;
+  stride = n * (bw+1) ;
+  if ( threads < 1 )
+    threads = 1 ;
+
+  /* Stage 1: the inverse Wigner transforms, into the half-spectra */
+
+  synthesizeOrders( bw, coeffs, workspace_cx, wigners, workspace_cx2, workspace_re,
+		    1, 1, threads ) ;
+
+  /* the m1 = bw rows and the m2 = bw columns are not synthesized */
+
+#pragma omp parallel for num_threads( threads )
+  for ( s = 0 ; s < n ; s ++ )
+    {
+      int m1 ;
+      Real (*halfSpectrum)[2] ;
+
+      halfSpectrum = workspace_cx + s*stride ;
+      memset( halfSpectrum + bw*(bw+1), 0, sizeof(Real) * 2 * (bw+1) ) ;
+      for ( m1 = 0 ; m1 < n ; m1 ++ )
+	halfSpectrum[m1*(bw+1)+bw][0] = halfSpectrum[m1*(bw+1)+bw][1] = 0 ;
+    }
+
+  /* Stage 2: the FFT of each beta */
+
+#pragma omp parallel for num_threads( threads )
+  for ( s = 0 ; s < n ; s ++ )
+    executeSlabPlan( *p1, workspace_cx + s*stride, data + s*dist ) ;
+
+  /* normalize */
+
+  dn = 1./( (double) n );
+  dn *= ( ((double) bw) / M_PI ) ;
+
+#pragma omp parallel for num_threads( threads )
+  for ( j = 0 ; j < n*n*n; j++ )
+    data[ j ] = (Real) ( data[ j ] * dn ) ;
+}
+
+/************************************************************************/
+
+void Inverse_SO3_Naive_fftw_mt_real( int bw,
+				     fftw_complex *coeffs,
+				     double *data,
+				     int dist,
+				     fftw_complex *workspace_cx,
+				     fftw_complex *workspace_cx2,
+				     double *workspace_re,
+				     fftw_plan *p1,
+				     double *wigners,
+				     int threads )
+{
+  _Inverse_SO3_Naive_fftw_mt_real( bw, coeffs, data, dist, workspace_cx, workspace_cx2,
+				   workspace_re, p1, (const double *) wigners,
+				   threads ) ;
+}
+
+void Inverse_SO3_Naive_fftw_mt_real( int bw,
+				     fftwf_complex *coeffs,
+				     float *data,
+				     int dist,
+				     fftwf_complex *workspace_cx,
+				     fftwf_complex *workspace_cx2,
+				     double *workspace_re,
+				     fftwf_plan *p1,
+				     float *wigners,
+				     int threads )
+{
+  _Inverse_SO3_Naive_fftw_mt_real( bw, coeffs, data, dist, workspace_cx, workspace_cx2,
+				   workspace_re, p1, (const float *) wigners,
+				   threads ) ;
+}
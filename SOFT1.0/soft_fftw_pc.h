@@ -59,10 +59,10 @@ extern void Forward_SO3_Naive_fftw_pc( int ,
 				       fftw_complex * ,
 				       fftw_complex * ,
 				       fftw_complex * ,
-				       REAL * ,
+				       double * ,
 				       fftw_plan * ,
 				       fftw_plan * ,
-				       REAL * ,
+				       double * ,
 				       int ) ;
 
 extern void Inverse_SO3_Naive_fftw_pc( int ,
@@ -70,9 +70,9 @@ extern void Inverse_SO3_Naive_fftw_pc( int ,
 				       fftw_complex * ,
 				       fftw_complex * ,
 				       fftw_complex * ,
-				       REAL * ,
+				       double * ,
 				       fftw_plan * ,
-				       REAL * ,
+				       double * ,
 				       int ) ;
 
 #endif /* _SOFT_FFTW_PC_H */
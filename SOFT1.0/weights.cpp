@@ -36,6 +36,13 @@
   ************************************************************************
   ************************************************************************/
 
+#include <math.h>
+#include <stdlib.h>
+
+#include "weights.h"
+
+#define PI 3.14159265358979323846
+
 /* quadrature weights file */
 
 /* contains precomputed arrays of Legendre quadrature weight values */
@@ -1342,7 +1349,77 @@ const double *get_weights(int bw)
     case 256: return w256;
     case 512: return w512;
     case 1024: return w1024;
-    default: return 0;
+    default: return get_computed_weights(bw);
+  }
+}
+
+/************************************************************************/
+/* the weights for bandwidths without a precomputed table are computed
+   (once) from the closed form and cached */
+
+struct computed_weights {
+  int bw;
+  double *weights;
+  struct computed_weights *next;
+};
+
+static struct computed_weights *computed_weights_list = 0;
+
+/* returns an array of size 4*bw: the quadrature weights for bandwidth
+   bw, followed by the weights for odd orders (i.e. with the sin factor
+   multiplied in, as in get_oddweights) */
+
+const double *get_computed_weights(int bw)
+{
+  struct computed_weights *cw, *head;
+  double *weights, fudge, tmpsum;
+  int j, k;
+
+  if (bw < 1)
+    return 0;
+
+  /* the entries are published by a flush (see below), so the list is
+     read between flushes, to see the entry contents the head points to */
+#pragma omp flush
+  head = computed_weights_list;
+#pragma omp flush
+  for (cw = head; cw; cw = cw->next)
+    if (cw->bw == bw)
+      return cw->weights;
+
+#pragma omp critical (ComputedWeights)
+  {
+    for (cw = computed_weights_list; cw; cw = cw->next)
+      if (cw->bw == bw)
+	break;
+
+    if (!cw)
+      {
+	weights = (double *) malloc(sizeof(double) * 4 * bw);
+	fudge = PI/((double)(4*bw));
+	for (j = 0; j < 2*bw; j++)
+	  {
+	    tmpsum = 0.0;
+	    for (k = 0; k < bw; k++)
+	      tmpsum += 1./((double)(2*k+1)) *
+		sin((double)((2*j+1)*(2*k+1))*fudge);
+	    tmpsum *= sin((double)(2*j+1)*fudge);
+	    tmpsum *= 2./((double) bw);
+
+	    weights[j] = tmpsum;
+	    weights[j + 2*bw] = tmpsum * sin((double)(2*j+1)*fudge);
+	  }
+
+	cw = (struct computed_weights *) malloc(sizeof(struct computed_weights));
+	cw->bw = bw;
+	cw->weights = weights;
+	/* only publish the entry once it is filled in (and visible) */
+	cw->next = computed_weights_list;
+#pragma omp flush
+	computed_weights_list = cw;
+#pragma omp flush
+      }
   }
+  return cw->weights;
 }
 
@@ -44,5 +44,7 @@
 
 extern const double *get_weights( int );
 
+extern const double *get_computed_weights( int );
+
 #endif /* _WEIGHTS_H */
 
@@ -39,12 +39,12 @@ DAMAGE.
 #include "Util/EDT.h"
 #include "Util/TriangleMesh.h"
 
-cmdLineString In1( "in1" ) , In2( "in2" ) , Out( "out" );
-cmdLineInt Resolution( "res" , 64 ) , AnisotropicScale( "aScale" , 0 ) , Threads( "threads" , omp_get_num_procs() );
+cmdLineString In1( "in1" ) , In2( "in2" ) , Out( "out" ) , Bundle( "bundle" );
+cmdLineInt Resolution( "res" , 64 ) , CoarseResolution( "coarseRes" , 32 ) , Candidates( "candidates" , 1 ) , AnisotropicScale( "aScale" , 0 ) , Threads( "threads" , omp_get_num_procs() );
 cmdLineFloat MomentRadiusScale( "radius" , 2.f ) , FallOff( "fallOff" , float( sqrt(8.) ) );
 cmdLineReadable GEDT( "gedt" ) , Double( "double" ) , Verbose( "verbose" );
 
-cmdLineReadable* params[] = { &In1 , &In2 , &Out , &AnisotropicScale , &Resolution , &Threads , &MomentRadiusScale , &GEDT , &FallOff , &Double , &Verbose , NULL };
+cmdLineReadable* params[] = { &In1 , &In2 , &Out , &Bundle , &AnisotropicScale , &Resolution , &CoarseResolution , &Candidates , &Threads , &MomentRadiusScale , &GEDT , &FallOff , &Double , &Verbose , NULL };
 
 void ShowUsage( const char* ex )
 {
@@ -52,7 +52,10 @@ void ShowUsage( const char* ex )
 	printf( "\t --%s <source mesh>\n" , In1.name );
 	printf( "\t --%s <target mesh>\n" , In2.name );
 	printf( "\t[--%s <aligned source mesh>]\n" , Out.name );
+	printf( "\t[--%s <precomputed transform bundle>]\n" , Bundle.name );
 	printf( "\t[--%s <voxel resolution>=%d]\n" , Resolution.name , Resolution.value );
+	printf( "\t[--%s <coarse rotation resolution>=%d]\n" , CoarseResolution.name , CoarseResolution.value );
+	printf( "\t[--%s <candidate extrema refined>=%d]\n" , Candidates.name , Candidates.value );
 	printf( "\t[--%s <threads>=%d]\n" , Threads.name , Threads.value );
 	printf( "\t[--%s <anisotropic scale>=%d]\n" , AnisotropicScale.name , AnisotropicScale.value );
 	printf( "\t[--%s <moment radius scale>=%f]\n" , MomentRadiusScale.name , MomentRadiusScale.value );
@@ -63,49 +66,53 @@ void ShowUsage( const char* ex )
 }
 
 template< class Real >
-void SetSphereKeys( const CubeGrid< Real >& grid , HarmonicTransform< Real >& xForm , std::vector< FourierKeyS2< Real > >& keys , int threads )
+void SetSphereKeys( const CubeGrid< Real >& grid , HarmonicTransform< Real >& xForm , FourierKeyS2Array< Real >& keys , int threads )
 {
 	int res = grid.resolution();
 	xForm.resize( res );
-	keys.resize( res/2 );
-	for( int i=0 ; i<res/2 ; i++ ) keys[i].resize( res );
-	SphericalGrid< Real > sGrid;
-	sGrid.resize( res );
+	std::vector< SphericalGrid< Real > > sGrids( res/2 );
 
 	Real radius = Real(res)/2;
 	Point3D< Real > center( radius , radius , radius );
 	for( int i=1 ; i<=res/2 ; i++ )
 	{
+		SphericalGrid< Real >& sGrid = sGrids[i-1];
+		sGrid.resize( res );
 		Real r = radius * Real(i)/(res/2);
 		grid.SphereSample( &center[0] , r , sGrid , threads );
 		Real scale = Real( sqrt( 4*M_PI*r*r ) );
 		Real* _sGrid = sGrid[0];
 #pragma omp parallel for num_threads( threads )
 		for( int j=0 ; j<sGrid.resolution()*sGrid.resolution() ; j++ ) _sGrid[j] *= scale;
-		xForm.ForwardFourier( sGrid , keys[i-1] );
 	}
+	// Transform all the shells together so that the Legendre tables are shared
+	xForm.ForwardFourier( sGrids , keys , res/2 );
 }
+
+// Refines the strongest local extrema of the correlation on the coarse grid, writing the rotation of the best one into "rotation"
 template< class Real >
-void AddWignerDCoefficients( const std::vector< FourierKeyS2< Real > >& inKeys1 , const std::vector< FourierKeyS2< Real > >& inKeys2 , FourierKeySO3< Real >& outKey , int threads=1 )
+Real RefineExtremum( WignerDSeries< Real >& series , const RotationGrid< Real >& grid , bool maximum , int candidates , SquareMatrix< Real , 4 >& rotation , int threads )
 {
-	for( int b=0 ; b<outKey.bandWidth() ; b++ ) if( inKeys1[0].bandWidth()>b && inKeys2[0].bandWidth()>b )
+	int res = grid.resolution();
+	// Candidates within two coarse cells of a stronger one are taken to be the same extremum
+	std::vector< typename RotationGrid< Real >::Peak > peaks;
+	grid.getPeaks( candidates , Real( 4.*PI/res ) , maximum , peaks , threads );
+
+	Real bestValue = 0;
+	for( int p=0 ; p<int( peaks.size() ) ; p++ )
 	{
-#pragma omp parallel for num_threads( threads )
-		for( int ij=0 ; ij<(b+1)*(b+1) ; ij++ )
+		Real theta = Real( 2.*PI*peaks[p].i/res ) , phi = Real( PI*(2.*peaks[p].j+1)/(2.*res) ) , psi = Real( 2.*PI*peaks[p].k/res );
+		// Start the search with a trust region of a coarse cell, and stop it well below the spacing of the full resolution grid
+		Real value = series.refine( theta , phi , psi , maximum , Real( 2.*PI/res ) , Real( PI/series.bandWidth()/8 ) );
+		if( !p || ( maximum ? value>bestValue : value<bestValue ) )
 		{
-			int i = ij / (b+1) , j = ij % (b+1);
-			Complex< Real > temp;
-			for( int k=0 ; k<inKeys1.size() && k<inKeys2.size() ; k++ ) temp += inKeys1[k](b,i).conjugate() * inKeys2[k](b,j);
-			outKey(b,i,j) += temp;
-
-			temp *= 0;
-			if( i && j )
-			{
-				for( int k=0 ; k<inKeys1.size() && k<inKeys2.size() ; k++ ) temp += inKeys1[k](b,i).conjugate() * inKeys2[k](b,j).conjugate();
-				outKey(b,i,-j) += temp;
-			}
+			Real matrix[3][3];
+			RotationGrid< Real >::SetCoordinates( theta , phi , psi , matrix );
+			for( int i=0 ; i<3 ; i++ ) for( int j=0 ; j<3 ; j++ ) rotation(i,j) = matrix[j][i];
+			bestValue = value;
 		}
 	}
+	return bestValue;
 }
 
 template< class Real >
@@ -146,7 +153,7 @@ SquareMatrix< Real , 3 > _main_( const std::vector< Point3D< Real > >& vertices1
 	if( Verbose.set ) printf( "\t\tEDT Time: %.2f(s)\n" , Time()-t );
 
 
-	std::vector< FourierKeyS2< Real > > rasterKey1 , rasterKey2 , edtKey1 , edtKey2 , gedtKey1 , gedtKey2;
+	FourierKeyS2Array< Real > rasterKey1 , rasterKey2 , edtKey1 , edtKey2 , gedtKey1 , gedtKey2;
 	t = Time();
 	{
 		HarmonicTransform< Real > xForm;
@@ -167,40 +174,36 @@ SquareMatrix< Real , 3 > _main_( const std::vector< Point3D< Real > >& vertices1
 	if( Verbose.set ) printf( "\t\tHarmonic Key Time: %.2f(s)\n" , Time()-t );
 
 
+	// Find the candidate extrema on a coarse grid, sampling the truncation of the correlation to the coarse band-width,
+	// and then refine them by evaluating the full correlation directly at off-grid rotations
 	RotationGrid< Real > so3Grid;
+	WignerDSeries< Real > series;
 	Real norm2 = 0;
 	t = Time();
 	{
 		WignerDTransform< Real > xForm;
-		FourierKeySO3< Real > key;
-		xForm.resize( Resolution.value );
+		FourierKeySO3< Real > key , coarseKey;
+		int coarseRes = std::min< int >( CoarseResolution.value , Resolution.value );
+		xForm.resize( coarseRes );
 		key.resize( Resolution.value );
-		if( GEDT.set ) AddWignerDCoefficients( gedtKey1 , gedtKey2 , key , Threads.value );
-		else           AddWignerDCoefficients( rasterKey1 , edtKey2 , key , Threads.value ) , AddWignerDCoefficients( edtKey1 , rasterKey2 , key , Threads.value );
-		if( GEDT.set ) for( int r=0 ; r<Resolution.value/2 ; r++ ) norm2 += gedtKey1[r].squareNorm() + gedtKey2[r].squareNorm();
-		xForm.InverseFourier( key , so3Grid );
+		// Accumulate the coefficients in the normalization of the inverse transform, so that it can read them in place
+		key.setSOFTNative( true );
+		if( GEDT.set ) key.addCorrelation( gedtKey1 , gedtKey2 , Threads.value );
+		else           key.addCorrelation( rasterKey1 , edtKey2 , Threads.value ) , key.addCorrelation( edtKey1 , rasterKey2 , Threads.value );
+		if( GEDT.set ) norm2 += gedtKey1.squareNorm() + gedtKey2.squareNorm();
+		key.truncate( coarseRes , coarseKey );
+		xForm.InverseFourier( coarseKey , so3Grid , Threads.value );
+		series.set( key );
 	}
 	if( Verbose.set ) printf( "\t\tWigner-D Time: %.2f(s)\n" , Time()-t );
 
+	// Only the extremum that is returned needs to be refined, unless both are reported
 	SquareMatrix< Real , 4 > minRotation=SquareMatrix< Real , 4 >::Identity() , maxRotation=SquareMatrix< Real , 4 >::Identity();
 	Real minCorrelation=0 , maxCorrelation=0;
-	for( int i=0 ; i<Resolution.value ; i++ ) for( int j=0 ; j<Resolution.value ; j++ ) for( int k=0 ; k<Resolution.value ; k++ )
-	{
-		if( (!i && !j && !k) || so3Grid(i,j,k)<minCorrelation )
-		{
-			Real matrix[3][3];
-			so3Grid.setCoordinates( i , j , k , matrix );
-			for( int ii=0 ; ii<3 ; ii++ ) for( int jj=0 ; jj<3 ; jj++ ) minRotation(ii,jj) = matrix[jj][ii];
-			minCorrelation = so3Grid(i,j,k);
-		}
-		if( (!i && !j && !k) || so3Grid(i,j,k)>maxCorrelation )
-		{
-			Real matrix[3][3];
-			so3Grid.setCoordinates( i , j , k , matrix );
-			for( int ii=0 ; ii<3 ; ii++ ) for( int jj=0 ; jj<3 ; jj++ ) maxRotation(ii,jj) = matrix[jj][ii];
-			maxCorrelation = so3Grid(i,j,k);
-		}
-	}
+	t = Time();
+	if(  GEDT.set || Verbose.set ) maxCorrelation = RefineExtremum( series , so3Grid , true  , Candidates.value , maxRotation , Threads.value );
+	if( !GEDT.set || Verbose.set ) minCorrelation = RefineExtremum( series , so3Grid , false , Candidates.value , minRotation , Threads.value );
+	if( Verbose.set ) printf( "\t\tRefinement Time: %.2f(s)\n" , Time()-t );
 	if( GEDT.set )
 	{
 		if( Verbose.set ) printf( "\tMin/Max Error: %e / %e\n" , sqrt( norm2 - maxCorrelation*2 ) , sqrt( norm2 - minCorrelation*2 ) );
@@ -278,6 +281,7 @@ int main( int argc , char* argv[] )
 		ShowUsage( argv[0] );
 		return EXIT_FAILURE;
 	}
+	if( Bundle.set && !TransformBundle::Load( Bundle.value ) ) fprintf( stderr , "[WARNING] Failed to load transform bundle: %s\n" , Bundle.value );
 
 	int ret;
 	double t = Time();
@@ -0,0 +1,163 @@
+/*
+Copyright (c) 2013, Michael Kazhdan
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list of
+conditions and the following disclaimer. Redistributions in binary form must reproduce
+the above copyright notice, this list of conditions and the following disclaimer
+in the documentation and/or other materials provided with the distribution.
+
+Neither the name of the Johns Hopkins University nor the names of its contributors
+may be used to endorse or promote products derived from this software without specific
+prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+DAMAGE.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <omp.h>
+
+#include "Util/cmdLineParser.h"
+#include "Util/Util.h"
+#include "SignalProcessing/Fourier.h"
+#include <cospmls.h>
+#include <SOFT1.0/makeWigner.h>
+
+cmdLineString Out( "out" );
+cmdLineInts Resolutions( "res" );
+cmdLineReadable NoWigner( "noWigner" ) , NoWisdom( "noWisdom" ) , Tune( "tune" ) , Verbose( "verbose" );
+
+cmdLineReadable* params[] = { &Out , &Resolutions , &NoWigner , &NoWisdom , &Tune , &Verbose , NULL };
+
+void ShowUsage( const char* ex )
+{
+	printf( "Usage %s:\n" , ex );
+	printf( "\t --%s <output bundle>\n" , Out.name );
+	printf( "\t[--%s <number of resolutions> <resolution 1> ... <resolution n>=64]\n" , Resolutions.name );
+	printf( "\t[--%s]\n" , NoWigner.name );
+	printf( "\t[--%s]\n" , NoWisdom.name );
+	printf( "\t[--%s]\n" , Tune.name );
+	printf( "\t[--%s]\n" , Verbose.name );
+}
+
+// Adds the Legendre tables of the given precision to the bundle
+// (The tables are owned by the process-wide cache and remain valid until the bundle is written.)
+template< class Real >
+void AddLegendreTables( int bw , std::vector< TransformBundle::EntryData >& entries )
+{
+	const LegendreTables< Real >* tables = LegendreTables< Real >::Acquire( bw );
+	size_t size = sizeof(Real) * Spharmonic_TableSize( bw );
+	entries.push_back( TransformBundle::EntryData( TransformBundle::LEGENDRE_TABLE , bw , sizeof(Real) , tables->table[0] , size ) );
+	entries.push_back( TransformBundle::EntryData( TransformBundle::TRANSPOSE_LEGENDRE_TABLE , bw , sizeof(Real) , tables->transposeTable[0] , size ) );
+}
+
+// Plans the transforms that the applications create at the given resolution, so that the wisdom is accumulated
+template< class Real >
+void PlanTransforms( int res , bool measure )
+{
+	HarmonicTransform< Real > hForm( res , measure );
+	// The applications transform one spherical function per radius
+	std::vector< SphericalGrid< Real > > sGrids( res/2 );
+	std::vector< FourierKeyS2< Real > > keys( res/2 );
+	for( int i=0 ; i<sGrids.size() ; i++ ) sGrids[i].resize( res );
+	hForm.ForwardFourier( sGrids , keys );
+	WignerDTransform< Real > wForm;
+	wForm.resize( res , measure );
+}
+
+// Measures the fastest Legendre engine for each order at the given resolution, and adds it to the bundle
+template< class Real >
+void AddLegendreProfile( int res , bool measure , std::vector< int >& engines , std::vector< TransformBundle::EntryData >& entries )
+{
+	// The applications transform one spherical function per radius
+	HarmonicTransform< Real >::TuneLegendreEngines( res , res/2 , engines , 0.005 , measure );
+	entries.push_back( TransformBundle::EntryData( TransformBundle::LEGENDRE_PROFILE , res/2 , sizeof(Real) , &engines[0] , sizeof(int)*engines.size() ) );
+	if( Verbose.set )
+	{
+		int counts[] = { 0 , 0 , 0 };
+		for( int m=0 ; m<engines.size() ; m++ ) counts[ engines[m] ]++;
+		printf( "\t%s orders: %d seminaive, %d fast, %d naive\n" , sizeof(Real)==sizeof(float) ? "Float" : "Double" , counts[ HarmonicTransform< Real >::SEMINAIVE ] , counts[ HarmonicTransform< Real >::FAST_LEGENDRE ] , counts[ HarmonicTransform< Real >::NAIVE ] );
+	}
+}
+
+int main( int argc , char* argv[] )
+{
+	cmdLineParse( argc , argv , params , std::vector< std::string >() );
+	if( !Out.set )
+	{
+		ShowUsage( argv[0] );
+		return EXIT_FAILURE;
+	}
+	std::vector< int > resolutions;
+	if( Resolutions.set ) for( int i=0 ; i<Resolutions.count ; i++ ) resolutions.push_back( Resolutions.values[i] );
+	else resolutions.push_back( 64 );
+	for( int i=0 ; i<resolutions.size() ; i++ ) if( resolutions[i]<2 || ( resolutions[i] & 3 ) )
+	{
+		fprintf( stderr , "[ERROR] Resolution must be a multiple of four: %d\n" , resolutions[i] );
+		return EXIT_FAILURE;
+	}
+
+	double t = Time();
+	std::vector< TransformBundle::EntryData > entries;
+	std::vector< std::vector< double > > wigners( resolutions.size() );
+	for( int i=0 ; i<resolutions.size() ; i++ )
+	{
+		int bw = resolutions[i]/2;
+		AddLegendreTables< float  >( bw , entries );
+		AddLegendreTables< double >( bw , entries );
+		if( !NoWigner.set )
+		{
+			std::vector< double > workSpace( 24*bw );
+			wigners[i].resize( TransformBundle::WignerDTableSize( bw ) );
+			genWigAllTrans( bw , &wigners[i][0] , &workSpace[0] );
+			entries.push_back( TransformBundle::EntryData( TransformBundle::WIGNER_D_TABLE , bw , sizeof(double) , &wigners[i][0] , sizeof(double)*wigners[i].size() ) );
+		}
+		if( Verbose.set ) printf( "Computed tables for resolution %d: %.2f(s)\n" , resolutions[i] , Time()-t );
+	}
+
+	char *wisdom = NULL , *wisdomf = NULL;
+	if( !NoWisdom.set )
+	{
+		for( int i=0 ; i<resolutions.size() ; i++ )
+		{
+			PlanTransforms< float  >( resolutions[i] , true );
+			PlanTransforms< double >( resolutions[i] , true );
+			if( Verbose.set ) printf( "Planned transforms for resolution %d: %.2f(s)\n" , resolutions[i] , Time()-t );
+		}
+		// Store the null-terminated wisdom strings
+		wisdom  = fftw_export_wisdom_to_string ( );
+		wisdomf = fftwf_export_wisdom_to_string( );
+		if( wisdom  ) entries.push_back( TransformBundle::EntryData( TransformBundle::FFTW_WISDOM , 0 , sizeof(double) , wisdom  , strlen( wisdom  )+1 ) );
+		if( wisdomf ) entries.push_back( TransformBundle::EntryData( TransformBundle::FFTW_WISDOM , 0 , sizeof(float ) , wisdomf , strlen( wisdomf )+1 ) );
+	}
+
+	// The Legendre profiles are measured after planning, so that the transforms use the same plans as the applications
+	std::vector< std::vector< int > > profiles( 2*resolutions.size() );
+	if( Tune.set )
+	{
+		for( int i=0 ; i<resolutions.size() ; i++ )
+		{
+			AddLegendreProfile< float  >( resolutions[i] , !NoWisdom.set , profiles[2*i  ] , entries );
+			AddLegendreProfile< double >( resolutions[i] , !NoWisdom.set , profiles[2*i+1] , entries );
+			if( Verbose.set ) printf( "Tuned transforms for resolution %d: %.2f(s)\n" , resolutions[i] , Time()-t );
+		}
+	}
+
+	int ret = TransformBundle::Write( Out.value , entries ) ? EXIT_SUCCESS : EXIT_FAILURE;
+	if( wisdom  ) free( wisdom  );
+	if( wisdomf ) free( wisdomf );
+	if( Verbose.set ) printf( "Running Time: %.2f(s)\n" , Time()-t );
+	return ret;
+}
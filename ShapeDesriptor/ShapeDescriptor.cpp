@@ -43,18 +43,19 @@ DAMAGE.
 #include "Util/SphericalPolynomials.h"
 #include "Util/Signature.h"
 
-cmdLineString In( "in" ) , Out( "out" );
+cmdLineString In( "in" ) , Out( "out" ) , Bundle( "bundle" );
 cmdLineInt Resolution( "res" , 64 ) , BandWidth( "bw" , 16 ) , Radii( "radii" , 32 ) , AnisotropicScale( "aScale" , 0 ) , Threads( "threads" , omp_get_num_procs() );
 cmdLineFloat MomentRadiusScale( "radius" , 2.f ) , FallOff( "fallOff" , float(sqrt(8.)) );
-cmdLineReadable NoCQ( "noCQ" ) , Double( "double" ) , Verbose( "verbose" ) , Binary( "binary" );
+cmdLineReadable NoCQ( "noCQ" ) , Double( "double" ) , Verbose( "verbose" ) , Binary( "binary" ) , Prefilter( "prefilter" );
 
-cmdLineReadable* params[] = { &In , &Out , &Resolution , &BandWidth , &Radii , &AnisotropicScale , &Threads , &MomentRadiusScale , &FallOff , &NoCQ , &Double , &Verbose , &Binary , NULL };
+cmdLineReadable* params[] = { &In , &Out , &Bundle , &Resolution , &BandWidth , &Radii , &AnisotropicScale , &Threads , &MomentRadiusScale , &FallOff , &NoCQ , &Double , &Verbose , &Binary , &Prefilter , NULL };
 
 void ShowUsage( const char* ex )
 {
 	printf( "Usage %s:\n" , ex );
 	printf( "\t --%s <input mesh>\n" , In.name );
 	printf( "\t[--%s <output signature>]\n" , Out.name );
+	printf( "\t[--%s <precomputed transform bundle>]\n" , Bundle.name );
 	printf( "\t[--%s <voxel resolution>=%d]\n" , Resolution.name , Resolution.value );
 	printf( "\t[--%s <sph band-width>=%d]\n" , BandWidth.name , BandWidth.value );
 	printf( "\t[--%s <sampling radii>=%d]\n" , Radii.name , Radii.value );
@@ -63,6 +64,7 @@ void ShowUsage( const char* ex )
 	printf( "\t[--%s <moment radius scale>=%f]\n" , MomentRadiusScale.name , MomentRadiusScale.value );
 	printf( "\t[--%s <Gaussian EDT fall off>=%f]\n" , FallOff.name , FallOff.value );
 	printf( "\t[--%s]\n" , NoCQ.name );
+	printf( "\t[--%s]\n" , Prefilter.name );
 	printf( "\t[--%s]\n" , Double.name );
 	printf( "\t[--%s]\n" , Binary.name );
 	printf( "\t[--%s]\n" , Verbose.name );
@@ -90,7 +92,7 @@ int run( void )
 
 	CubeGrid< char > grid;
 	CubeGrid< Real > gedt;
-	std::vector< FourierKeyS2< Real > > sKeys;
+	FourierKeyS2Array< Real > sKeys;
 	double t;
 
 	// Compute the rasterization
@@ -113,42 +115,55 @@ int run( void )
 	{
 		Real radius = Real(Resolution.value)/2;
 		Point3D< Real > center = Point3D< Real >( radius , radius , radius );
-		SampleSpheres( gedt , sKeys , center , radius , Radii.value , Resolution.value , Threads.value );
-		
-		Real norm = 0;
-		for( int i=0 ; i<sKeys.size() ; i++ ) norm += sKeys[i].squareNorm();
-		norm = Real( sqrt(norm) );
-		for( int i=0 ; i<sKeys.size() ; i++ ) sKeys[i] /= norm;
+		std::vector< SphericalGrid< Real > > spheres;
+		if( Prefilter.set )
+		{
+			CubeGridPyramid< Real > pyramid( gedt , Threads.value );
+			SubSampleSpheres( pyramid , spheres , center , radius , Radii.value , Resolution.value , Threads.value );
+		}
+		else SampleSpheres( gedt , spheres , center , radius , Radii.value , Resolution.value , Threads.value );
+
+		// Only compute the frequencies used by the signature (the constant and quadratic terms need the first three)
+		HarmonicTransform< Real > xForm( Resolution.value );
+		xForm.ForwardFourier( spheres , sKeys , NoCQ.set ? BandWidth.value : std::max< int >( BandWidth.value , 3 ) );
+
+		// The shells are normalized by their full energy, which is integrated over the samples (by Parseval, this is the
+		// energy of all the frequencies of band-limited shells) rather than summed over the coefficients
+		double norm2 = 0;
+		for( int i=0 ; i<spheres.size() ; i++ ) norm2 += spheres[i].squareNorm();
+		Real norm = Real( sqrt( norm2 ) );
+		sKeys /= norm;
 	}
 	if( Verbose.set ) printf( "\tSpherical Harmonic time: %.2f(s)\n" , Time()-t );
 
 	// Compute the signature
 	if( Out.set )
 	{
-		int bw = BandWidth.value;
-		Signature< Real > sig( !NoCQ.set ? (bw+1) * int( sKeys.size() ) : bw * int( sKeys.size() ) );
-		for( int i=0 ; i<sKeys.size() ; i++ )
-			if( !NoCQ.set )
+		int bw = BandWidth.value , shells = sKeys.shells();
+		Signature< Real > sig( !NoCQ.set ? (bw+1) * shells : bw * shells );
+		// The norms of each frequency are computed for all the shells at once
+		std::vector< Real > norms2( shells );
+		if( !NoCQ.set )
+		{
+			FourierKeyS2< Real > key( 6 );
+			for( int i=0 ; i<shells ; i++ )
+			{
+				sKeys.get( i , key );
+				Point3D< Real > cq = ConstantAndQuadratic( key );
+				for( int j=0 ; j<3 ; j++ ) sig[i*(bw+1)+j] = cq[j];
+			}
+			for( int b=0 , idx=3 ; b<bw ; b++ ) if( b!=0 && b!=2 )
 			{
-				int idx = 0;
-				Point3D< Real > cq = ConstantAndQuadratic( sKeys[i] );
-				for( int j=0 ; j<3 ; j++ ) sig[i*(bw+1)+idx ] = cq[j] , idx++;
-				for( int b=0 ; b<bw ; b++ ) if( b!=0 && b!=2 )
-				{
-					Real _norm2 = sKeys[i](b,0).squareNorm();
-					for( int j=1 ; j<=b ; j++ ) _norm2 += sKeys[i](b,j).squareNorm()*2;
-					sig[i*(bw+1)+idx] = Real( sqrt(_norm2) );
-					idx++;
-				}
+				sKeys.squareNorms( b , &norms2[0] );
+				for( int i=0 ; i<shells ; i++ ) sig[i*(bw+1)+idx] = Real( sqrt( norms2[i] ) );
+				idx++;
 			}
-			else
+		}
+		else
+			for( int b=0 ; b<bw ; b++ )
 			{
-				for( int b=0 ; b<bw ; b++ )
-				{
-					Real _norm2 = sKeys[i](b,0).squareNorm();
-					for( int j=1 ; j<=b ; j++ ) _norm2 += sKeys[i](b,j).squareNorm()*2;
-					sig[i*bw+b] = Real( sqrt(_norm2) );
-				}
+				sKeys.squareNorms( b , &norms2[0] );
+				for( int i=0 ; i<shells ; i++ ) sig[i*bw+b] = Real( sqrt( norms2[i] ) );
 			}
 		sig.write( Out.value , Binary.set );
 	}
@@ -162,6 +177,7 @@ int main( int argc , char* argv[] )
 		ShowUsage( argv[0] );
 		return EXIT_FAILURE;
 	}
+	if( Bundle.set && !TransformBundle::Load( Bundle.value ) ) fprintf( stderr , "[WARNING] Failed to load transform bundle: %s\n" , Bundle.value );
 	if( BandWidth.value>Resolution.value/2 )
 	{
 		fprintf( stderr , "[WARNING] Resetting band-width: %d -> %d\n" , BandWidth.value , Resolution.value/2 );
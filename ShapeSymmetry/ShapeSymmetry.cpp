@@ -39,18 +39,19 @@ DAMAGE.
 #include "Util/EDT.h"
 #include "Util/TriangleMesh.h"
 
-cmdLineString In( "in" ) , OutHeader( "out" );
+cmdLineString In( "in" ) , OutHeader( "out" ) , Bundle( "bundle" );
 cmdLineInt Resolution( "res" , 64 ) , Threads( "threads" , omp_get_num_procs() ) , MaxRotationalSymmetry( "maxSym" , 6 );
 cmdLineFloat MomentRadiusScale( "radius" , 2.f ) , FallOff( "fallOff" , float( sqrt(8.) ) );
 cmdLineReadable GEDT( "gedt" ) , Double( "double" ) , Verbose( "verbose" );
 
-cmdLineReadable* params[] = { &In , &OutHeader , &Resolution , &Threads , &MomentRadiusScale , &GEDT , &FallOff , &Double , &MaxRotationalSymmetry , &Verbose , NULL };
+cmdLineReadable* params[] = { &In , &OutHeader , &Bundle , &Resolution , &Threads , &MomentRadiusScale , &GEDT , &FallOff , &Double , &MaxRotationalSymmetry , &Verbose , NULL };
 
 void ShowUsage( const char* ex )
 {
 	printf( "Usage %s:\n" , ex );
 	printf( "\t --%s <source mesh>\n" , In.name );
 	printf( "\t[--%s <output header>]\n" , OutHeader.name );
+	printf( "\t[--%s <precomputed transform bundle>]\n" , Bundle.name );
 	printf( "\t[--%s <voxel resolution>=%d]\n" , Resolution.name , Resolution.value );
 	printf( "\t[--%s <threads>=%d]\n" , Threads.name , Threads.value );
 	printf( "\t[--%s <moment radius scale>=%f]\n" , MomentRadiusScale.name , MomentRadiusScale.value );
@@ -62,51 +63,74 @@ void ShowUsage( const char* ex )
 }
 
 template< class Real >
-void SetSphereKeys( const CubeGrid< Real >& grid , HarmonicTransform< Real >& xForm , std::vector< FourierKeyS2< Real > >& keys , int threads )
+void SetSphereKeys( const CubeGrid< Real >& grid , HarmonicTransform< Real >& xForm , FourierKeyS2Array< Real >& keys , int threads )
 {
 	int res = grid.resolution();
 	xForm.resize( res );
-	keys.resize( res/2 );
-	for( int i=0 ; i<res/2 ; i++ ) keys[i].resize( res );
-	SphericalGrid< Real > sGrid;
-	sGrid.resize( res );
+	std::vector< SphericalGrid< Real > > sGrids( res/2 );
 
 	Real radius = Real(res)/2;
 	Point3D< Real > center( radius , radius , radius );
 	for( int i=1 ; i<=res/2 ; i++ )
 	{
+		SphericalGrid< Real >& sGrid = sGrids[i-1];
+		sGrid.resize( res );
 		Real r = radius * Real(i)/(res/2);
 		grid.SphereSample( &center[0] , r , sGrid , threads );
 		Real scale = Real( sqrt( 4*M_PI*r*r ) );
 		Real* _sGrid = sGrid[0];
 #pragma omp parallel for num_threads( threads )
 		for( int j=0 ; j<sGrid.resolution()*sGrid.resolution() ; j++ ) _sGrid[j] *= scale;
-		xForm.ForwardFourier( sGrid , keys[i-1] );
 	}
+	// Transform all the shells together so that the Legendre tables are shared
+	xForm.ForwardFourier( sGrids , keys , res/2 );
 }
+// Sets the grid indices of the d rotations about the axis by multiples of 2PI/d.
+// The rotations are computed in double precision, from the quaternion (cos(angle/2),sin(angle/2)*axis). Since the rotation
+// by 2PI-angle is the transpose of the rotation by angle, its Euler angles (theta,phi,psi) are (PI-psi,phi,PI-theta), so
+// they are only extracted for half of the turns.
 template< class Real >
-void AddWignerDCoefficients( const std::vector< FourierKeyS2< Real > >& inKeys1 , const std::vector< FourierKeyS2< Real > >& inKeys2 , FourierKeySO3< Real >& outKey1 , FourierKeySO3< Real >& outKey2 , int threads=1 )
+void SetOrbitCoordinates( int res , const double axis[3] , int d , Real* x , Real* y , Real* z )
 {
-	for( int b=0 ; b<outKey1.bandWidth() && b<outKey2.bandWidth() ; b++ ) if( inKeys1[0].bandWidth()>b && inKeys2[0].bandWidth()>b )
+	for( int k=0 ; 2*k<=d ; k++ )
 	{
-		Real sign = Real( (b%2) ? -1 : 1 );
-#pragma omp parallel for num_threads( threads )
-		for( int ij=0 ; ij<(b+1)*(b+1) ; ij++ )
+		double angle = 2.0*PI*k/d , matrix[3][3] , theta , phi , psi;
+		double a = cos( angle/2 ) , s = sin( angle/2 );
+		double b = axis[0]*s , c = axis[1]*s , e = axis[2]*s;
+		matrix[0][0] = 1 - 2*c*c - 2*e*e , matrix[1][0] = 2*b*c - 2*a*e , matrix[2][0] = 2*b*e + 2*a*c;
+		matrix[0][1] = 2*b*c + 2*a*e , matrix[1][1] = 1 - 2*b*b - 2*e*e , matrix[2][1] = 2*c*e - 2*a*b;
+		matrix[0][2] = 2*b*e - 2*a*c , matrix[1][2] = 2*c*e + 2*a*b , matrix[2][2] = 1 - 2*b*b - 2*c*c;
+		RotationGrid< double >::SetCoordinates( matrix , theta , phi , psi );
+		x[k] = Real( (theta*res)/(2.0*PI) ) , y[k] = Real( (2.0*res*phi-PI)/(2.0*PI) ) , z[k] = Real( (psi*res)/(2.0*PI) );
+		// (At the poles, where the Euler angles are degenerate, the indices of the transpose are extracted as well)
+		if( k && 2*k<d )
 		{
-			int i = ij / (b+1) , j = ij % (b+1);
-			Complex< Real > temp;
-			for( int k=0 ; k<inKeys1.size() && k<inKeys2.size() ; k++ ) temp += inKeys1[k](b,i).conjugate() * inKeys2[k](b,j);
-			outKey1(b,i,j) += temp , outKey2(b,i,j) += temp * sign;
-
-			temp *= 0;
-			if( i && j )
+			if( sqrt( matrix[1][2]*matrix[1][2] + matrix[1][0]*matrix[1][0] )>16*FLT_EPSILON )
+			{
+				// Keep the angles in (-PI,PI], so that the samples stay in the interior of the grid
+				double _theta = PI-psi , _psi = PI-theta;
+				if( _theta>PI ) _theta -= 2.0*PI;
+				if( _psi>PI ) _psi -= 2.0*PI;
+				x[d-k] = Real( (_theta*res)/(2.0*PI) ) , y[d-k] = y[k] , z[d-k] = Real( (_psi*res)/(2.0*PI) );
+			}
+			else
 			{
-				for( int k=0 ; k<inKeys1.size() && k<inKeys2.size() ; k++ ) temp += inKeys1[k](b,i).conjugate() * inKeys2[k](b,j).conjugate();
-				outKey1(b,i,-j) += temp , outKey2(b,i,-j) += temp * sign;
+				double transpose[3][3];
+				for( int ii=0 ; ii<3 ; ii++ ) for( int jj=0 ; jj<3 ; jj++ ) transpose[ii][jj] = matrix[jj][ii];
+				RotationGrid< double >::SetCoordinates( transpose , theta , phi , psi );
+				x[d-k] = Real( (theta*res)/(2.0*PI) ) , y[d-k] = Real( (2.0*res*phi-PI)/(2.0*PI) ) , z[d-k] = Real( (psi*res)/(2.0*PI) );
 			}
 		}
 	}
 }
+template< class Real >
+Real SumSamples( const Real* samples , int d )
+{
+	Real sum = 0;
+	for( int k=0 ; k<d ; k++ ) sum += samples[k];
+	return sum;
+}
+
 template< class Real >
 void _main_( const std::vector< Point3D< Real > >& vertices , const std::vector< TriangleIndex >& triangles , SphericalGrid< Real >& axialSymmetry , SphericalGrid< Real >& refSymmetry , std::vector< SphericalGrid< Real > >& rotSymmetry )
 {
@@ -135,7 +159,7 @@ void _main_( const std::vector< Point3D< Real > >& vertices , const std::vector<
 	else            SquaredEDT( grid , sqr_edt , Threads.value );
 	if( Verbose.set ) printf( "\t\tEDT Time: %.2f(s)\n" , Time()-t );
 
-	std::vector< FourierKeyS2< Real > > rasterKey , edtKey , gedtKey;
+	FourierKeyS2Array< Real > rasterKey , edtKey , gedtKey;
 	t = Time();
 	{
 		HarmonicTransform< Real > xForm;
@@ -145,15 +169,13 @@ void _main_( const std::vector< Point3D< Real > >& vertices , const std::vector<
 	}
 	if( GEDT.set )
 	{
-		Real norm = 0;
-		for( int i=0 ; i<gedtKey.size() ; i++ ) norm += gedtKey[i].squareNorm();
-		norm = Real( sqrt(norm) );
-		for( int i=0 ; i<gedtKey.size() ; i++ ) gedtKey[i] /= norm;
+		Real norm = Real( sqrt( gedtKey.squareNorm() ) );
+		gedtKey /= norm;
 	}
 	else
 	{
 		Real norm = raster.squareNorm();
-		for( int i=0 ; i<rasterKey.size() ; i++ ) rasterKey[i] /= norm , edtKey[i] /= Real(Resolution.value * Resolution.value);
+		rasterKey /= norm , edtKey /= Real(Resolution.value * Resolution.value);
 	}
 	if( Verbose.set ) printf( "\t\tHarmonic Key Time: %.2f(s)\n" , Time()-t );
 
@@ -164,11 +186,13 @@ void _main_( const std::vector< Point3D< Real > >& vertices , const std::vector<
 		FourierKeySO3< Real > key1 , key2;
 		xFormSO3.resize( Resolution.value );
 		key1.resize( Resolution.value ) , key2.resize( Resolution.value );
-		if( GEDT.set ) AddWignerDCoefficients(   gedtKey , gedtKey , key1 , key2 , Threads.value );
-		else           AddWignerDCoefficients( rasterKey ,  edtKey , key1 , key2 , Threads.value );
+		// Accumulate the coefficients in the normalization of the inverse transform, so that it can read them in place
+		key1.setSOFTNative( true ) , key2.setSOFTNative( true );
+		if( GEDT.set ) key1.addCorrelation(   gedtKey , gedtKey , Threads.value , &key2 );
+		else           key1.addCorrelation( rasterKey ,  edtKey , Threads.value , &key2 );
 		// Since we are correlating a shape with itself, the symmetric contribution is the same,
 		// as it just reorders the group elements before summing the dot-products
-		xFormSO3.InverseFourier( key1 , so3Grid1 ) , xFormSO3.InverseFourier( key2 , so3Grid2 );
+		xFormSO3.InverseFourier( key1 , so3Grid1 , Threads.value ) , xFormSO3.InverseFourier( key2 , so3Grid2 , Threads.value );
 	}
 	if( Verbose.set ) printf( "\t\tWigner-D Time: %.2f(s)\n" , Time()-t );
 
@@ -177,52 +201,33 @@ void _main_( const std::vector< Point3D< Real > >& vertices , const std::vector<
 		axialSymmetry.resize( Resolution.value );
 		refSymmetry.resize( Resolution.value );
 		for( int i=0 ; i<rotSymmetry.size() ; i++ ) rotSymmetry[i].resize( Resolution.value );
-#pragma omp parallel for num_threads( Threads.value )
-		for( int ij=0 ; ij<(Resolution.value/2)*Resolution.value ; ij++ )
+		// The rotations sampled for a point are the two of the reflection (the second of which is sampled from the second
+		// grid), followed by the turns of the rotational symmetries and the turns of the axial symmetry
+		int count = 2;
+		for( int d=2 ; d<rotSymmetry.size()+2 ; d++ ) count += d;
+		count += Resolution.value;
+#pragma omp parallel num_threads( Threads.value )
 		{
-			int i = ij / Resolution.value , j = ij % Resolution.value;
-			int _i = i+Resolution.value/2 , _j = Resolution.value-1-j;
-			Point3D< Real > p;
-			refSymmetry.setCoordinates( i , j , &p[0] );
-			{
-				int d=2;
-				Real temp=0;
-				for( int k=0 ; k<d ; k++ )
-				{
-					SquareMatrix< Real , 3 > rot = RotationMatrix< Real >( p , Real(2.*M_PI/d)*k );
-					Real x , y , z , R[3][3];
-					for( int ii=0 ; ii<3 ; ii++ ) for( int jj=0 ; jj<3 ; jj++ ) R[ii][jj] = rot(ii,jj);
-					so3Grid2.setCoordinates( R , x , y , z );
-					if( k%2 ) temp += so3Grid2.sample( x , y , z );
-					else      temp += so3Grid1.sample( x , y , z );
-				}
-				refSymmetry(i,j) = refSymmetry(_i,_j) = temp/d;
-			}
-			for( int d=2 ; d<rotSymmetry.size()+2 ; d++ )
+			std::vector< Real > x( count ) , y( count ) , z( count ) , samples( count );
+#pragma omp for
+			for( int ij=0 ; ij<(Resolution.value/2)*Resolution.value ; ij++ )
 			{
-				Real temp=0;
-				for( int k=0 ; k<d ; k++ )
-				{
-					SquareMatrix< Real , 3 > rot = RotationMatrix< Real >( p , Real(2.*M_PI/d)*k );
-					Real x , y , z , R[3][3];
-					for( int ii=0 ; ii<3 ; ii++ ) for( int jj=0 ; jj<3 ; jj++ ) R[ii][jj] = rot(ii,jj);
-					so3Grid1.setCoordinates( R , x , y , z );
-					temp += so3Grid1.sample( x , y , z );
-				}
-				rotSymmetry[d-2](i,j) = rotSymmetry[d-2](_i,_j) = temp/d;
-			}
-			{
-				int d=Resolution.value;
-				Real temp=0;
-				for( int k=0 ; k<d ; k++ )
-				{
-					SquareMatrix< Real , 3 > rot = RotationMatrix< Real >( p , Real(2.*M_PI/d)*k );
-					Real x , y , z , R[3][3];
-					for( int ii=0 ; ii<3 ; ii++ ) for( int jj=0 ; jj<3 ; jj++ ) R[ii][jj] = rot(ii,jj);
-					so3Grid1.setCoordinates( R , x , y , z );
-					temp += so3Grid1.sample( x , y , z );
-				}
-				axialSymmetry(i,j) = axialSymmetry(_i,_j) = temp/d;
+				int i = ij / Resolution.value , j = ij % Resolution.value;
+				int _i = i+Resolution.value/2 , _j = Resolution.value-1-j;
+				double p[3];
+				SphericalGrid< double >::SetCoordinates( 2.0*PI*i/Resolution.value , PI*(2.0*j+1)/(2.0*Resolution.value) , p );
+				int offset = 0;
+				SetOrbitCoordinates( Resolution.value , p , 2 , &x[offset] , &y[offset] , &z[offset] ) , offset += 2;
+				for( int d=2 ; d<rotSymmetry.size()+2 ; d++ ) SetOrbitCoordinates( Resolution.value , p , d , &x[offset] , &y[offset] , &z[offset] ) , offset += d;
+				SetOrbitCoordinates( Resolution.value , p , Resolution.value , &x[offset] , &y[offset] , &z[offset] );
+				so3Grid1.sample( 1 , &x[0] , &y[0] , &z[0] , &samples[0] );
+				so3Grid2.sample( 1 , &x[1] , &y[1] , &z[1] , &samples[1] );
+				so3Grid1.sample( count-2 , &x[2] , &y[2] , &z[2] , &samples[2] );
+
+				offset = 0;
+				refSymmetry(i,j) = refSymmetry(_i,_j) = SumSamples( &samples[offset] , 2 )/2 , offset += 2;
+				for( int d=2 ; d<rotSymmetry.size()+2 ; d++ ) rotSymmetry[d-2](i,j) = rotSymmetry[d-2](_i,_j) = SumSamples( &samples[offset] , d )/d , offset += d;
+				axialSymmetry(i,j) = axialSymmetry(_i,_j) = SumSamples( &samples[offset] , Resolution.value )/Resolution.value;
 			}
 		}
 	}
@@ -301,6 +306,7 @@ int main( int argc , char* argv[] )
 		ShowUsage( argv[0] );
 		return EXIT_FAILURE;
 	}
+	if( Bundle.set && !TransformBundle::Load( Bundle.value ) ) fprintf( stderr , "[WARNING] Failed to load transform bundle: %s\n" , Bundle.value );
 
 	int ret;
 	double t = Time();
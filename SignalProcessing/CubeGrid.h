@@ -29,6 +29,7 @@ DAMAGE.
 #define CUBE_GRID_INCLUDED
 
 #include "SignalProcessing/SphericalGrid.h"
+#include "SignalProcessing/GaussLegendreGrid.h"
 
 #ifndef PI
 #define PI 3.1415926535897932384
@@ -83,6 +84,42 @@ public:
 	// Samples the grid over the specified sphere, performing uniform sampling to approximate the monte-carlo integral
 	// over the cell dual to the sphere vertices.
 	void SphereSample( const Real* center , Real radius , SphericalGrid< Real >& sGrid , int subRes , Real thickness , int threads=1 ) const;
+	// Samples the grid over the specified sphere, at the vertices of a Gauss-Legendre grid
+	void SphereSample( const Real* center , Real radius , GaussLegendreGrid< Real >& sGrid , int threads=1 ) const;
+};
+
+// This class represents a box-filtered (mip) pyramid over a CubeGrid, where the samples at level l are the averages
+// of 2^l x 2^l x 2^l blocks of the finest grid. The finest level is not copied, so the grid must outlive the pyramid.
+template< class Real=float >
+class CubeGridPyramid
+{
+protected:
+	const CubeGrid< Real >* _grid;
+	CubeGrid< Real >* _levels;
+	int _levelCount;
+	// The pyramid owns its coarser levels, so it cannot be copied (these are declared but not defined)
+	CubeGridPyramid( const CubeGridPyramid& pyramid );
+	CubeGridPyramid& operator = ( const CubeGridPyramid& pyramid );
+public:
+	CubeGridPyramid( void );
+	CubeGridPyramid( const CubeGrid< Real >& grid , int threads=1 );
+	~CubeGridPyramid( void );
+
+	// Builds the coarser levels of the pyramid from the specified grid
+	int set( const CubeGrid< Real >& grid , int threads=1 );
+
+	// Returns the number of levels (including the finest)
+	int levels( void ) const;
+	// Returns the grid at the specified level
+	const CubeGrid< Real >& operator[] ( int l ) const;
+
+	// Returns the value at the specified (finest-level) index, prefiltered over a box of the specified width.
+	// The value is linearly interpolated between the two levels bracketing the width.
+	Real operator() ( const double& x , const double& y , const double& z , const double& width ) const;
+
+	// Samples the grid over the specified sphere, prefiltering over the cell dual to the sphere vertices.
+	// This approximates CubeGrid::SphereSample( center , radius , sGrid , subRes , thickness ) with a single lookup per sample.
+	void SphereSample( const Real* center , Real radius , SphericalGrid< Real >& sGrid , Real thickness , int threads=1 ) const;
 };
 #include "CubeGrid.inl"
 #endif // CUBE_GRID_INCLUDED
@@ -325,3 +325,104 @@ void CubeGrid< Real >::SphereSample( const Real* center , Real radius , Spherica
 		sGrid( i , j ) = value/weight;
 	}
 }
+template< class Real >
+void CubeGrid< Real >::SphereSample( const Real* center , Real radius , GaussLegendreGrid< Real >& sGrid , int threads ) const
+{
+#pragma omp parallel for num_threads( threads )
+	for( int j=0 ; j<sGrid.latitudes() ; j++ ) for( int i=0 ; i<sGrid.resolution() ; i++ )
+	{
+		Real coords[3];
+		sGrid.setCoordinates( i , j , coords );
+		sGrid( i , j ) = (*this)( center[0] + coords[0]*radius , center[1] + coords[1]*radius , center[2] + coords[2]*radius );
+	}
+}
+
+/////////////////////
+// CubeGridPyramid //
+/////////////////////
+template< class Real >
+CubeGridPyramid< Real >::CubeGridPyramid( void ) : _grid(NULL) , _levels(NULL) , _levelCount(0) { ; }
+template< class Real >
+CubeGridPyramid< Real >::CubeGridPyramid( const CubeGrid< Real >& grid , int threads ) : _grid(NULL) , _levels(NULL) , _levelCount(0) { set( grid , threads ); }
+template< class Real >
+CubeGridPyramid< Real >::~CubeGridPyramid( void )
+{
+	if( _levels ) delete[] _levels;
+	_levels = NULL , _grid = NULL , _levelCount = 0;
+}
+template< class Real >
+int CubeGridPyramid< Real >::set( const CubeGrid< Real >& grid , int threads )
+{
+	if( _levels ) delete[] _levels;
+	_levels = NULL , _levelCount = 0;
+	_grid = &grid;
+	if( !grid.resolution() ) return 0;
+
+	_levelCount = 1;
+	for( int r=grid.resolution() ; r>1 ; r=(r+1)/2 ) _levelCount++;
+	if( _levelCount>1 ) _levels = new CubeGrid< Real >[ _levelCount-1 ];
+
+	// Each coarser sample is the average of the 2x2x2 block of finer samples below it (with zero outside the grid)
+	for( int l=1 ; l<_levelCount ; l++ )
+	{
+		const CubeGrid< Real >& fine = (*this)[l-1];
+		CubeGrid< Real >& coarse = _levels[l-1];
+		const int fRes = fine.resolution() , cRes = (fRes+1)/2;
+		if( !coarse.resize( cRes ) ) return 0;
+#pragma omp parallel for num_threads( threads )
+		for( int i=0 ; i<cRes ; i++ )
+		{
+			Real* _coarse = coarse[i];
+			for( int j=0 ; j<cRes ; j++ ) for( int k=0 ; k<cRes ; k++ )
+			{
+				Real sum = 0;
+				for( int ii=2*i ; ii<2*i+2 && ii<fRes ; ii++ )
+				{
+					const Real* _fine = fine[ii];
+					for( int jj=2*j ; jj<2*j+2 && jj<fRes ; jj++ ) for( int kk=2*k ; kk<2*k+2 && kk<fRes ; kk++ ) sum += _fine[jj*fRes+kk];
+				}
+				_coarse[j*cRes+k] = sum / 8;
+			}
+		}
+	}
+	return 1;
+}
+template< class Real > int CubeGridPyramid< Real >::levels( void ) const { return _levelCount; }
+template< class Real > const CubeGrid< Real >& CubeGridPyramid< Real >::operator[] ( int l ) const { return l ? _levels[l-1] : *_grid; }
+template< class Real >
+Real CubeGridPyramid< Real >::operator() ( const double& x , const double& y , const double& z , const double& width ) const
+{
+	if( !_levelCount ) return Real(0);
+	// The level whose box matches the width, with sample i at level l centered at (i+0.5)*2^l-0.5 on the finest level
+	double level = width>1 ? log( width ) / log( 2. ) : 0;
+	if( level>=_levelCount-1 ) level = _levelCount-1;
+	int l1 = int( floor( level ) ) , l2 = l1+1;
+	double dl = level - l1;
+	double s1 = 1. / (1<<l1);
+	Real value = (*this)[l1]( (x+0.5)*s1-0.5 , (y+0.5)*s1-0.5 , (z+0.5)*s1-0.5 );
+	if( dl>0 && l2<_levelCount )
+	{
+		double s2 = s1 / 2;
+		value = Real( value * (1.-dl) + (*this)[l2]( (x+0.5)*s2-0.5 , (y+0.5)*s2-0.5 , (z+0.5)*s2-0.5 ) * dl );
+	}
+	return value;
+}
+template< class Real >
+void CubeGridPyramid< Real >::SphereSample( const Real* center , Real radius , SphericalGrid< Real >& sGrid , Real thickness , int threads ) const
+{
+	const int res = sGrid.resolution();
+#pragma omp parallel for num_threads( threads )
+	for( int j=0 ; j<res ; j++ )
+	{
+		// The dual cell spans the shell thickness radially, PI*r/res along the meridian, and 2*PI*r*sin(phi)/res along the parallel.
+		// Use the width of the cube with the same volume.
+		double phi = PI*(2.0*j+1)/(2.0*res);
+		double width = pow( double(thickness) * ( PI*radius/res ) * ( 2.*PI*radius*sin(phi)/res ) , 1./3 );
+		for( int i=0 ; i<res ; i++ )
+		{
+			Real coords[3];
+			sGrid.setCoordinates( i , j , coords );
+			sGrid( i , j ) = (*this)( center[0] + coords[0]*radius , center[1] + coords[1]*radius , center[2] + coords[2]*radius , width );
+		}
+	}
+}
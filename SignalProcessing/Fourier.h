@@ -27,6 +27,9 @@ DAMAGE.
 */
 #ifndef FOURIER_INCLUDED
 #define FOURIER_INCLUDED
+#include <vector>
+#include <map>
+#include <algorithm>
 #include <fftw3.h>
 
 #include <Util/Algebra.h>
@@ -40,9 +43,11 @@ DAMAGE.
 
 #include "RotationGrid.h"
 #include "SphericalGrid.h"
+#include "GaussLegendreGrid.h"
 #include "SquareGrid.h"
 #include "CircularArray.h"
 #include "Complex.h"
+#include "TransformBundle.h"
 
 // This templated class represents the fourier coefficients of a real valued, 1D signal
 // Because the input signal generating the key is assumed to be real, we know that the
@@ -150,6 +155,15 @@ public:
 	int end( void ) const;
 };
 
+// Kernels for the inner products of packed coefficient arrays. The complex values are treated as interleaved
+// reals, so that the sums over whole arrays can use SOFT's (AVX2/AVX-512) dot product, dispatched at runtime.
+// Returns the real part of \sum_k v1[k] * conjugate( v2[k] )
+template< class Real > Real PackedDot( const Complex< Real >* v1 , const Complex< Real >* v2 , size_t sz );
+// Returns \sum_k |v[k]|^2
+template< class Real > Real PackedSquareNorm( const Complex< Real >* v , size_t sz );
+// Returns \sum_k v1[k].r * v2[k].r
+template< class Real > Real PackedRealDot( const Complex< Real >* v1 , const Complex< Real >* v2 , size_t sz );
+
 // This templated class represents the fourier coefficients of a real valued, signal
 // on the surface of the sphers.
 // Since we assume that the original signal is real, we only store half the coefficients,
@@ -166,12 +180,16 @@ public:
     void Scale          ( Real s );
     Real InnerProduct   ( const FourierKeyS2& key ) const;
     /////////////////////////////////
+	// Returns the square norm without the second pass over the coefficients that InnerProduct( *this ) would make
+	Real squareNorm( void ) const;
 
 	FourierKeyS2( void );
 	FourierKeyS2( const FourierKeyS2& key );
+	FourierKeyS2( FourierKeyS2&& key );
 	FourierKeyS2( int resolution );
 	~FourierKeyS2( void );
 	FourierKeyS2& operator = ( const FourierKeyS2& key );
+	FourierKeyS2& operator = ( FourierKeyS2&& key );
 
 	// Returns the complex dimension of the array
 	int bandWidth( void ) const;
@@ -202,6 +220,83 @@ public:
 	static int Entries( int bw );
 };
 
+// This templated class represents the fourier coefficients of a set of real valued signals on concentric
+// spheres (shells), all with the same band-width. Rather than storing one FourierKeyS2 per shell, the coefficients
+// are stored in a single aligned buffer, ordered by frequency and index, with the shells innermost. That way, the
+// coefficients of all the shells at a given (b,i) are contiguous.
+template< class Real=float >
+class FourierKeyS2Array : public InnerProductSpace< Real , FourierKeyS2Array< Real > >
+{
+	int bw , _shells;
+	Complex< Real >* values;
+public:
+	// A (non-owning) view of the coefficients of a single shell, indexed as a FourierKeyS2.
+	// It is only valid as long as the array is not resized or destroyed.
+	template< class C >
+	class _View
+	{
+		C* _values;
+		int _bw , _stride;
+	public:
+		_View( C* values , int bw , int stride ) : _values(values) , _bw(bw) , _stride(stride) { ; }
+		int bandWidth( void ) const { return _bw; }
+		C& operator() ( int b , int i ) const { return _values[ ( (b*b+b)/2 + i ) * _stride ]; }
+		// Returns the square of the L2-norm of the shell's coefficients (as FourierKeyS2::squareNorm)
+		Real squareNorm( void ) const;
+	};
+	typedef _View<       Complex< Real > >      View;
+	typedef _View< const Complex< Real > > ConstView;
+
+    /////////////////////////////////
+    // Inner product space methods //
+    void Add            ( const FourierKeyS2Array& keys );
+    void Scale          ( Real s );
+    Real InnerProduct   ( const FourierKeyS2Array& keys ) const;
+    /////////////////////////////////
+
+	FourierKeyS2Array( void );
+	FourierKeyS2Array( const FourierKeyS2Array& keys );
+	FourierKeyS2Array( FourierKeyS2Array&& keys );
+	FourierKeyS2Array( int resolution , int shells );
+	~FourierKeyS2Array( void );
+	FourierKeyS2Array& operator = ( const FourierKeyS2Array& keys );
+	FourierKeyS2Array& operator = ( FourierKeyS2Array&& keys );
+
+	// Returns the complex dimension of the shells' arrays
+	int bandWidth( void ) const;
+	// Returns the resolution of the signals
+	int resolution( void ) const;
+	// Returns the number of shells
+	int shells( void ) const;
+	// Allocates memory for the array
+	int resize( int resolution , int shells , bool clr=true );
+
+	// Clears the values of the array to 0
+	void clear( void );
+
+	// Returns a pointer to the coefficients of all the shells at frequency "b" and index "i" (as in FourierKeyS2)
+	Complex< Real >* operator() ( int b , int i );
+	const Complex< Real >* operator() ( int b , int i ) const;
+	// Returns a reference to the indexed element of shell "s"
+	Complex< Real >& operator() ( int b , int i , int s );
+	Complex< Real >  operator() ( int b , int i , int s ) const;
+
+	// Returns a view of the coefficients of shell "s"
+	View      shell( int s );
+	ConstView shell( int s ) const;
+
+	// Writes the squared norms of the frequency "b" components of all the shells into "norms"
+	void squareNorms( int b , Real* norms ) const;
+
+	// Copies the coefficients from/to a set of keys of the same band-width
+	void set( const std::vector< FourierKeyS2< Real > >& keys );
+	void get( std::vector< FourierKeyS2< Real > >& keys ) const;
+	// Copies the coefficients of shell "s" into "key", up to its band-width (or all of them if it is empty)
+	void get( int s , FourierKeyS2< Real >& key ) const;
+
+	static int Entries( int bw , int shells );
+};
+
 // This templated class represents the fourier coefficients of a real valued, signal
 // on the group of 3D rotations.
 // Since we assume that the original signal is real, we only store half the coefficients.
@@ -210,6 +305,11 @@ class FourierKeySO3 : public InnerProductSpace< Real , FourierKeySO3< Real > >
 {
 	int bw;
 	Complex<Real>* values;
+	bool softNative;
+	// Sets the offsets of the (i,j) runs of coefficients, shifted so that the coefficient (b,i,j) is at offsets[i][j]+b
+	static void _SetRunOffsets( int bw , std::vector< int >& offsets );
+	// Multiplies the coefficients by the SOFT weights (or divides them by the weights, if "inverse" is set) as they are copied
+	void _weigh( const Complex< Real >* in , Complex< Real >* out , bool inverse ) const;
 public:
     /////////////////////////////////
     // Inner product space methods //
@@ -217,6 +317,8 @@ public:
     void Scale          ( Real s );
     Real InnerProduct   ( const FourierKeySO3& key ) const;
     /////////////////////////////////
+	// Returns the square norm without the second pass over the coefficients that InnerProduct( *this ) would make
+	Real squareNorm( void ) const;
 	FourierKeySO3( void );
 	FourierKeySO3( const FourierKeySO3& key );
 	FourierKeySO3( int res );
@@ -239,9 +341,38 @@ public:
 	// 0 <= f < bandWidth()
 	//  0 <= i <= f
 	// -f <= j <= f
+	// (If the key is SOFT-native, these are the weighted coefficients.)
 	Complex< Real >  operator() ( int b , int i , int j ) const;
 	Complex< Real >& operator() ( int b , int i , int j );
 
+	// The coefficients are stored in runs over the frequency, in the order in which SOFT's inverse transform expects
+	// the coefficients with i>=0 (which are all it needs for real signals). If the key is SOFT-native, the coefficient
+	// (b,i,j) is also stored multiplied by its SOFT weight (the normalization and sign SOFT's inverse transform expects),
+	// so that the inverse transform can read the coefficients in place rather than repacking them.
+	// Setting the mode rescales the stored coefficients. Adding, inner products and file I/O are in terms of the
+	// unweighted coefficients, whatever the modes of the keys.
+	bool isSOFTNative( void ) const;
+	void setSOFTNative( bool native );
+	static Real SOFTWeight( int b , int i , int j );
+	// Returns the stored coefficients if the key is SOFT-native, and NULL otherwise
+	const Complex< Real >* softCoefficients( void ) const;
+	// Writes the SOFT-native coefficients into an array of Entries( bandWidth() ) complex numbers
+	void getSOFTCoefficients( Complex< Real >* coefficients ) const;
+
+	// Sets "key" to the coefficients of this key with frequency less than resolution/2 (padded with zeros if the
+	// resolution is larger), so that it represents the band-limited truncation of the signal, in the mode of this key
+	void truncate( int resolution , FourierKeySO3& key ) const;
+
+	// Adds in the coefficients of the correlation of the signals represented by the two sets of shells:
+	//		(b,i, j) += \sum_s keys1(b,i,s).conjugate() * keys2(b,j,s)
+	//		(b,i,-j) += \sum_s keys1(b,i,s).conjugate() * keys2(b,j,s).conjugate()		[i,j>0]
+	// If antipodalKey is non-null, it also receives the coefficients of the correlation with the antipodal
+	// reflection of the second signal, which are scaled by (-1)^b.
+	// (The coefficients are weighted as they are added into a SOFT-native key.)
+	// The coefficients of each band are treated as a (b+1)x(b+1) complex matrix product, computed in tiles that
+	// are distributed over the threads across all the bands.
+	void addCorrelation( const FourierKeyS2Array< Real >& keys1 , const FourierKeyS2Array< Real >& keys2 , int threads=1 , FourierKeySO3* antipodalKey=NULL );
+
 	// Reads in an array from the specified file
 	int read( const char* fileName );
 	int read( FILE* fp );
@@ -281,6 +412,38 @@ public:
 	static int BandWidth( int res ){ return (res>>1)+1; }
 };
 
+// The type of the FFTW plans for transforms of the given precision
+template< class Real > struct FFTWPlan{ typedef fftw_plan Plan; };
+template< > struct FFTWPlan< float >{ typedef fftwf_plan Plan; };
+
+// This templated class holds the (read-only) associated Legendre tables used by the spherical harmonic transforms.
+// The tables are cached process-wide, keyed by band-width (and precision, through the template parameter), so that
+// they are computed and stored once, no matter how many transforms (or threads) use them.
+template< class Real=float >
+class LegendreTables
+{
+	static std::map< int , LegendreTables* > _cache;
+	int _refCount;
+	Real *_tableSpace , *_transposeTableSpace;
+	LegendreTables( int bw );
+	// Wraps tables read from a bundle, without copying them
+	LegendreTables( int bw , const Real* tableSpace , const Real* transposeTableSpace );
+	~LegendreTables( void );
+public:
+	int bw;
+	Real **table , **transposeTable;
+
+	// This method returns the tables for the given band-width, computing them if they are not already cached
+	// (or not provided by the process-wide TransformBundle).
+	// Every call to Acquire should be matched by a call to Release.
+	static const LegendreTables* Acquire( int bw );
+	static void Release( const LegendreTables* tables );
+
+	// The tables are kept in the cache after they have been released so that subsequent transforms can re-use them.
+	// This method frees the memory of the tables that are not currently in use.
+	static void Purge( void );
+};
+
 // This templated class is responsible for computing the forward and inverse
 // spherical harmonic transforms of functions defined on the sphere. It allocates
 // the appropriate scratch space, based on the resolution of the grid for which
@@ -292,62 +455,256 @@ class HarmonicTransform
 	{
 	public:
 		int bw;
-		Real *workSpace , *resultSpace , *transposeResultSpace;
+		bool measure;
+		Real *workSpace;
+		// The Legendre tables are shared (through the process-wide cache) and should not be modified
+		const LegendreTables< Real >* tables;
 		Real **table , **transposeTable;
+		// If the tables exceed the budget, the space for the tables of a single order, which are computed on the fly
+		Real *flyTable;
+		// The plans for the FFTs along phi, created once per band-width
+		typename FFTWPlan< Real >::Plan forwardPlan , inversePlan;
+		// The scratch space and plan for batched transforms, created once per band-width and batch size
+		int batchSize;
+		Real *batchData , *batchWorkSpace;
+		typename FFTWPlan< Real >::Plan batchPlan , batchDCTPlan;
+		// The plan for the cosine transforms of just the orders below the last cut-off used (if it was below the band-width),
+		// created on first use
+		int cutOffOrders;
+		typename FFTWPlan< Real >::Plan cutOffDCTPlan;
+		// The Legendre projection engine of each order for the batched transforms (see setLegendreEngine),
+		// and the fast Legendre transform data for the orders using it
+		int engine , crossover;
+		std::vector< int > engines;
+		Real *fltSpace , **fltTable;
 		ScratchSpace(void);
 		~ScratchSpace(void);
-		void resize( const int& bw );
+		int resize( const int& bw );
+		int resize( const int& bw , bool measure );
+		void resizeBatch( int batchSize );
+		// Returns the plan for the cosine transforms of the batched transforms with the given cut-off
+		typename FFTWPlan< Real >::Plan dctPlan( int bandWidth );
+		void setEngine( int engine , int crossover );
+		// The quadrature, the (L2-normalized) associated Legendre functions at the non-negative nodes,
+		// and the plans for the FFTs along the latitudes of Gauss-Legendre grids, created on first use
+		// (If the table exceeds the budget, it only holds the values of one order, which are computed on the fly.)
+		std::vector< double > glNodes , glWeights;
+		Real *glTable , *glData;
+		bool glOnTheFly;
+		typename FFTWPlan< Real >::Plan glForwardPlan , glInversePlan;
+		void setGaussLegendre( void );
+		void setGaussLegendreOrder( int m , Real* table ) const;
+		const Real* gaussLegendreTable( int m );
 	};
 	ScratchSpace scratch;
 public:
+	// The engines for the associated Legendre projections of the batched (and cut-off) forward transforms
+	enum
+	{
+		SEMINAIVE ,		// The seminaive transform, using the precomputed Legendre tables
+		FAST_LEGENDRE ,	// A fast (Driscoll-Healy) Legendre transform, from the crossover degree on
+		NAIVE ,			// The three-term recurrence, run at the sample nodes (no precomputed data)
+		PROFILED		// The fastest of the above for each order, as measured by TuneLegendreEngines (the default)
+	};
+
+	// The memory budget (in bytes) for the precomputed Legendre tables, which need O(bw^3) space.
+	// At band-widths where the tables would exceed it (and are not memory-mapped from the process-wide TransformBundle),
+	// the forward transforms use the NAIVE engine for all orders and the inverse transform computes the tables of
+	// each order on the fly. This only needs O(bw^2) space, but is slower. The same budget applies to the table of
+	// the Gauss-Legendre transforms. (The budget is checked when the scratch space is resized.)
+	static size_t LegendreTableBudget;
+
 	HarmonicTransform( void );
-	HarmonicTransform( int resolution );
+	HarmonicTransform( int resolution , bool measure=false );
 	
 	// This method allocates the appropriate amount of scratch space, given
 	// the resolution of the signals to be transformed.
 	// You do not actually have to call this method, as the transforms will
 	// automatically detect if the resolution of the signal doesn't match the
 	// resolution of the scratch space, and will call resize if they don't.
-	void resize(const int& resolution);
+	// The band-width (half the resolution) must be even, as the layout of the Legendre tables assumes it; otherwise
+	// the method (and the transforms) return 0.
+	int resize(const int& resolution);
+	// If "measure" is set, the FFTW plans are created with FFTW_MEASURE rather than FFTW_ESTIMATE.
+	// This makes planning slower but can make the transforms faster, which pays off for long batch runs.
+	int resize( const int& resolution , bool measure );
+
+	// Since the plans are only executed (never created) by the transforms, distinct transform objects
+	// can be used concurrently from different threads.
+
+	// This method selects the engine for the Legendre projections of the batched (and cut-off) forward transforms.
+	// The fast transform is only stable from about twice the order on, so the seminaive kernel is still used for the
+	// lower degrees (and for those below "crossover"). It needs much less precomputed data, but its constants are
+	// larger, so it only pays off at very high band-widths. (At res 256/512 it is about 2x slower with crossover=0 and
+	// only reaches parity with a crossover near the band-width, so it is not used unless it is selected here or
+	// the tuned profile measured it to be the fastest for an order.)
+	// With PROFILED, the engine of each order is read from the Legendre profile of the process-wide TransformBundle,
+	// falling back to the seminaive transform if the bundle has no profile for the band-width and precision.
+	void setLegendreEngine( int engine , int crossover=0 );
+
+	// This method measures, for each order, which engine computes the Legendre projections of "batchSize" grids
+	// at the given resolution the fastest (on the current machine), and writes it into "engines".
+	// Each engine is timed for at least "minTime" seconds per order.
+	static void TuneLegendreEngines( int resolution , int batchSize , std::vector< int >& engines , double minTime=0.005 , bool measure=false );
 
 	// This method takes in a real valued function on a sphere and computes
 	// the spherical harmonic coefficients, writing them into "key"
 	int ForwardFourier(SphericalGrid<Real>& g,FourierKeyS2<Real>& key);
 
+	// This method computes the spherical harmonic coefficients of a set of functions (of the same resolution),
+	// transforming them together so that each Legendre table row is applied to all the functions at once
+	int ForwardFourier( std::vector< SphericalGrid< Real > >& g , std::vector< FourierKeyS2< Real > >& keys );
+
+	// These methods only compute the coefficients of degree less than "bandWidth", setting the others to zero.
+	// The Legendre transforms skip the orders and degrees above the cut-off, which makes them considerably
+	// cheaper when only the low frequencies are used.
+	int ForwardFourier( SphericalGrid< Real >& g , FourierKeyS2< Real >& key , int bandWidth );
+	int ForwardFourier( std::vector< SphericalGrid< Real > >& g , std::vector< FourierKeyS2< Real > >& keys , int bandWidth );
+
+	// This method computes the spherical harmonic coefficients of a set of functions (of the same resolution),
+	// writing them into the shells of "keys" (see FourierKeyS2Array)
+	int ForwardFourier( std::vector< SphericalGrid< Real > >& g , FourierKeyS2Array< Real >& keys , int bandWidth );
+
 	// This method takes the spherical harmonic coefficients of a real valued function
 	// on a sphere and returns the originial signal, writing it into "g"
 	int InverseFourier(FourierKeyS2<Real>& key,SphericalGrid<Real>& g);
+
+	// These methods transform functions sampled on a Gauss-Legendre grid. The coefficients are the same as those
+	// computed from the equiangular grid of the same resolution, but only half as many latitudes are sampled and
+	// transformed. (The quadrature is exact, so the inverse transform followed by the forward one is the identity.)
+	int ForwardFourier( GaussLegendreGrid< Real >& g , FourierKeyS2< Real >& key );
+	int InverseFourier( FourierKeyS2< Real >& key , GaussLegendreGrid< Real >& g );
+};
+
+// This templated class holds the (read-only) Wigner-d tables used by the inverse SO(3) transform, as computed by genWigAllTrans.
+// As with the Legendre tables, they are cached process-wide, keyed by band-width (and precision, through the template
+// parameter), so that the recurrences are only evaluated once, no matter how many transforms (or threads) use them.
+// (The recurrences are always evaluated in double precision, and the single precision tables are rounded from those.)
+template< class Real=float >
+class WignerDTables
+{
+	static std::map< int , WignerDTables* > _cache;
+	int _refCount;
+	Real* _tableSpace;
+	WignerDTables( int bw );
+	// Wraps a (double precision) table read from a bundle, copying it only if it has to be converted
+	WignerDTables( int bw , const double* tableSpace );
+	~WignerDTables( void );
+public:
+	int bw;
+	const Real* table;
+
+	// This method returns the tables for the given band-width, computing them if they are not already cached
+	// (or not provided by the process-wide TransformBundle).
+	// Every call to Acquire should be matched by a call to Release.
+	static const WignerDTables* Acquire( int bw );
+	static void Release( const WignerDTables* tables );
+
+	// The tables are kept in the cache after they have been released so that subsequent transforms can re-use them.
+	// This method frees the memory of the tables that are not currently in use.
+	static void Purge( void );
 };
 
 // This templated class is responsible for computing the inverse
 // Wigner-D transform of functions defined on the group of 3D rotations. It
 // allocates the appropriate scratch space, based on the resolution of the
 // grid for which transforms will be computed.
+// The transform is computed in the precision of the template parameter (with fftwf for single precision), so
+// that the samples, the workspaces and the Wigner-d tables of a single precision transform take half the memory.
+// Since the signals are real, only the order pairs (m1,m2) with m2>=0 are synthesized, into the half-spectra of
+// the betas, which are transformed with complex-to-real FFTs.
 template<class Real=float>
 class WignerDTransform{
 	class ScratchSpace{
 	public:
-		int bw;
-		fftw_complex *data,*coeffs,*workspace_cx,*workspace_cx2;
+		int bw , threads;
+		bool measure;
+		// The half-spectra of the betas are stored in workspace_cx, and the repacked coefficients of keys that are
+		// not SOFT-native in coeffs. (The samples are written straight into the rotation grid.)
+		// The complex arrays are stored as interleaved (real,imaginary) pairs in the precision of the transform.
+		// The per-thread workspaces, workspace_cx2 and workspace_re, are sized for "threads" threads.
+		// (workspace_re holds the Wigner-ds generated on the fly, which are always double precision.)
+		Real *coeffs , *workspace_cx , *workspace_cx2;
 		double *workspace_re;
-		fftw_plan p;
+		// The precomputed Wigner-d tables (NULL if they exceed the budget)
+		const WignerDTables< Real >* wigners;
+		// The plan for the complex-to-real FFT of the half-spectrum of one beta, executed on all the betas
+		// (It writes the samples with the strides of the rotation grid, and is created by the first transform.)
+		typename FFTWPlan< Real >::Plan p;
 		ScratchSpace(void);
 		~ScratchSpace(void);
 
 		void resize(const int& bw);
+		void resize( const int& bw , bool measure );
+		void setThreads( int threads );
 	};
 	ScratchSpace scratch;
 public:
+	// The maximum size (in bytes) of the Wigner-d tables that the transform will compute and cache.
+	// The tables grow as O(bw^4), so at band-widths where they would exceed it (and, for double precision
+	// transforms, are not memory-mapped from the process-wide TransformBundle), the inverse transform evaluates the Wigner-d recurrences
+	// on every call instead. Since each table entry is only read once per transform, streaming a table
+	// that is much larger than the cache costs about as much as the recurrences, so the default is small.
+	// (The budget is checked when the scratch space is resized.)
+	static size_t WignerDTableBudget;
+
 	// This method allocates the appropriate amount of scratch space, given
 	// the resolution of the signals to be transformed.
 	// You do not actually have to call this method, as the transforms will
 	// automatically detect if the resolution of the signal doesn't match the
 	// resolution of the scratch space, and will call resize if they don't.
 	void resize(const int& resolution);
+	// If "measure" is set, the FFTW plan is created with FFTW_MEASURE rather than FFTW_ESTIMATE.
+	void resize( const int& resolution , bool measure );
 
 	// This method takes the spherical harmonic coefficients of a real valued function
-	// on a sphere and returns the originial signal, writing it into "g"
-	int InverseFourier(FourierKeySO3<Real>& key,RotationGrid<Real>& g);
+	// on a sphere and returns the originial signal, writing it into "g".
+	// The synthesis of the order pairs and the FFTs are split over "threads" threads.
+	// If the key is SOFT-native, its coefficients are read in place. The samples are written straight into "g".
+	int InverseFourier( FourierKeySO3< Real >& key , RotationGrid< Real >& g , int threads=1 );
+};
+
+// This templated class evaluates the signal represented by a FourierKeySO3 directly, at arbitrary rotations, by summing
+// its Wigner-D series over all the band-widths rather than sampling it on a rotation grid.
+// The rotations are given by their Euler angles (theta,phi,psi), in the convention of RotationGrid::SetCoordinates.
+// The Wigner-d matrices of all the band-widths are generated at phi with SOFT's wignerdmat recurrence, and the
+// coefficients are summed against them into a 2D Fourier series in (theta,psi), so moving to a new phi costs O(bw^3),
+// after which evaluating at a (theta,psi) costs O(bw^2). The derivatives of the series with respect to phi are
+// summed along with it, so that local extrema can be found with Newton's method.
+// (The series is summed in double precision, whatever the precision of the key.)
+template< class Real=float >
+class WignerDSeries
+{
+	int _bw;
+	// For each band-width b, the (b+1)x(2b+1) matrix of the (unweighted) coefficients (b,i,j) with i>=0, scaled by
+	// the multiplicity and the sign with which they multiply the Wigner-d's generated by wignerdmat
+	std::vector< double > _coefficients;
+	std::vector< int > _offsets;
+	// The coefficients of the series in (theta,psi) at _phi, and of its first and second derivatives with respect to phi
+	double _phi;
+	std::vector< double > _slice[3];
+	// The Wigner-d matrices (and their derivatives) of the current band-width, and the workspace for the recurrence
+	std::vector< double > _d[4] , _sqrts , _workspace;
+
+	void _setSlice( double phi );
+	// Evaluates the series of the current slice, along with its gradient and Hessian with respect to (theta,phi,psi)
+	double _evaluate( double theta , double psi , double gradient[3] , double hessian[3][3] ) const;
+public:
+	WignerDSeries( void );
+	WignerDSeries( const FourierKeySO3< Real >& key );
+
+	// Copies the coefficients of the key
+	void set( const FourierKeySO3< Real >& key );
+	int bandWidth( void ) const;
+
+	// Returns the value of the signal at the rotation with Euler angles (theta,phi,psi)
+	Real operator() ( Real theta , Real phi , Real psi );
+
+	// Starting from (theta,phi,psi), this method searches for a local maximum (or minimum) of the signal, with a
+	// trust-region Newton method. The trust-region radius (in radians) starts out at "radius", and the search stops
+	// once the steps (or the radius) are smaller than "precision", or after "iterations" steps.
+	// The Euler angles of the extremum are written back into (theta,phi,psi), and the value there is returned.
+	Real refine( Real& theta , Real& phi , Real& psi , bool maximum , Real radius , Real precision , int iterations=32 );
 };
 
 #include "Fourier1D.inl"
@@ -30,9 +30,32 @@ DAMAGE.
 #include <string.h>
 
 #include <FST_semi_memo_fftw.h>
+#include <FST_semi_fly_fftw.h>
 #include <cospmls.h>
+#include <seminaive_simd.h>
+#include <fftwFCT.h>
+#include <FLT_fftw.h>
+#include <weights.h>
 #include "fftw3.h"
 #include <math.h>
+#include <omp.h>
+
+////////////////////////////////
+// Packed coefficient kernels //
+////////////////////////////////
+template< class Real >
+Real PackedDot( const Complex< Real >* v1 , const Complex< Real >* v2 , size_t sz ){ return SemiNaiveDot( (const Real*)v1 , (const Real*)v2 , int( 2*sz ) ); }
+template< class Real >
+Real PackedSquareNorm( const Complex< Real >* v , size_t sz ){ return SemiNaiveDot( (const Real*)v , (const Real*)v , int( 2*sz ) ); }
+template< class Real >
+Real PackedRealDot( const Complex< Real >* v1 , const Complex< Real >* v2 , size_t sz )
+{
+	size_t k=0;
+	Real d0=0 , d1=0;
+	for( ; k+2<=sz ; k+=2 ) d0 += v1[k].r*v2[k].r , d1 += v1[k+1].r*v2[k+1].r;
+	for( ; k<sz ; k++ ) d0 += v1[k].r*v2[k].r;
+	return d0 + d1;
+}
 
 //////////////////
 // FourierKeyS2 //
@@ -51,6 +74,21 @@ FourierKeyS2< Real >& FourierKeyS2< Real >::operator = ( const FourierKeyS2< Rea
 	memcpy( values , key.values , sizeof( Complex< Real > ) * Entries(bw) );
 	return *this;
 }
+template< class Real > FourierKeyS2< Real >::FourierKeyS2( FourierKeyS2< Real >&& key ) : bw(key.bw) , values(key.values)
+{
+	key.bw = 0 , key.values = NULL;
+}
+template< class Real >
+FourierKeyS2< Real >& FourierKeyS2< Real >::operator = ( FourierKeyS2< Real >&& key )
+{
+	if( this!=&key )
+	{
+		if( values ) delete[] values;
+		bw = key.bw , values = key.values;
+		key.bw = 0 , key.values = NULL;
+	}
+	return *this;
+}
 
 template<class Real> FourierKeyS2<Real>::~FourierKeyS2(void){
 	if(values){delete[] values;}
@@ -125,29 +163,314 @@ void FourierKeyS2< Real >::Scale( Real s )
 template< class Real >
 Real FourierKeyS2< Real >::InnerProduct( const FourierKeyS2< Real >& key ) const
 {
-	Real dot = 0;
 	// For real data, we have
 	// f-hat(l,-m) = (-1)^m * conjugate(f-hat(l,m))
 	// Furthermore, we will assume that f-hat(l,0) is strictly real
+	// The coefficients are stored index-major, so the coefficients with index i are contiguous, running over the
+	// frequencies i<=b<bw. In particular, the zonal harmonics are the first bw coefficients.
+	int _bw = std::min< int >( bw , key.bw );
+	if( !_bw ) return 0;
 
 	// The zonal harmonics
-	for( int b=0 ; b<bw && b<key.bw ; b++ )
+	Real dot = PackedRealDot( values , key.values , _bw );
+	// The remaining harmonics, counted twice to account for the negative indices
+	if( bw==key.bw ) dot += PackedDot( values+bw , key.values+bw , Entries(bw)-bw ) * 2;
+	else for( int i=1 ; i<_bw ; i++ ) dot += PackedDot( values + i*bw-(i*i-i)/2 , key.values + i*key.bw-(i*i-i)/2 , _bw-i ) * 2;
+	return dot;
+}
+template< class Real >
+Real FourierKeyS2< Real >::squareNorm( void ) const
+{
+	if( !bw ) return 0;
+	return PackedRealDot( values , values , bw ) + PackedSquareNorm( values+bw , Entries(bw)-bw ) * 2;
+}
+template<class Real> int FourierKeyS2<Real>::Entries( int bw ){return (bw*bw+bw)>>1;}
+///////////////////////
+// FourierKeyS2Array //
+///////////////////////
+template< class Real > FourierKeyS2Array< Real >::FourierKeyS2Array( void ) : bw(0) , _shells(0) , values(NULL) { ; }
+template< class Real > FourierKeyS2Array< Real >::FourierKeyS2Array( int resolution , int shells ) : bw(0) , _shells(0) , values(NULL) { resize( resolution , shells ); }
+template< class Real > FourierKeyS2Array< Real >::FourierKeyS2Array( const FourierKeyS2Array< Real >& keys ) : bw(0) , _shells(0) , values(NULL)
+{
+	resize( keys.resolution() , keys.shells() , false );
+	if( values ) memcpy( values , keys.values , sizeof( Complex< Real > ) * Entries( bw , _shells ) );
+}
+template< class Real > FourierKeyS2Array< Real >::FourierKeyS2Array( FourierKeyS2Array< Real >&& keys ) : bw(keys.bw) , _shells(keys._shells) , values(keys.values)
+{
+	keys.bw = keys._shells = 0 , keys.values = NULL;
+}
+template< class Real > FourierKeyS2Array< Real >::~FourierKeyS2Array( void ){ resize( 0 , 0 ); }
+template< class Real >
+FourierKeyS2Array< Real >& FourierKeyS2Array< Real >::operator = ( const FourierKeyS2Array< Real >& keys )
+{
+	if( this!=&keys )
+	{
+		resize( keys.resolution() , keys.shells() , false );
+		if( values ) memcpy( values , keys.values , sizeof( Complex< Real > ) * Entries( bw , _shells ) );
+	}
+	return *this;
+}
+template< class Real >
+FourierKeyS2Array< Real >& FourierKeyS2Array< Real >::operator = ( FourierKeyS2Array< Real >&& keys )
+{
+	if( this!=&keys )
 	{
-		dot += (*this)(b,0).r * key(b,0).r;
-		for( int i=1 ; i<=b ; i++ ) dot += ( (*this)(b,i) * key(b,i).conjugate() ).r * 2;
+		resize( 0 , 0 );
+		bw = keys.bw , _shells = keys._shells , values = keys.values;
+		keys.bw = keys._shells = 0 , keys.values = NULL;
+	}
+	return *this;
+}
+template< class Real > int FourierKeyS2Array< Real >::bandWidth( void ) const { return bw; }
+template< class Real > int FourierKeyS2Array< Real >::resolution( void ) const { return bw*2; }
+template< class Real > int FourierKeyS2Array< Real >::shells( void ) const { return _shells; }
+template< class Real >
+int FourierKeyS2Array< Real >::resize( int resolution , int shells , bool clr )
+{
+	int b = resolution>>1;
+	if( b<0 || shells<0 ) return 0;
+	if( b!=bw || shells!=_shells )
+	{
+		if( values ) fftw_free( values );
+		values = NULL;
+		bw = _shells = 0;
+		if( b && shells )
+		{
+			// The buffer is aligned so that the shells of each coefficient can be processed with vector instructions
+			values = (Complex< Real >*)fftw_malloc( sizeof( Complex< Real > ) * Entries( b , shells ) );
+			if( !values ) return 0;
+			bw = b , _shells = shells;
+		}
+	}
+	if( clr ) clear();
+	return 1;
+}
+template< class Real > void FourierKeyS2Array< Real >::clear( void ){ if( values ) memset( values , 0 , sizeof( Complex< Real > ) * Entries( bw , _shells ) ); }
+template< class Real > Complex< Real >* FourierKeyS2Array< Real >::operator() ( int b , int i ) { return values + ( (b*b+b)/2 + i ) * _shells; }
+template< class Real > const Complex< Real >* FourierKeyS2Array< Real >::operator() ( int b , int i ) const { return values + ( (b*b+b)/2 + i ) * _shells; }
+template< class Real > Complex< Real >& FourierKeyS2Array< Real >::operator() ( int b , int i , int s )       { return values[ ( (b*b+b)/2 + i ) * _shells + s ]; }
+template< class Real > Complex< Real >  FourierKeyS2Array< Real >::operator() ( int b , int i , int s ) const { return values[ ( (b*b+b)/2 + i ) * _shells + s ]; }
+template< class Real > typename FourierKeyS2Array< Real >::View      FourierKeyS2Array< Real >::shell( int s )       { return      View( values + s , bw , _shells ); }
+template< class Real > typename FourierKeyS2Array< Real >::ConstView FourierKeyS2Array< Real >::shell( int s ) const { return ConstView( values + s , bw , _shells ); }
+template< class Real > int FourierKeyS2Array< Real >::Entries( int bw , int shells ){ return ( (bw*bw+bw)>>1 ) * shells; }
+template< class Real >
+void FourierKeyS2Array< Real >::Add( const FourierKeyS2Array< Real >& keys )
+{
+	if( keys.shells()!=_shells ) fprintf( stderr , "[ERROR] FourierKeyS2Array::Add: Shell counts differ: %d != %d\n" , _shells , keys.shells() );
+	else for( int b=0 ; b<bw && b<keys.bw ; b++ ) for( int i=0 ; i<=b ; i++ )
+	{
+		Complex< Real >* c1 = (*this)(b,i);
+		const Complex< Real >* c2 = keys(b,i);
+		for( int s=0 ; s<_shells ; s++ ) c1[s] += c2[s];
+	}
+}
+template< class Real >
+void FourierKeyS2Array< Real >::Scale( Real s )
+{
+	Complex< Real >* c = values;
+	for( int i=0 ; i<Entries( bw , _shells ) ; i++ ) c[i] *= s;
+}
+template< class Real >
+Real FourierKeyS2Array< Real >::InnerProduct( const FourierKeyS2Array< Real >& keys ) const
+{
+	// As in FourierKeyS2::InnerProduct, summed over the shells
+	Real dot = 0;
+	int shells = std::min< int >( _shells , keys._shells );
+	for( int b=0 ; b<bw && b<keys.bw ; b++ ) for( int i=0 ; i<=b ; i++ )
+	{
+		Real _dot = PackedDot( (*this)(b,i) , keys(b,i) , shells );
+		dot += i ? _dot*2 : _dot;
 	}
 	return dot;
 }
-template<class Real> int FourierKeyS2<Real>::Entries( int bw ){return (bw*bw+bw)>>1;}
+template< class Real >
+void FourierKeyS2Array< Real >::squareNorms( int b , Real* norms ) const
+{
+	for( int s=0 ; s<_shells ; s++ ) norms[s] = 0;
+	for( int i=0 ; i<=b ; i++ )
+	{
+		const Complex< Real >* c = (*this)(b,i);
+		Real scale = Real( i ? 2 : 1 );
+		for( int s=0 ; s<_shells ; s++ ) norms[s] += ( c[s].r * c[s].r + c[s].i * c[s].i ) * scale;
+	}
+}
+template< class Real >
+void FourierKeyS2Array< Real >::set( const std::vector< FourierKeyS2< Real > >& keys )
+{
+	int res = keys.size() ? keys[0].resolution() : 0;
+	for( int s=1 ; s<keys.size() ; s++ ) if( keys[s].resolution()!=res )
+	{
+		fprintf( stderr , "[ERROR] FourierKeyS2Array::set: Keys must have the same resolution: %d != %d\n" , keys[s].resolution() , res );
+		return;
+	}
+	resize( res , int( keys.size() ) , false );
+	for( int b=0 ; b<bw ; b++ ) for( int i=0 ; i<=b ; i++ )
+	{
+		Complex< Real >* c = (*this)(b,i);
+		for( int s=0 ; s<_shells ; s++ ) c[s] = keys[s](b,i);
+	}
+}
+template< class Real >
+void FourierKeyS2Array< Real >::get( std::vector< FourierKeyS2< Real > >& keys ) const
+{
+	keys.resize( _shells );
+	for( int s=0 ; s<_shells ; s++ ) keys[s].resize( resolution() , false );
+	for( int b=0 ; b<bw ; b++ ) for( int i=0 ; i<=b ; i++ )
+	{
+		const Complex< Real >* c = (*this)(b,i);
+		for( int s=0 ; s<_shells ; s++ ) keys[s](b,i) = c[s];
+	}
+}
+template< class Real >
+void FourierKeyS2Array< Real >::get( int s , FourierKeyS2< Real >& key ) const
+{
+	if( !key.bandWidth() ) key.resize( resolution() , false );
+	ConstView view = shell( s );
+	for( int b=0 ; b<key.bandWidth() ; b++ ) for( int i=0 ; i<=b ; i++ ) key(b,i) = b<bw ? view(b,i) : Complex< Real >();
+}
+template< class Real >
+template< class C >
+Real FourierKeyS2Array< Real >::_View< C >::squareNorm( void ) const
+{
+	Real norm2 = 0;
+	for( int b=0 ; b<_bw ; b++ )
+	{
+		norm2 += (*this)(b,0).squareNorm();
+		for( int i=1 ; i<=b ; i++ ) norm2 += (*this)(b,i).squareNorm() * 2;
+	}
+	return norm2;
+}
+////////////////////
+// LegendreTables //
+////////////////////
+template< class Real > std::map< int , LegendreTables< Real >* > LegendreTables< Real >::_cache;
+
+template< class Real >
+LegendreTables< Real >::LegendreTables( int b )
+{
+	bw = b;
+	_refCount = 0;
+	_tableSpace = new Real[ Spharmonic_TableSize(bw) ];
+	_transposeTableSpace = new Real[ Spharmonic_TableSize(bw) ];
+	Real* workSpace = new Real[ 16*bw ];
+	table          =           Spharmonic_Pml_Table( bw , _tableSpace , workSpace );
+	transposeTable = Transpose_Spharmonic_Pml_Table( table , bw , _transposeTableSpace , workSpace );
+	delete[] workSpace;
+}
+template< class Real >
+LegendreTables< Real >::LegendreTables( int b , const Real* tableSpace , const Real* transposeTableSpace )
+{
+	bw = b;
+	_refCount = 0;
+	_tableSpace = _transposeTableSpace = NULL;
+	// Set up the row pointers as Spharmonic_Pml_Table and Transpose_Spharmonic_Pml_Table do
+	table = (Real**)malloc( sizeof(Real*) * bw );
+	transposeTable = (Real**)malloc( sizeof(Real*) * bw );
+	table[0] = (Real*)tableSpace;
+	transposeTable[0] = (Real*)transposeTableSpace;
+	for( int i=1 ; i<bw ; i++ ) table[i] = table[i-1] + TableSize( i-1 , bw ) , transposeTable[i] = transposeTable[i-1] + TableSize( i-1 , bw );
+}
+template< class Real >
+LegendreTables< Real >::~LegendreTables( void )
+{
+	// The arrays of row pointers are malloc'ed by SOFT
+	if( table ) free( table );
+	if( transposeTable ) free( transposeTable );
+	if( _tableSpace ) delete[] _tableSpace;
+	if( _transposeTableSpace ) delete[] _transposeTableSpace;
+	table = transposeTable = NULL;
+	_tableSpace = _transposeTableSpace = NULL;
+}
+template< class Real >
+const LegendreTables< Real >* LegendreTables< Real >::Acquire( int bw )
+{
+	if( bw<=0 ) return NULL;
+	LegendreTables* tables;
+	// The tables are only computed once, by the first thread that asks for them
+#pragma omp critical (LegendreTableCache)
+	{
+		typename std::map< int , LegendreTables* >::iterator iter = _cache.find( bw );
+		if( iter==_cache.end() )
+		{
+			const Real* tableSpace = TransformBundle::Default().legendreTable< Real >( bw );
+			const Real* transposeTableSpace = TransformBundle::Default().transposeLegendreTable< Real >( bw );
+			if( tableSpace && transposeTableSpace ) tables = _cache[bw] = new LegendreTables( bw , tableSpace , transposeTableSpace );
+			else                                    tables = _cache[bw] = new LegendreTables( bw );
+		}
+		else tables = iter->second;
+		tables->_refCount++;
+	}
+	return tables;
+}
+template< class Real >
+void LegendreTables< Real >::Release( const LegendreTables* tables )
+{
+	if( !tables ) return;
+#pragma omp critical (LegendreTableCache)
+	{
+		LegendreTables* _tables = _cache[ tables->bw ];
+		if( _tables->_refCount>0 ) _tables->_refCount--;
+	}
+}
+template< class Real >
+void LegendreTables< Real >::Purge( void )
+{
+#pragma omp critical (LegendreTableCache)
+	{
+		typename std::map< int , LegendreTables* >::iterator iter = _cache.begin();
+		while( iter!=_cache.end() )
+			if( !iter->second->_refCount ) delete iter->second , _cache.erase( iter++ );
+			else iter++;
+	}
+}
 /////////////////////////////////////
 // HarmonicTransform::ScratchSpace //
 /////////////////////////////////////
+inline void DestroyFFTWPlan( fftw_plan  plan ){ fftw_destroy_plan ( plan ); }
+inline void DestroyFFTWPlan( fftwf_plan plan ){ fftwf_destroy_plan( plan ); }
+
+// The FFTs along the latitudes of a Gauss-Legendre grid, with (size/2+1) complex coefficients per latitude
+inline fftw_plan GaussLegendrePlan( double* data , double* coeffs , int size , int rows , bool forward , unsigned flags )
+{
+	int n = size;
+	if( forward ) return fftw_plan_many_dft_r2c( 1 , &n , rows , data , NULL , 1 , size , (fftw_complex*)coeffs , NULL , 1 , size/2+1 , flags );
+	else          return fftw_plan_many_dft_c2r( 1 , &n , rows , (fftw_complex*)coeffs , NULL , 1 , size/2+1 , data , NULL , 1 , size , flags );
+}
+inline fftwf_plan GaussLegendrePlan( float* data , float* coeffs , int size , int rows , bool forward , unsigned flags )
+{
+	int n = size;
+	if( forward ) return fftwf_plan_many_dft_r2c( 1 , &n , rows , data , NULL , 1 , size , (fftwf_complex*)coeffs , NULL , 1 , size/2+1 , flags );
+	else          return fftwf_plan_many_dft_c2r( 1 , &n , rows , (fftwf_complex*)coeffs , NULL , 1 , size/2+1 , data , NULL , 1 , size , flags );
+}
+inline void ExecuteForwardPlan( fftw_plan  plan , double* data , double* coeffs ){ fftw_execute_dft_r2c ( plan , data , (fftw_complex* )coeffs ); }
+inline void ExecuteForwardPlan( fftwf_plan plan , float*  data , float*  coeffs ){ fftwf_execute_dft_r2c( plan , data , (fftwf_complex*)coeffs ); }
+inline void ExecuteInversePlan( fftw_plan  plan , double* coeffs , double* data ){ fftw_execute_dft_c2r ( plan , (fftw_complex* )coeffs , data ); }
+inline void ExecuteInversePlan( fftwf_plan plan , float*  coeffs , float*  data ){ fftwf_execute_dft_c2r( plan , (fftwf_complex*)coeffs , data ); }
+
+template< class Real > size_t HarmonicTransform< Real >::LegendreTableBudget = size_t(1)<<30;
+
 template<class Real>
 HarmonicTransform<Real>::ScratchSpace::ScratchSpace( void )
 {
 	bw=0;
-	workSpace=resultSpace=transposeResultSpace=NULL;
+	measure=false;
+	workSpace=NULL;
+	tables=NULL;
 	table=transposeTable=NULL;
+	flyTable=NULL;
+	forwardPlan=inversePlan=NULL;
+	batchSize=0;
+	batchData=batchWorkSpace=NULL;
+	batchPlan=batchDCTPlan=NULL;
+	cutOffOrders=0;
+	cutOffDCTPlan=NULL;
+	engine=PROFILED;
+	crossover=0;
+	fltSpace=NULL;
+	fltTable=NULL;
+	glTable=glData=NULL;
+	glOnTheFly=false;
+	glForwardPlan=glInversePlan=NULL;
 #if NEW_HARMONIC
 	weights=NULL;
 #endif // NEW_HARMONIC
@@ -155,64 +478,460 @@ HarmonicTransform<Real>::ScratchSpace::ScratchSpace( void )
 template<class Real>
 HarmonicTransform<Real>::ScratchSpace::~ScratchSpace(void){resize(0);}
 template<class Real>
-void HarmonicTransform<Real>::ScratchSpace::resize( const int& b )
+int HarmonicTransform<Real>::ScratchSpace::resize( const int& b , bool m )
+{
+	if( m!=measure )
+	{
+		// Force the plans to be re-created
+		measure = m;
+		int _bw = bw;
+		resize( 0 ) , resize( _bw );
+	}
+	return resize( b );
+}
+template<class Real>
+int HarmonicTransform<Real>::ScratchSpace::resize( const int& b )
 {
+	// The layout of the Legendre tables assumes an even band-width
+	if( b&1 )
+	{
+		fprintf( stderr , "[ERROR] HarmonicTransform: Band-width must be even: %d\n" , b );
+		return 0;
+	}
 	if( b!=bw )
 	{
 		int size=b*2;
-		if(workSpace)				{delete[] workSpace;}
-		if(resultSpace)				{delete[] resultSpace;}
-		if(transposeResultSpace)	{delete[] transposeResultSpace;}
-		if(table)					{delete[] table;}
-		if(transposeTable)			{delete[] transposeTable;}
+		resizeBatch( 0 );
+		// FFTW's planner is not thread-safe
+#pragma omp critical (FFTWPlanner)
+		{
+			if( forwardPlan ) DestroyFFTWPlan( forwardPlan );
+			if( inversePlan ) DestroyFFTWPlan( inversePlan );
+			if( glForwardPlan ) DestroyFFTWPlan( glForwardPlan );
+			if( glInversePlan ) DestroyFFTWPlan( glInversePlan );
+		}
+		if( glTable ) delete[] glTable;
+		if( glData ) fftw_free( glData );
+		glTable = glData = NULL;
+		glOnTheFly = false;
+		glForwardPlan = glInversePlan = NULL;
+		glNodes.clear() , glWeights.clear();
+		if(workSpace)				{fftw_free(workSpace);}
+		if(tables)					{LegendreTables< Real >::Release(tables);}
+		if( flyTable ) fftw_free( flyTable );
 #if NEW_HARMONIC
 		if( weights ) delete[] weights;
 #endif // NEW_HARMONIC
 		bw=0;
-		workSpace=resultSpace=transposeResultSpace=NULL;
+		workSpace=NULL;
+		tables=NULL;
 		table=transposeTable=NULL;
+		flyTable=NULL;
+		forwardPlan=inversePlan=NULL;
 #if NEW_HARMONIC
 		weights = NULL;
 #endif // NEW_HARMONIC
 		if( b>0 )
 		{
 			bw = b;
-			workSpace = new Real[4*bw*bw+36*bw];
-			resultSpace = new Real[Spharmonic_TableSize(bw)];
-			transposeResultSpace = new Real[Spharmonic_TableSize(bw)];
+			workSpace = (Real*)fftw_malloc( sizeof(Real)*(4*bw*bw+36*bw) );
 #if NEW_HARMONIC
 			weights = new double*[4*bw];
 #endif // NEW_HARMONIC
-			table			=           Spharmonic_Pml_Table(bw,resultSpace,workSpace);
-			transposeTable	= Transpose_Spharmonic_Pml_Table(table,bw,transposeResultSpace,workSpace);
+			// Plan on (aligned) scratch arrays, since FFTW_MEASURE overwrites them.
+			// The transforms then execute the plans on the grid's samples, which are allocated with the same alignment.
+			Real* data = (Real*)fftw_malloc( sizeof(Real)*size*size );
+#pragma omp critical (FFTWPlanner)
+			{
+				forwardPlan =    FST_semi_memo_fftw_plan( data , workSpace , size , measure ? FFTW_MEASURE : FFTW_ESTIMATE );
+				inversePlan = InvFST_semi_memo_fftw_plan( data , workSpace , size , measure ? FFTW_MEASURE : FFTW_ESTIMATE );
+			}
+			fftw_free( data );
+			// Band-widths that are not powers of two use FFTW cosine transforms and quadrature weights computed on the fly.
+			// Both are cached by SOFT, so create them here rather than from within concurrent transforms.
+			if( bw & (bw-1) ) Init_fftwFCT( bw ) , Init_fftwFCT( 2*bw ) , get_weights( bw );
+			// The Legendre tables are shared by all transforms of the same band-width.
+			// Above the budget, only the tables of one order are kept, unless the bundle maps them into memory.
+			bool mapped = TransformBundle::Default().template legendreTable< Real >( bw ) && TransformBundle::Default().template transposeLegendreTable< Real >( bw );
+			if( !mapped && sizeof(Real)*2*size_t( Spharmonic_TableSize( bw ) )>LegendreTableBudget )
+				flyTable = (Real*)fftw_malloc( sizeof(Real)*FST_semi_fly_fftw_TableSize( bw ) );
+			else
+			{
+				tables = LegendreTables< Real >::Acquire( bw );
+				table = tables->table;
+				transposeTable = tables->transposeTable;
+			}
 		}
+		// Re-select the engines (and re-compute the fast transform data) for the new band-width
+		if( fltTable ) delete[] fltTable;
+		if( fltSpace ) delete[] fltSpace;
+		fltTable = NULL;
+		fltSpace = NULL;
+		engines.clear();
+		setEngine( engine , crossover );
 	}
+	return 1;
+}
+template< class Real >
+void HarmonicTransform< Real >::ScratchSpace::setEngine( int e , int c )
+{
+	std::vector< int > _engines( bw , SEMINAIVE );
+	if( e==PROFILED )
+	{
+		const int* profile = TransformBundle::Default().template legendreEngines< Real >( bw );
+		if( profile ) for( int m=0 ; m<bw ; m++ ) if( profile[m]==FAST_LEGENDRE || profile[m]==NAIVE ) _engines[m] = profile[m];
+	}
+	else for( int m=0 ; m<bw ; m++ ) _engines[m] = e;
+	// Without the Legendre tables, the lower degrees of the seminaive and fast transforms cannot be computed
+	if( !table ) for( int m=0 ; m<bw ; m++ ) _engines[m] = NAIVE;
+	engine = e;
+	if( _engines==engines && c==crossover ) return;
+	engines = _engines;
+	crossover = c;
+	if( fltTable ) delete[] fltTable;
+	if( fltSpace ) delete[] fltSpace;
+	fltTable = NULL;
+	fltSpace = NULL;
+
+	// The fast Legendre transform data is only computed for the orders that use it
+	size_t size = 0;
+	for( int m=0 ; m<bw ; m++ ) if( engines[m]==FAST_LEGENDRE ) size += FLT_TableSize( bw , m , crossover );
+	if( size )
+	{
+		fltSpace = new Real[ size ];
+		fltTable = new Real*[ bw ];
+		Real* _fltSpace = fltSpace;
+		for( int m=0 ; m<bw ; m++ )
+		{
+			fltTable[m] = NULL;
+			int sz = engines[m]==FAST_LEGENDRE ? FLT_TableSize( bw , m , crossover ) : 0;
+			if( sz ) FLT_TableGen( bw , m , crossover , _fltSpace ) , fltTable[m] = _fltSpace , _fltSpace += sz;
+		}
+		// The fast transform uses cosine transforms of the sample count and of the powers of two below it
+		for( int n=2 ; n<2*bw ; n<<=1 ) Init_fftwFCT( n );
+		Init_fftwFCT( 2*bw );
+	}
+}
+template< class Real >
+void HarmonicTransform< Real >::ScratchSpace::setGaussLegendre( void )
+{
+	if( glTable || bw<=0 ) return;
+	int size = 2*bw , half = (bw+1)/2;
+	GaussLegendreGrid< Real >::Quadrature( bw , glNodes , glWeights );
+
+	// For each order m and degree l>=m, the values of P(m,l) at the non-negative nodes
+	// (those at the negative nodes follow from the parity of P(m,l))
+	size_t tableSize = size_t( bw*(bw+1)/2 ) * half;
+	glOnTheFly = sizeof(Real)*tableSize>LegendreTableBudget;
+	if( glOnTheFly ) glTable = new Real[ bw*half ];
+	else
+	{
+		glTable = new Real[ tableSize ];
+		Real* table = glTable;
+		for( int m=0 ; m<bw ; table+=(bw-m)*half , m++ ) setGaussLegendreOrder( m , table );
+	}
+
+	// Plan on (aligned) scratch arrays, since FFTW_MEASURE overwrites them
+	glData = (Real*)fftw_malloc( sizeof(Real) * bw * (size+2) );
+	Real* data = (Real*)fftw_malloc( sizeof(Real) * bw * size );
+#pragma omp critical (FFTWPlanner)
+	{
+		glForwardPlan = GaussLegendrePlan( data , glData , size , bw , true  , measure ? FFTW_MEASURE : FFTW_ESTIMATE );
+		glInversePlan = GaussLegendrePlan( data , glData , size , bw , false , measure ? FFTW_MEASURE : FFTW_ESTIMATE );
+	}
+	fftw_free( data );
+}
+template< class Real >
+void HarmonicTransform< Real >::ScratchSpace::setGaussLegendreOrder( int m , Real* table ) const
+{
+	int half = (bw+1)/2;
+	std::vector< double > p0( half ) , p1( half );
+	// The norming constant of P(m,m), as in the SOFT tables
+	double mcons = sqrt( m+0.5 );
+	for( int i=0 ; i<m ; i++ ) mcons *= sqrt( ( m-i/2. ) / ( m-i ) );
+	if( m ) mcons *= pow( 2. , -m/2. );
+	if( m&1 ) mcons = -mcons;
+	for( int j=0 ; j<half ; j++ ) p0[j] = 0 , p1[j] = mcons * pow( sqrt( 1. - glNodes[j]*glNodes[j] ) , double(m) );
+	for( int l=m ; l<bw ; l++ )
+	{
+		for( int j=0 ; j<half ; j++ ) table[j] = Real( p1[j] );
+		table += half;
+		// P(m,l+1) = a * x * P(m,l) + c * P(m,l-1)
+		double a = sqrt( double( (2*l+1)*(2*l+3) ) / ( (l-m+1)*(l+m+1) ) );
+		double c = l>m ? -sqrt( double( 2*l+3 ) * (l-m) * (l+m) / ( double( 2*l-1 ) * (l-m+1) * (l+m+1) ) ) : 0;
+		for( int j=0 ; j<half ; j++ )
+		{
+			double t = a * glNodes[j] * p1[j] + c * p0[j];
+			p0[j] = p1[j] , p1[j] = t;
+		}
+	}
+}
+template< class Real >
+const Real* HarmonicTransform< Real >::ScratchSpace::gaussLegendreTable( int m )
+{
+	if( glOnTheFly )
+	{
+		setGaussLegendreOrder( m , glTable );
+		return glTable;
+	}
+	else return glTable + size_t( m*bw - m*(m-1)/2 ) * ( (bw+1)/2 );
+}
+template< class Real >
+void HarmonicTransform< Real >::ScratchSpace::resizeBatch( int b )
+{
+	if( b!=batchSize )
+	{
+		int size = 2*bw;
+#pragma omp critical (FFTWPlanner)
+		{
+			if( batchPlan ) DestroyFFTWPlan( batchPlan );
+			if( batchDCTPlan ) DestroyFFTWPlan( batchDCTPlan );
+			if( cutOffDCTPlan ) DestroyFFTWPlan( cutOffDCTPlan );
+		}
+		if( batchData ) fftw_free( batchData );
+		if( batchWorkSpace ) fftw_free( batchWorkSpace );
+		batchSize = 0;
+		batchData = batchWorkSpace = NULL;
+		batchPlan = batchDCTPlan = cutOffDCTPlan = NULL;
+		cutOffOrders = 0;
+		if( b>0 && bw>0 )
+		{
+			batchSize = b;
+			batchData = (Real*)fftw_malloc( sizeof(Real)*size*size*batchSize );
+			batchWorkSpace = (Real*)fftw_malloc( sizeof(Real)*( 4*bw*(bw+1)*batchSize + 4*bw*bw*batchSize + 6*bw*batchSize + 24*bw ) );
+#pragma omp critical (FFTWPlanner)
+			{
+				batchPlan = FST_semi_memo_fftw_batch_plan( batchData , batchWorkSpace , size , batchSize , measure ? FFTW_MEASURE : FFTW_ESTIMATE );
+				batchDCTPlan = FST_semi_memo_fftw_batch_dct_plan( batchWorkSpace , size , batchSize , bw , measure ? FFTW_MEASURE : FFTW_ESTIMATE );
+			}
+		}
+	}
+}
+template< class Real >
+typename FFTWPlan< Real >::Plan HarmonicTransform< Real >::ScratchSpace::dctPlan( int bandWidth )
+{
+	// The orders at and above the cut-off have no coefficients, so their samples need not be cosine transformed
+	// (With a zero cut-off, the plan of a single order is executed, and its output ignored.)
+	int orders = std::max< int >( bandWidth , 1 );
+	if( orders>=bw ) return batchDCTPlan;
+	if( orders!=cutOffOrders )
+	{
+#pragma omp critical (FFTWPlanner)
+		{
+			if( cutOffDCTPlan ) DestroyFFTWPlan( cutOffDCTPlan );
+			cutOffDCTPlan = FST_semi_memo_fftw_batch_dct_plan( batchWorkSpace , 2*bw , batchSize , orders , measure ? FFTW_MEASURE : FFTW_ESTIMATE );
+		}
+		cutOffOrders = orders;
+	}
+	return cutOffDCTPlan;
 }
 ///////////////////////
 // HarmonicTransform //
 ///////////////////////
 template< class Real > HarmonicTransform< Real >::HarmonicTransform( void ){ ; }
-template< class Real > HarmonicTransform< Real >::HarmonicTransform( int resolution ){ resize( resolution ); }
+template< class Real > HarmonicTransform< Real >::HarmonicTransform( int resolution , bool measure ){ resize( resolution , measure ); }
 template<class Real>
-void HarmonicTransform<Real>::resize( const int& resolution ){ scratch.resize(resolution>>1); }
+int HarmonicTransform<Real>::resize( const int& resolution ){ return scratch.resize(resolution>>1); }
+template<class Real>
+int HarmonicTransform<Real>::resize( const int& resolution , bool measure ){ return scratch.resize( resolution>>1 , measure ); }
+template< class Real >
+void HarmonicTransform< Real >::setLegendreEngine( int engine , int crossover ){ scratch.setEngine( engine , std::max< int >( crossover , 0 ) ); }
+template< class Real >
+void HarmonicTransform< Real >::TuneLegendreEngines( int resolution , int batchSize , std::vector< int >& engines , double minTime , bool measure )
+{
+	int bw = resolution>>1;
+	engines.resize( bw );
+	for( int m=0 ; m<bw ; m++ ) engines[m] = SEMINAIVE;
+	if( !bw || batchSize<1 ) return;
+
+	// Running the transform with the fast engine creates the fast transform data for all the orders that can use it,
+	// and leaves the weighted samples and their cosine transforms in the scratch space
+	HarmonicTransform< Real > hForm( resolution , measure );
+	hForm.setLegendreEngine( FAST_LEGENDRE );
+	std::vector< SphericalGrid< Real > > grids( batchSize );
+	std::vector< FourierKeyS2< Real > > keys;
+	for( int i=0 ; i<grids.size() ; i++ )
+	{
+		grids[i].resize( resolution );
+		for( int j=0 ; j<resolution*resolution ; j++ ) grids[i][0][j] = Real( rand() ) / RAND_MAX - Real( 0.5 );
+	}
+	if( !hForm.ForwardFourier( grids , keys ) ) return;
+
+	const ScratchSpace& scratch = hForm.scratch;
+	for( int m=0 ; m<bw ; m++ )
+	{
+		double bestTime = 0;
+		for( int e=SEMINAIVE ; e<PROFILED ; e++ )
+		{
+			if( e==SEMINAIVE && !scratch.table ) continue;
+			if( e==FAST_LEGENDRE && !( scratch.fltTable && scratch.fltTable[m] && scratch.table ) ) continue;
+			int count = 0;
+			double t = omp_get_wtime() , elapsed;
+			do FST_semi_memo_fftw_batch_order( scratch.batchWorkSpace , resolution , batchSize , m , bw , e , scratch.table , scratch.fltTable , scratch.crossover ) , count++;
+			while( ( elapsed = omp_get_wtime()-t )<minTime );
+			if( !bestTime || elapsed/count<bestTime ) engines[m] = e , bestTime = elapsed/count;
+		}
+	}
+}
+int HarmonicTransform< double >::ForwardFourier( std::vector< SphericalGrid< double > >& g , std::vector< FourierKeyS2< double > >& keys , int bandWidth )
+{
+	if( !g.size() ) return 1;
+	int sz = g[0].resolution() , bw = sz>>1;
+	if( bandWidth>bw ) bandWidth = bw;
+	if( bandWidth<0 ) bandWidth = 0;
+	for( int i=1 ; i<g.size() ; i++ ) if( g[i].resolution()!=sz )
+	{
+		fprintf( stderr , "[ERROR] HarmonicTransform::ForwardFourier: Batched grids must have the same resolution: %d != %d\n" , g[i].resolution() , sz );
+		return 0;
+	}
+	keys.resize( g.size() );
+	std::vector< fftw_complex* > coeffs( g.size() );
+	for( int i=0 ; i<g.size() ; i++ )
+	{
+		if( keys[i].resolution()!=sz ) keys[i].resize( sz );
+		coeffs[i] = (fftw_complex*)&keys[i](0,0);
+	}
+	if( !scratch.resize( bw ) ) return 0;
+	scratch.resizeBatch( int( g.size() ) );
+	for( int i=0 ; i<g.size() ; i++ ) memcpy( scratch.batchData + i*sz*sz , g[i][0] , sizeof(double)*sz*sz );
+	FST_semi_memo_fftw_batch( scratch.batchData , &coeffs[0] , sz , int( g.size() ) , bandWidth , scratch.table , &scratch.engines[0] , scratch.fltTable , scratch.crossover , scratch.batchWorkSpace , scratch.batchPlan , scratch.dctPlan( bandWidth ) );
+	return 1;
+}
+int HarmonicTransform< double >::ForwardFourier( SphericalGrid< double >& g , FourierKeyS2< double >& key , int bandWidth )
+{
+	int sz = g.resolution() , bw = sz>>1;
+	if( bandWidth>bw ) bandWidth = bw;
+	if( bandWidth<0 ) bandWidth = 0;
+	if( key.resolution()!=sz ) key.resize( sz );
+	fftw_complex* coeffs = (fftw_complex*)&key(0,0);
+	// Use the batched transform with a single signal, since it supports the cut-off
+	if( !scratch.resize( bw ) ) return 0;
+	scratch.resizeBatch( 1 );
+	memcpy( scratch.batchData , g[0] , sizeof(double)*sz*sz );
+	FST_semi_memo_fftw_batch( scratch.batchData , &coeffs , sz , 1 , bandWidth , scratch.table , &scratch.engines[0] , scratch.fltTable , scratch.crossover , scratch.batchWorkSpace , scratch.batchPlan , scratch.dctPlan( bandWidth ) );
+	return 1;
+}
+int HarmonicTransform< float >::ForwardFourier( std::vector< SphericalGrid< float > >& g , std::vector< FourierKeyS2< float > >& keys , int bandWidth )
+{
+	if( !g.size() ) return 1;
+	int sz = g[0].resolution() , bw = sz>>1;
+	if( bandWidth>bw ) bandWidth = bw;
+	if( bandWidth<0 ) bandWidth = 0;
+	for( int i=1 ; i<g.size() ; i++ ) if( g[i].resolution()!=sz )
+	{
+		fprintf( stderr , "[ERROR] HarmonicTransform::ForwardFourier: Batched grids must have the same resolution: %d != %d\n" , g[i].resolution() , sz );
+		return 0;
+	}
+	keys.resize( g.size() );
+	std::vector< fftwf_complex* > coeffs( g.size() );
+	for( int i=0 ; i<g.size() ; i++ )
+	{
+		if( keys[i].resolution()!=sz ) keys[i].resize( sz );
+		coeffs[i] = (fftwf_complex*)&keys[i](0,0);
+	}
+	if( !scratch.resize( bw ) ) return 0;
+	scratch.resizeBatch( int( g.size() ) );
+	for( int i=0 ; i<g.size() ; i++ ) memcpy( scratch.batchData + i*sz*sz , g[i][0] , sizeof(float)*sz*sz );
+	FST_semi_memo_fftw_batch( scratch.batchData , &coeffs[0] , sz , int( g.size() ) , bandWidth , scratch.table , &scratch.engines[0] , scratch.fltTable , scratch.crossover , scratch.batchWorkSpace , scratch.batchPlan , scratch.dctPlan( bandWidth ) );
+	return 1;
+}
+int HarmonicTransform< float >::ForwardFourier( SphericalGrid< float >& g , FourierKeyS2< float >& key , int bandWidth )
+{
+	int sz = g.resolution() , bw = sz>>1;
+	if( bandWidth>bw ) bandWidth = bw;
+	if( bandWidth<0 ) bandWidth = 0;
+	if( key.resolution()!=sz ) key.resize( sz );
+	fftwf_complex* coeffs = (fftwf_complex*)&key(0,0);
+	// Use the batched transform with a single signal, since it supports the cut-off
+	if( !scratch.resize( bw ) ) return 0;
+	scratch.resizeBatch( 1 );
+	memcpy( scratch.batchData , g[0] , sizeof(float)*sz*sz );
+	FST_semi_memo_fftw_batch( scratch.batchData , &coeffs , sz , 1 , bandWidth , scratch.table , &scratch.engines[0] , scratch.fltTable , scratch.crossover , scratch.batchWorkSpace , scratch.batchPlan , scratch.dctPlan( bandWidth ) );
+	return 1;
+}
+int HarmonicTransform< double >::ForwardFourier( std::vector< SphericalGrid< double > >& g , FourierKeyS2Array< double >& keys , int bandWidth )
+{
+	if( !g.size() ) return 1;
+	int sz = g[0].resolution() , bw = sz>>1;
+	if( bandWidth>bw ) bandWidth = bw;
+	if( bandWidth<0 ) bandWidth = 0;
+	for( int i=1 ; i<g.size() ; i++ ) if( g[i].resolution()!=sz )
+	{
+		fprintf( stderr , "[ERROR] HarmonicTransform::ForwardFourier: Batched grids must have the same resolution: %d != %d\n" , g[i].resolution() , sz );
+		return 0;
+	}
+	// The batched transform writes the coefficients straight into the shells, since the array has its layout
+	if( !keys.resize( sz , int( g.size() ) , false ) ) return 0;
+	if( !scratch.resize( bw ) ) return 0;
+	scratch.resizeBatch( int( g.size() ) );
+	for( int i=0 ; i<g.size() ; i++ ) memcpy( scratch.batchData + i*sz*sz , g[i][0] , sizeof(double)*sz*sz );
+	FST_semi_memo_fftw_batch_interleaved( scratch.batchData , (fftw_complex*)keys(0,0) , sz , int( g.size() ) , bandWidth , scratch.table , &scratch.engines[0] , scratch.fltTable , scratch.crossover , scratch.batchWorkSpace , scratch.batchPlan , scratch.dctPlan( bandWidth ) );
+	return 1;
+}
+int HarmonicTransform< float >::ForwardFourier( std::vector< SphericalGrid< float > >& g , FourierKeyS2Array< float >& keys , int bandWidth )
+{
+	if( !g.size() ) return 1;
+	int sz = g[0].resolution() , bw = sz>>1;
+	if( bandWidth>bw ) bandWidth = bw;
+	if( bandWidth<0 ) bandWidth = 0;
+	for( int i=1 ; i<g.size() ; i++ ) if( g[i].resolution()!=sz )
+	{
+		fprintf( stderr , "[ERROR] HarmonicTransform::ForwardFourier: Batched grids must have the same resolution: %d != %d\n" , g[i].resolution() , sz );
+		return 0;
+	}
+	// The batched transform writes the coefficients straight into the shells, since the array has its layout
+	if( !keys.resize( sz , int( g.size() ) , false ) ) return 0;
+	if( !scratch.resize( bw ) ) return 0;
+	scratch.resizeBatch( int( g.size() ) );
+	for( int i=0 ; i<g.size() ; i++ ) memcpy( scratch.batchData + i*sz*sz , g[i][0] , sizeof(float)*sz*sz );
+	FST_semi_memo_fftw_batch_interleaved( scratch.batchData , (fftwf_complex*)keys(0,0) , sz , int( g.size() ) , bandWidth , scratch.table , &scratch.engines[0] , scratch.fltTable , scratch.crossover , scratch.batchWorkSpace , scratch.batchPlan , scratch.dctPlan( bandWidth ) );
+	return 1;
+}
 int HarmonicTransform< double >::ForwardFourier( SphericalGrid< double >& g , FourierKeyS2< double >& key )
 {
 	int sz,bw;
 	sz=g.resolution();
 	bw=sz>>1;
 	if(key.resolution()!=sz){key.resize(sz);}
-	scratch.resize(bw);
-	FST_semi_memo_fftw( g[0] , (fftw_complex*)&key(0,0) , sz , scratch.table , scratch.workSpace );
+	if( !scratch.resize( bw ) ) return 0;
+	// Without the Legendre tables, the batched transform's naive engine is faster than computing the tables on the fly
+	if( !scratch.table ) return ForwardFourier( g , key , bw );
+	FST_semi_memo_fftw( g[0] , (fftw_complex*)&key(0,0) , sz , scratch.table , scratch.workSpace , scratch.forwardPlan );
 	return 1;
 }
 int HarmonicTransform<float>::ForwardFourier( SphericalGrid<float>& g , FourierKeyS2<float>& key )
 {
 	int sz = g.resolution() , bw = sz>>1;
 	if( key.resolution()!=sz ) key.resize(sz);
-	scratch.resize( bw );
-	FST_semi_memo_fftw( g[0] , (fftwf_complex*)&key(0,0) , sz , scratch.table , scratch.workSpace );
+	if( !scratch.resize( bw ) ) return 0;
+	// Without the Legendre tables, the batched transform's naive engine is faster than computing the tables on the fly
+	if( !scratch.table ) return ForwardFourier( g , key , bw );
+	FST_semi_memo_fftw( g[0] , (fftwf_complex*)&key(0,0) , sz , scratch.table , scratch.workSpace , scratch.forwardPlan );
 	return 1;
 }
+template< class Real >
+int HarmonicTransform< Real >::ForwardFourier( std::vector< SphericalGrid< Real > >& , std::vector< FourierKeyS2< Real > >& , int )
+{
+	fprintf(stderr,"Harmonic Transform only supported for floats and doubles\n");
+	return 0;
+}
+template< class Real >
+int HarmonicTransform< Real >::ForwardFourier( SphericalGrid< Real >& , FourierKeyS2< Real >& , int )
+{
+	fprintf(stderr,"Harmonic Transform only supported for floats and doubles\n");
+	return 0;
+}
+template< class Real >
+int HarmonicTransform< Real >::ForwardFourier( std::vector< SphericalGrid< Real > >& g , std::vector< FourierKeyS2< Real > >& keys )
+{
+	return ForwardFourier( g , keys , g.size() ? g[0].resolution()>>1 : 0 );
+}
+template< class Real >
+int HarmonicTransform< Real >::ForwardFourier( std::vector< SphericalGrid< Real > >& , FourierKeyS2Array< Real >& , int )
+{
+	fprintf(stderr,"Harmonic Transform only supported for floats and doubles\n");
+	return 0;
+}
 template<class Real>
 int HarmonicTransform<Real>::ForwardFourier(SphericalGrid<Real>&,FourierKeyS2<Real>&){
 	fprintf(stderr,"Harmonic Transform only supported for floats and doubles\n");
@@ -221,22 +940,90 @@ int HarmonicTransform<Real>::ForwardFourier(SphericalGrid<Real>&,FourierKeyS2<Re
 int HarmonicTransform<double>::InverseFourier(FourierKeyS2<double>& key,SphericalGrid<double>& g){
 	if(key.resolution()!=g.resolution()){g.resize(key.resolution());}
 	int bw=key.bandWidth(),sz=g.resolution();
-	scratch.resize(bw);
+	if( !scratch.resize( bw ) ) return 0;
 
-	InvFST_semi_memo_fftw((fftw_complex*)&key(0,0),g[0],sz,scratch.transposeTable,scratch.workSpace);
+	if(scratch.transposeTable)	InvFST_semi_memo_fftw((fftw_complex*)&key(0,0),g[0],sz,scratch.transposeTable,scratch.workSpace,scratch.inversePlan);
+	else						InvFST_semi_fly_fftw ((fftw_complex*)&key(0,0),g[0],sz,scratch.flyTable,scratch.workSpace,scratch.inversePlan);
 	return 1;
 }
 int HarmonicTransform<float>::InverseFourier(FourierKeyS2<float>& key,SphericalGrid<float>& g)
 {
 	if(key.resolution()!=g.resolution()){g.resize(key.resolution());}
 	int bw=key.bandWidth(),sz=g.resolution();
-	scratch.resize(bw);
+	if( !scratch.resize( bw ) ) return 0;
 
-	InvFST_semi_memo_fftw((fftwf_complex*)&key(0,0),g[0],sz,scratch.transposeTable,scratch.workSpace);
+	if(scratch.transposeTable)	InvFST_semi_memo_fftw((fftwf_complex*)&key(0,0),g[0],sz,scratch.transposeTable,scratch.workSpace,scratch.inversePlan);
+	else						InvFST_semi_fly_fftw ((fftwf_complex*)&key(0,0),g[0],sz,scratch.flyTable,scratch.workSpace,scratch.inversePlan);
 	return 1;
 }
 template<class Real>
 int HarmonicTransform<Real>::InverseFourier(FourierKeyS2<Real>&,SphericalGrid<Real>&){
 	fprintf(stderr,"Harmonic Transform only supported for floats and doubles\n");
 	return 0;
+}
+template< class Real >
+int HarmonicTransform< Real >::ForwardFourier( GaussLegendreGrid< Real >& g , FourierKeyS2< Real >& key )
+{
+	int sz = g.resolution() , bw = sz>>1 , half = (bw+1)/2;
+	if( key.resolution()!=sz ) key.resize( sz );
+	if( !scratch.resize( bw ) ) return 0;
+	scratch.setGaussLegendre();
+	ExecuteForwardPlan( scratch.glForwardPlan , g[0] , scratch.glData );
+
+	const Complex< Real >* coeffs = (const Complex< Real >*)scratch.glData;
+	std::vector< Complex< Real > > even( half ) , odd( half );
+	for( int m=0 ; m<bw ; m++ )
+	{
+		const Real* table = scratch.gaussLegendreTable( m );
+		// The samples at x and -x, folded and weighted by the quadrature (and the normalization of the FFT)
+		Real scale = Real( sqrt( 2.*PI ) / sz );
+		for( int j=0 ; j<half ; j++ )
+		{
+			Complex< Real > c1 = coeffs[j*(bw+1)+m] , c2 = coeffs[(bw-1-j)*(bw+1)+m];
+			Real w = Real( scratch.glWeights[j] ) * scale;
+			if( j==bw-1-j ) even[j] = c1*w , odd[j] = Complex< Real >( 0 , 0 );
+			else even[j] = (c1+c2)*w , odd[j] = (c1-c2)*w;
+		}
+		for( int l=m ; l<bw ; l++ , table+=half )
+		{
+			const Complex< Real >* f = ( (l-m)&1 ) ? &odd[0] : &even[0];
+			Real r = 0 , i = 0;
+			for( int j=0 ; j<half ; j++ ) r += f[j].r * table[j] , i += f[j].i * table[j];
+			key(l,m) = Complex< Real >( r , i );
+		}
+	}
+	return 1;
+}
+template< class Real >
+int HarmonicTransform< Real >::InverseFourier( FourierKeyS2< Real >& key , GaussLegendreGrid< Real >& g )
+{
+	if( key.resolution()!=g.resolution() ) g.resize( key.resolution() );
+	int sz = g.resolution() , bw = sz>>1 , half = (bw+1)/2;
+	if( !scratch.resize( bw ) ) return 0;
+	scratch.setGaussLegendre();
+
+	Complex< Real >* coeffs = (Complex< Real >*)scratch.glData;
+	std::vector< Complex< Real > > even( half ) , odd( half );
+	for( int m=0 ; m<bw ; m++ )
+	{
+		const Real* table = scratch.gaussLegendreTable( m );
+		// Accumulate the even and odd parts of the sums at the non-negative nodes
+		for( int j=0 ; j<half ; j++ ) even[j] = odd[j] = Complex< Real >( 0 , 0 );
+		for( int l=m ; l<bw ; l++ , table+=half )
+		{
+			Complex< Real >* f = ( (l-m)&1 ) ? &odd[0] : &even[0];
+			Real r = key(l,m).r , i = key(l,m).i;
+			for( int j=0 ; j<half ; j++ ) f[j].r += r * table[j] , f[j].i += i * table[j];
+		}
+		// Unfold the sums into the coefficients of the FFTs
+		Real scale = Real( 1. / sqrt( 2.*PI ) );
+		for( int j=0 ; j<half ; j++ )
+		{
+			coeffs[j*(bw+1)+m] = ( even[j]+odd[j] ) * scale;
+			if( j!=bw-1-j ) coeffs[(bw-1-j)*(bw+1)+m] = ( even[j]-odd[j] ) * scale;
+		}
+	}
+	for( int j=0 ; j<bw ; j++ ) coeffs[j*(bw+1)+bw] = Complex< Real >( 0 , 0 );
+	ExecuteInversePlan( scratch.glInversePlan , scratch.glData , g[0] );
+	return 1;
 }
\ No newline at end of file
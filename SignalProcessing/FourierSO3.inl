@@ -29,26 +29,36 @@ DAMAGE.
 #include <stdio.h>
 #include <string.h>
 #include <soft_fftw.h>
+#include <soft_fftw_pc.h>
+#include <soft_fftw_mt.h>
 #include <utils_so3.h>
+#include <makeWigner.h>
+// SOFT's rotation code is written in terms of its REAL type, which it is compiled with as double
+#define REAL double
+#include <rotate_so3.h>
+#undef REAL
 #include <math.h>
+#include <float.h>
 #include "fftw3.h"
 
 ///////////////////
 // FourierKeySO3 //
 ///////////////////
 template<class Real> int FourierKeySO3<Real>::Entries( int bw ){ return (4*bw*bw*bw+3*bw*bw-bw)/6; }
-template<class Real> FourierKeySO3<Real>::FourierKeySO3( void ) : bw(0) , values(NULL) { ; }
-template<class Real> FourierKeySO3<Real>::FourierKeySO3( int res ) : bw(0) , values(NULL) { resize(res); }
-template<class Real> FourierKeySO3<Real>::FourierKeySO3( const FourierKeySO3< Real >& key ) : bw(0) , values(NULL)
+template<class Real> FourierKeySO3<Real>::FourierKeySO3( void ) : bw(0) , values(NULL) , softNative(false) { ; }
+template<class Real> FourierKeySO3<Real>::FourierKeySO3( int res ) : bw(0) , values(NULL) , softNative(false) { resize(res); }
+template<class Real> FourierKeySO3<Real>::FourierKeySO3( const FourierKeySO3< Real >& key ) : bw(0) , values(NULL) , softNative(false)
 {
 	resize( key.resolution() );
 	memcpy( values , key.values , sizeof( Complex< Real > ) * Entries(bw) );
+	softNative = key.softNative;
 }
 template< class Real >
 FourierKeySO3< Real >& FourierKeySO3< Real >::operator = ( const FourierKeySO3< Real >& key )
 {
 	resize( key.resolution() );
-	memcpy( values , key.values , sizeof( Complex< Real > ) * Entires(bw) );
+	memcpy( values , key.values , sizeof( Complex< Real > ) * Entries(bw) );
+	softNative = key.softNative;
 	return *this;
 }
 
@@ -77,11 +87,19 @@ template<class Real> int FourierKeySO3<Real>::read(FILE* fp){
 	r=int(fread(&b,sizeof(int),1,fp));
 	if(!r){return 0;}
 	resize(b);
+	// The coefficients are stored unweighted
+	softNative=false;
 	r=int(fread(values,sizeof(Complex<Real>),Entries(bw),fp));
 	if(r==Entries(bw)){return 1;}
 	else{return 0;}
 }
 template<class Real> int FourierKeySO3<Real>::write(FILE* fp) const {
+	if( softNative )
+	{
+		FourierKeySO3 key( *this );
+		key.setSOFTNative( false );
+		return key.write( fp );
+	}
 	int w;
 	w=int(fwrite(&bw,sizeof(int),1,fp));
 	if(!w){return 0;}
@@ -116,9 +134,64 @@ template<class Real> Complex<Real>  FourierKeySO3<Real>::operator() ( int b , in
 {
 	return i<0 ? values[so3CoefLoc(-i,-j,b,bw)].conjugate() : values[so3CoefLoc(i,j,b,bw)];
 }
+template< class Real > bool FourierKeySO3< Real >::isSOFTNative( void ) const { return softNative; }
+template< class Real >
+void FourierKeySO3< Real >::setSOFTNative( bool native )
+{
+	if( native==softNative ) return;
+	if( bw ) _weigh( values , values , !native );
+	softNative = native;
+}
+template< class Real >
+Real FourierKeySO3< Real >::SOFTWeight( int b , int i , int j )
+{
+	// The normalization and the sign with which WignerDTransform used to pack the coefficients for SOFT
+	Real w = Real( sqrt( 8.0*PI*PI/(2*b+1) ) );
+	if( j<0 ) return (   i%2 ) ? -w : w;
+	else      return ( (i+j)%2 ) ? -w : w;
+}
+template< class Real > const Complex< Real >* FourierKeySO3< Real >::softCoefficients( void ) const { return softNative ? values : NULL; }
+template< class Real >
+void FourierKeySO3< Real >::getSOFTCoefficients( Complex< Real >* coefficients ) const
+{
+	if( softNative ) memcpy( coefficients , values , sizeof( Complex< Real > ) * Entries(bw) );
+	else if( bw ) _weigh( values , coefficients , false );
+}
+template< class Real >
+void FourierKeySO3< Real >::truncate( int resolution , FourierKeySO3< Real >& key ) const
+{
+	key.resize( resolution );
+	key.softNative = softNative;
+	// The SOFT weights only depend on the indices of the coefficient, so the stored values can be copied in either mode
+	int _bw = std::min< int >( bw , key.bw );
+	for( int b=0 ; b<_bw ; b++ ) for( int i=0 ; i<=b ; i++ ) for( int j=-b ; j<=b ; j++ ) key.values[ so3CoefLoc(i,j,b,key.bw) ] = values[ so3CoefLoc(i,j,b,bw) ];
+}
+template< class Real >
+void FourierKeySO3< Real >::_weigh( const Complex< Real >* in , Complex< Real >* out , bool inverse ) const
+{
+	std::vector< int > offsets;
+	std::vector< Real > weights( bw );
+	_SetRunOffsets( bw , offsets );
+	for( int b=0 ; b<bw ; b++ ) weights[b] = inverse ? Real(1)/SOFTWeight( b , 0 , 0 ) : SOFTWeight( b , 0 , 0 );
+	for( int i=0 ; i<bw ; i++ ) for( int j=-bw+1 ; j<bw ; j++ )
+	{
+		// The sign of the weight is the same for the whole run (and the weight of (b,0,0) is positive)
+		int b0 = std::max< int >( i , j<0 ? -j : j );
+		Real sign = SOFTWeight( b0 , i , j )<0 ? Real(-1) : Real(1);
+		int offset = offsets[ i*(2*bw-1) + j+bw-1 ];
+		for( int b=b0 ; b<bw ; b++ ) out[offset+b] = in[offset+b] * ( weights[b] * sign );
+	}
+}
 template< class Real >
 void FourierKeySO3< Real >::Add( const FourierKeySO3< Real >& key )
 {
+	if( key.softNative!=softNative )
+	{
+		FourierKeySO3 _key( key );
+		_key.setSOFTNative( softNative );
+		Add( _key );
+		return;
+	}
 	for( int b=0 ; b<bw && b<key.bw ; b++ ) for( int i=0 ; i<=b ; i++ ) for( int j=-b ; j<=b ; j++ ) (*this)(b,i,j) += key(b,i,j);
 }
 template< class Real >
@@ -136,179 +209,529 @@ Real FourierKeySO3< Real >::InnerProduct( const FourierKeySO3< Real >& key ) con
 	// =>
 	// h-hat(b,-i,-j) = (-1)^(i+j) * h-hat(b,i, j).conjugate()
 	// h-hat(b,-i, j) = (-1)^(i+j) * h-hat(b,i,-j).conjugate()
-	Complex< Real > dot = 0;
-	for( int b=0 ; b<bw && b<key.bw ; b++ ) for( int i=-b ; i<=b ; i++ ) for( int j=-b ; j<=b ; j++ ) dot += (*this)(b,i,j)*key(b,i,j).conjugate();
-	return dot.r;
+	// Since only the real part of the dot-product is returned, the contribution of (b,-i,-j) is the same as that of (b,i,j),
+	// so we sum over the stored coefficients, counting those with i>0 twice.
+	// The coefficients are stored in runs over the frequency, with the runs for i=0 coming first:
+	// the first bw*bw coefficients are those with i=0.
+	if( softNative || key.softNative )
+	{
+		FourierKeySO3 key1( *this ) , key2( key );
+		key1.setSOFTNative( false ) , key2.setSOFTNative( false );
+		return key1.InnerProduct( key2 );
+	}
+	int _bw = std::min< int >( bw , key.bw );
+	if( !_bw ) return 0;
+	if( bw==key.bw ) return PackedDot( values , key.values , bw*bw ) + PackedDot( values+bw*bw , key.values+bw*bw , Entries(bw)-bw*bw ) * 2;
+
+	Real dot = 0;
+	for( int i=0 ; i<_bw ; i++ ) for( int j=-_bw+1 ; j<_bw ; j++ )
+	{
+		int b = std::max< int >( i , j<0 ? -j : j );
+		Real _dot = PackedDot( values + so3CoefLoc( i , j , b , bw ) , key.values + so3CoefLoc( i , j , b , key.bw ) , _bw-b );
+		dot += i ? _dot*2 : _dot;
+	}
+	return dot;
+}
+template< class Real >
+Real FourierKeySO3< Real >::squareNorm( void ) const
+{
+	if( !bw ) return 0;
+	if( softNative )
+	{
+		FourierKeySO3 key( *this );
+		key.setSOFTNative( false );
+		return key.squareNorm();
+	}
+	return PackedSquareNorm( values , bw*bw ) + PackedSquareNorm( values+bw*bw , Entries(bw)-bw*bw ) * 2;
+}
+template< class Real >
+void FourierKeySO3< Real >::_SetRunOffsets( int bw , std::vector< int >& offsets )
+{
+	offsets.resize( bw * (2*bw-1) );
+	for( int i=0 ; i<bw ; i++ ) for( int j=-bw+1 ; j<bw ; j++ )
+	{
+		int b = std::max< int >( i , j<0 ? -j : j );
+		offsets[ i*(2*bw-1) + j+bw-1 ] = so3CoefLoc( i , j , b , bw ) - b;
+	}
+}
+template< class Real >
+void FourierKeySO3< Real >::addCorrelation( const FourierKeyS2Array< Real >& keys1 , const FourierKeyS2Array< Real >& keys2 , int threads , FourierKeySO3< Real >* antipodalKey )
+{
+	static const int TileSize = 16;
+	struct Tile{ int b , i , j; };
+
+	int _bw = std::min< int >( bw , std::min< int >( keys1.bandWidth() , keys2.bandWidth() ) );
+	if( antipodalKey ) _bw = std::min< int >( _bw , antipodalKey->bw );
+	int shells = std::min< int >( keys1.shells() , keys2.shells() );
+	if( !_bw || !shells ) return;
+
+	std::vector< int > offsets , antipodalOffsets;
+	_SetRunOffsets( bw , offsets );
+	if( antipodalKey ) _SetRunOffsets( antipodalKey->bw , antipodalOffsets );
+
+	// The (unsigned) SOFT weights of the bands, for the keys that are SOFT-native
+	std::vector< Real > weights( _bw );
+	for( int b=0 ; b<_bw ; b++ ) weights[b] = SOFTWeight( b , 0 , 0 );
+
+	// Pack the coefficients of each band into planar real and imaginary matrices,
+	// (b+1) x shells for the first set and shells x (b+1) for the second.
+	size_t sz = size_t( FourierKeyS2< Real >::Entries( _bw ) ) * shells;
+	Real* packed = (Real*)fftw_malloc( sizeof( Real ) * sz * 4 );
+	if( !packed )
+	{
+		fprintf( stderr , "[ERROR] FourierKeySO3::addCorrelation: Failed to allocate packed coefficients\n" );
+		return;
+	}
+	Real *ar = packed , *ai = packed + sz , *br = packed + 2*sz , *bi = packed + 3*sz;
+#pragma omp parallel for num_threads( threads ) schedule( dynamic )
+	for( int b=0 ; b<_bw ; b++ )
+	{
+		size_t offset = size_t( (b*b+b)/2 ) * shells;
+		for( int i=0 ; i<=b ; i++ )
+		{
+			const Complex< Real > *c1 = keys1(b,i) , *c2 = keys2(b,i);
+			for( int s=0 ; s<shells ; s++ )
+			{
+				ar[ offset + i*shells + s ] = c1[s].r , ai[ offset + i*shells + s ] = c1[s].i;
+				br[ offset + s*(b+1) + i ] = c2[s].r , bi[ offset + s*(b+1) + i ] = c2[s].i;
+			}
+		}
+	}
+
+	// Process the tiles of all the bands in a single parallel loop, starting with the largest bands
+	std::vector< Tile > tiles;
+	for( int b=_bw-1 ; b>=0 ; b-- ) for( int i=0 ; i<=b ; i+=TileSize ) for( int j=0 ; j<=b ; j+=TileSize )
+	{
+		Tile tile;
+		tile.b = b , tile.i = i , tile.j = j;
+		tiles.push_back( tile );
+	}
+#pragma omp parallel for num_threads( threads ) schedule( dynamic )
+	for( int t=0 ; t<(int)tiles.size() ; t++ )
+	{
+		int b = tiles[t].b , i0 = tiles[t].i , j0 = tiles[t].j;
+		int iEnd = std::min< int >( i0+TileSize , b+1 ) , w = std::min< int >( TileSize , b+1-j0 );
+		size_t offset = size_t( (b*b+b)/2 ) * shells;
+		Real sign = Real( (b%2) ? -1 : 1 );
+		Real rr[TileSize] , ii[TileSize] , ri[TileSize] , ir[TileSize];
+		for( int i=i0 ; i<iEnd ; i++ )
+		{
+			for( int j=0 ; j<w ; j++ ) rr[j] = ii[j] = ri[j] = ir[j] = 0;
+			// Accumulate the real products along the rows of the tile so that the inner loop is over contiguous memory
+			for( int s=0 ; s<shells ; s++ )
+			{
+				Real _ar = ar[ offset + i*shells + s ] , _ai = ai[ offset + i*shells + s ];
+				const Real *_br = br + offset + s*(b+1) + j0 , *_bi = bi + offset + s*(b+1) + j0;
+				for( int j=0 ; j<w ; j++ ) rr[j] += _ar * _br[j] , ii[j] += _ai * _bi[j] , ri[j] += _ar * _bi[j] , ir[j] += _ai * _br[j];
+			}
+			for( int j=0 ; j<w ; j++ )
+			{
+				int _j = j0+j;
+				// conjugate(a) * b and conjugate(a) * conjugate(b)
+				Complex< Real > c1( rr[j]+ii[j] , ri[j]-ir[j] ) , c2( rr[j]-ii[j] , -ri[j]-ir[j] );
+				// The weights of (b,i,_j) and (b,i,-_j), for SOFT-native keys
+				Real w1 = ( (i+_j)%2 ) ? -weights[b] : weights[b] , w2 = ( i%2 ) ? -weights[b] : weights[b];
+				values[ offsets[ i*(2*bw-1) + _j+bw-1 ] + b ] += softNative ? c1 * w1 : c1;
+				if( i && _j ) values[ offsets[ i*(2*bw-1) - _j+bw-1 ] + b ] += softNative ? c2 * w2 : c2;
+				if( antipodalKey )
+				{
+					int abw = antipodalKey->bw;
+					if( antipodalKey->softNative ) w1 *= sign , w2 *= sign;
+					else                           w1 = w2 = sign;
+					antipodalKey->values[ antipodalOffsets[ i*(2*abw-1) + _j+abw-1 ] + b ] += c1 * w1;
+					if( i && _j ) antipodalKey->values[ antipodalOffsets[ i*(2*abw-1) - _j+abw-1 ] + b ] += c2 * w2;
+				}
+			}
+		}
+	}
+	fftw_free( packed );
+}
+///////////////////
+// WignerDTables //
+///////////////////
+template< class Real > std::map< int , WignerDTables< Real >* > WignerDTables< Real >::_cache;
+
+template< class Real >
+WignerDTables< Real >::WignerDTables( int b )
+{
+	bw = b;
+	_refCount = 0;
+	size_t size = TransformBundle::WignerDTableSize( bw );
+	double* tableSpace = new double[ size ];
+	double* workSpace = new double[ 24*bw ];
+	genWigAllTrans( bw , tableSpace , workSpace );
+	delete[] workSpace;
+	if( sizeof(Real)==sizeof(double) ) _tableSpace = (Real*)tableSpace;
+	else
+	{
+		_tableSpace = new Real[ size ];
+		for( size_t i=0 ; i<size ; i++ ) _tableSpace[i] = Real( tableSpace[i] );
+		delete[] tableSpace;
+	}
+	table = _tableSpace;
+}
+template< class Real >
+WignerDTables< Real >::WignerDTables( int b , const double* tableSpace )
+{
+	bw = b;
+	_refCount = 0;
+	if( sizeof(Real)==sizeof(double) ) _tableSpace = NULL , table = (const Real*)tableSpace;
+	else
+	{
+		size_t size = TransformBundle::WignerDTableSize( bw );
+		_tableSpace = new Real[ size ];
+		for( size_t i=0 ; i<size ; i++ ) _tableSpace[i] = Real( tableSpace[i] );
+		table = _tableSpace;
+	}
+}
+template< class Real >
+WignerDTables< Real >::~WignerDTables( void )
+{
+	if( _tableSpace ) delete[] _tableSpace;
+	_tableSpace = NULL;
+	table = NULL;
+}
+template< class Real >
+const WignerDTables< Real >* WignerDTables< Real >::Acquire( int bw )
+{
+	if( bw<=0 ) return NULL;
+	WignerDTables* tables;
+	// The tables are only computed once, by the first thread that asks for them
+#pragma omp critical (WignerDTableCache)
+	{
+		typename std::map< int , WignerDTables* >::iterator iter = _cache.find( bw );
+		if( iter==_cache.end() )
+		{
+			const double* tableSpace = TransformBundle::Default().wignerDTable( bw );
+			if( tableSpace ) tables = _cache[bw] = new WignerDTables( bw , tableSpace );
+			else             tables = _cache[bw] = new WignerDTables( bw );
+		}
+		else tables = iter->second;
+		tables->_refCount++;
+	}
+	return tables;
+}
+template< class Real >
+void WignerDTables< Real >::Release( const WignerDTables* tables )
+{
+	if( !tables ) return;
+#pragma omp critical (WignerDTableCache)
+	{
+		WignerDTables* _tables = _cache[ tables->bw ];
+		if( _tables->_refCount>0 ) _tables->_refCount--;
+	}
 }
+template< class Real >
+void WignerDTables< Real >::Purge( void )
+{
+#pragma omp critical (WignerDTableCache)
+	{
+		typename std::map< int , WignerDTables* >::iterator iter = _cache.begin();
+		while( iter!=_cache.end() )
+			if( !iter->second->_refCount ) delete iter->second , _cache.erase( iter++ );
+			else iter++;
+	}
+}
+
+// The plan for the complex-to-real FFT of the (size x size/2+1) half-spectrum of a single beta, and the (real) inverse
+// SO(3) transform, in either precision.
+// The samples of a beta are written with the strides of the rotation grid, where the betas are interleaved and the
+// rows are (size*size) apart. Since the plan is executed at the offsets of all the betas, it is unaligned.
+inline fftw_plan WignerDSlabPlan( double* halfSpectrum , double* data , int size , unsigned flags )
+{
+	int n[] = { size , size } , onembed[] = { size , size*size };
+	return fftw_plan_many_dft_c2r( 2 , n , 1 , (fftw_complex*)halfSpectrum , NULL , 1 , 0 , data , onembed , 1 , 0 , flags | FFTW_UNALIGNED );
+}
+inline fftwf_plan WignerDSlabPlan( float* halfSpectrum , float* data , int size , unsigned flags )
+{
+	int n[] = { size , size } , onembed[] = { size , size*size };
+	return fftwf_plan_many_dft_c2r( 2 , n , 1 , (fftwf_complex*)halfSpectrum , NULL , 1 , 0 , data , onembed , 1 , 0 , flags | FFTW_UNALIGNED );
+}
+inline void InverseSO3( int bw , const double* coeffs , double* data , double* workspace_cx , double* workspace_cx2 , double* workspace_re , fftw_plan* p , const double* wigners , int threads )
+{
+	Inverse_SO3_Naive_fftw_mt_real( bw , (fftw_complex*)coeffs , data , 2*bw , (fftw_complex*)workspace_cx , (fftw_complex*)workspace_cx2 , workspace_re , p , (double*)wigners , threads );
+}
+inline void InverseSO3( int bw , const float* coeffs , float* data , float* workspace_cx , float* workspace_cx2 , double* workspace_re , fftwf_plan* p , const float* wigners , int threads )
+{
+	Inverse_SO3_Naive_fftw_mt_real( bw , (fftwf_complex*)coeffs , data , 2*bw , (fftwf_complex*)workspace_cx , (fftwf_complex*)workspace_cx2 , workspace_re , p , (float*)wigners , threads );
+}
+
 ////////////////////////////////////
 // WignerDTransform::ScratchSpace //
 ////////////////////////////////////
 template<class Real>
 WignerDTransform<Real>::ScratchSpace::ScratchSpace(void){
 	bw=0;
-	data=coeffs=workspace_cx=workspace_cx2=NULL;
+	threads=1;
+	measure=false;
+	coeffs=workspace_cx=workspace_cx2=NULL;
 	workspace_re=NULL;
+	wigners=NULL;
 	p=0;
 }
 template<class Real>
 WignerDTransform<Real>::ScratchSpace::~ScratchSpace(void){resize(0);}
 template<class Real>
+void WignerDTransform<Real>::ScratchSpace::resize( const int& b , bool m )
+{
+	if( m!=measure )
+	{
+		// Force the plan to be re-created
+		measure = m;
+		int _bw = bw;
+		resize( 0 ) , resize( _bw );
+	}
+	resize( b );
+}
+template<class Real>
 void WignerDTransform<Real>::ScratchSpace::resize(const int& b){
 	if(b!=bw){
 		int size=b*2;
-		if(data)					{fftw_free(data);}
 		if(coeffs)					{fftw_free(coeffs);}
 		if(workspace_cx)			{fftw_free(workspace_cx);}
 		if(workspace_cx2)			{fftw_free(workspace_cx2);}
 		if(workspace_re)			{fftw_free(workspace_re);}
-		if(p)						{fftw_destroy_plan(p);}
+		if(wigners)					{WignerDTables< Real >::Release(wigners);}
+		if(p)
+		{
+#pragma omp critical (FFTWPlanner)
+			DestroyFFTWPlan(p);
+		}
 
 		bw=0;
-		data=coeffs=workspace_cx=workspace_cx2=NULL;
+		coeffs=workspace_cx=workspace_cx2=NULL;
 		workspace_re=NULL;
+		wigners=NULL;
 		p=0;
 
 		if(b>0){
 			bw=b;
-			data=(fftw_complex*)fftw_malloc(sizeof(fftw_complex)*size*size*size);
-			coeffs=(fftw_complex*)fftw_malloc(sizeof(fftw_complex)*(4*bw*bw*bw-bw)/3);
-			workspace_cx=(fftw_complex*)fftw_malloc(sizeof(fftw_complex)*size*size*size);
-			workspace_cx2=(fftw_complex*)fftw_malloc(sizeof(fftw_complex)*size);
-			workspace_re=(double*)fftw_malloc(sizeof(double)*(12*size+size*bw));
-
-			int na[2], inembed[2], onembed[2] ;
-			int rank, howmany, istride, idist, ostride, odist ;
-			howmany = size*size ;
-			idist = size ;
-			odist = size ;
-			rank = 2 ;
-			inembed[0] = size ;
-			inembed[1] = size*size ;
-			onembed[0] = size ;
-			onembed[1] = size*size ;
-			istride = 1 ;
-			ostride = 1 ;
-			na[0] = 1 ;
-			na[1] = size ;
+			coeffs=(Real*)fftw_malloc(sizeof(Real)*2*FourierKeySO3< Real >::Entries(bw));
+			workspace_cx=(Real*)fftw_malloc(sizeof(Real)*2*size*size*(bw+1));
+			workspace_cx2=(Real*)fftw_malloc(sizeof(Real)*2*2*size*threads);
+			workspace_re=(double*)fftw_malloc(sizeof(double)*Inverse_SO3_Naive_fftw_mt_WorkspaceSize(bw)*threads);
 
-			p = fftw_plan_many_dft( rank, na, howmany,
-				workspace_cx, inembed,
-				istride, idist,
-				data, onembed,
-				ostride, odist,
-				FFTW_FORWARD, FFTW_ESTIMATE );
+			// Use the cached Wigner-d tables if they can be mapped from the bundle or fit in the budget
+			// (A single precision table is converted from the bundle's, so it is subject to the budget.)
+			bool mapped = sizeof(Real)==sizeof(double) && TransformBundle::Default().wignerDTable( bw );
+			if( mapped || sizeof(Real)*TransformBundle::WignerDTableSize( bw )<=WignerDTableBudget ) wigners = WignerDTables< Real >::Acquire( bw );
 		}
 	}
 }
+template< class Real >
+void WignerDTransform< Real >::ScratchSpace::setThreads( int t )
+{
+	if( t<1 ) t = 1;
+	if( t==threads ) return;
+	threads = t;
+	if( bw )
+	{
+		int size = bw*2;
+		fftw_free( workspace_cx2 );
+		fftw_free( workspace_re );
+		workspace_cx2 = (Real*)fftw_malloc( sizeof(Real)*2*2*size*threads );
+		workspace_re = (double*)fftw_malloc( sizeof(double)*Inverse_SO3_Naive_fftw_mt_WorkspaceSize(bw)*threads );
+	}
+}
 /////////////////////
 // WignerDTransform //
 /////////////////////
+template< class Real > size_t WignerDTransform< Real >::WignerDTableBudget = size_t(1)<<25;
+
 template<class Real>
 void WignerDTransform<Real>::resize(const int& resolution){ scratch.resize(resolution>>1); }
+template<class Real>
+void WignerDTransform<Real>::resize( const int& resolution , bool measure ){ scratch.resize( resolution>>1 , measure ); }
 template< class Real >
-int WignerDTransform<Real>::InverseFourier(FourierKeySO3<Real>& key,RotationGrid<Real>& g){
+int WignerDTransform< Real >::InverseFourier( FourierKeySO3< Real >& key , RotationGrid< Real >& g , int threads )
+{
 	if( key.resolution()!=g.resolution() ) g.resize(key.resolution());
-	int bw=key.bandWidth() , sz=g.resolution();
+	int bw=key.bandWidth();
+	if( !bw ) return 1;
 	scratch.resize( bw );
-	int m , h , idx=0;
-	double n,temp;
-	for( int i=0 ; i<bw ; i++ )
+	scratch.setThreads( threads );
+	if( !scratch.p )
+	{
+		// The plan writes into the grid, so it can only be created once there is one
+#pragma omp critical (FFTWPlanner)
+		scratch.p = WignerDSlabPlan( scratch.workspace_cx , g[0] , 2*bw , scratch.measure ? FFTW_MEASURE : FFTW_ESTIMATE );
+	}
+
+	// Keys that are not SOFT-native are weighted into the scratch space
+	const Complex< Real >* coeffs = key.softCoefficients();
+	if( !coeffs )
+	{
+		key.getSOFTCoefficients( (Complex< Real >*)scratch.coeffs );
+		coeffs = (const Complex< Real >*)scratch.coeffs;
+	}
+	InverseSO3( bw , (const Real*)coeffs , g[0] , scratch.workspace_cx , scratch.workspace_cx2 , scratch.workspace_re , &scratch.p , scratch.wigners ? scratch.wigners->table : NULL , scratch.threads );
+	return 1;
+}
+
+///////////////////
+// WignerDSeries //
+///////////////////
+template< class Real > WignerDSeries< Real >::WignerDSeries( void ) : _bw(0) , _phi(DBL_MAX) { ; }
+template< class Real > WignerDSeries< Real >::WignerDSeries( const FourierKeySO3< Real >& key ) : _bw(0) , _phi(DBL_MAX) { set( key ); }
+template< class Real > int WignerDSeries< Real >::bandWidth( void ) const { return _bw; }
+template< class Real >
+void WignerDSeries< Real >::set( const FourierKeySO3< Real >& key )
+{
+	_bw = key.bandWidth();
+	_phi = DBL_MAX;
+	_offsets.resize( _bw+1 );
+	_offsets[0] = 0;
+	for( int b=0 ; b<_bw ; b++ ) _offsets[b+1] = _offsets[b] + 2*(b+1)*(2*b+1);
+	_coefficients.resize( _offsets[_bw] );
+	for( int b=0 ; b<_bw ; b++ ) for( int i=0 ; i<=b ; i++ ) for( int j=-b ; j<=b ; j++ )
+	{
+		double* c = &_coefficients[ _offsets[b] + 2*( i*(2*b+1) + j+b ) ];
+		// As in the inverse transform, the coefficients (b,0,j) with j<0 are not used, since they are the conjugates
+		// of the ones with j>0, and the other coefficients off the diagonal stand in for their conjugates as well.
+		if( !i && j<0 ){ c[0] = c[1] = 0 ; continue; }
+		double scale = ( i || j ) ? 2. : 1.;
+		// The d's generated by wignerdmat have the opposite sign in the columns with negative odd j
+		if( j<0 && (j%2) ) scale = -scale;
+		if( key.isSOFTNative() ) scale /= FourierKeySO3< Real >::SOFTWeight( b , i , j );
+		Complex< Real > _c = key( b , i , j );
+		c[0] = _c.r * scale , c[1] = _c.i * scale;
+	}
+	int size = std::max< int >( 2*_bw-1 , 1 );
+	for( int k=0 ; k<3 ; k++ ) _slice[k].resize( 2*_bw*size );
+	for( int k=0 ; k<4 ; k++ ) _d[k].resize( size*size );
+	_sqrts.resize( 2*_bw+2 );
+	for( int i=0 ; i<int(_sqrts.size()) ; i++ ) _sqrts[i] = sqrt( double(i) );
+	_workspace.resize( std::max< int >( 4*_bw*_bw , 1 ) );
+}
+template< class Real >
+void WignerDSeries< Real >::_setSlice( double phi )
+{
+	_phi = phi;
+	int size = 2*_bw-1;
+	double trigs[] = { cos( phi/2 ) , sin( phi/2 ) };
+	for( int k=0 ; k<3 ; k++ ) memset( &_slice[k][0] , 0 , sizeof(double)*_slice[k].size() );
+	for( int b=0 ; b<_bw ; b++ )
 	{
-		for( int j=0 ; j<bw ; j++ )
+		int m = 2*b+1;
+		// The recurrence generates the d's of band-width b from those of band-width b-1, which are in _d[3]
+		wignerdmat( b , &_d[3][0] , &_d[0][0] , trigs , &_sqrts[0] , &_workspace[0] );
+
+		// The derivatives with respect to phi mix the d's of the neighboring columns:
+		//		d'(i,j) = ( sqrt( (b+j)*(b-j+1) ) * d(i,j-1) - sqrt( (b-j)*(b+j+1) ) * d(i,j+1) ) / 2
+		// (Only the rows with i>=0 are needed.)
+		for( int k=1 ; k<3 ; k++ ) for( int i=0 ; i<=b ; i++ )
 		{
-			temp=1;
-			if(i>j)
-			{
-				if((i-j)%2){temp*=-1;}
-				m=i;
-			}
-			else
+			const double* in = &_d[k-1][ (i+b)*m ];
+			double* out = &_d[k][ (i+b)*m ];
+			for( int j=-b ; j<=b ; j++ )
 			{
-				if((j-i)%2){temp*=-1;}
-				m=j;
-			}
-			h = bw-m;
-			for( int k=0 ; k<h ; k++ )
-			{
-				n=sqrt(8.0*PI*PI/(2*(m+k)+1));
-				scratch.coeffs[idx][0]=key(m+k,i,j).r*n*temp;
-				scratch.coeffs[idx][1]=key(m+k,i,j).i*n*temp;
-				idx++;
+				double d = 0;
+				if( j>-b ) d += _sqrts[b+j] * _sqrts[b-j+1] * in[j+b-1];
+				if( j< b ) d -= _sqrts[b-j] * _sqrts[b+j+1] * in[j+b+1];
+				out[j+b] = d/2;
 			}
 		}
-		for( int j=bw-1 ; j>0 ; j-- )
+
+		const double* coefficients = &_coefficients[ _offsets[b] ];
+		for( int i=0 ; i<=b ; i++ ) for( int k=0 ; k<3 ; k++ )
 		{
-			temp = ((j%2)==0) ? 1 : -1;
-			if(i>j)
-			{
-				if((i-j)%2){temp*=-1;}
-				m=i;
-			}
-			else
-			{
-				if((j-i)%2){temp*=-1;}
-				m=j;
-			}
-			h = bw-m;
-			for( int k=0 ; k<h ; k++ )
-			{
-				n=sqrt(8.0*PI*PI/(2*(m+k)+1));
-				scratch.coeffs[idx][0]=key(m+k,i,-j).r*n*temp;
-				scratch.coeffs[idx][1]=key(m+k,i,-j).i*n*temp;
-				idx++;
-			}
+			const double* d = &_d[k][ (i+b)*m ];
+			const double* c = coefficients + 2*i*m;
+			double* slice = &_slice[k][ 2*( i*size + _bw-1-b ) ];
+			for( int j=0 ; j<m ; j++ ) slice[2*j] += d[j] * c[2*j] , slice[2*j+1] += d[j] * c[2*j+1];
 		}
+		std::swap( _d[0] , _d[3] );
 	}
-	for( int i=bw-1 ; i>0 ; i-- )
+}
+template< class Real >
+double WignerDSeries< Real >::_evaluate( double theta , double psi , double gradient[3] , double hessian[3][3] ) const
+{
+	int size = 2*_bw-1;
+	std::vector< double > cosTheta( _bw ) , sinTheta( _bw ) , cosPsi( size ) , sinPsi( size );
+	for( int i=0 ; i<_bw ; i++ ) cosTheta[i] = cos( i*theta ) , sinTheta[i] = sin( i*theta );
+	for( int j=0 ; j<size ; j++ ) cosPsi[j] = cos( (j-_bw+1)*psi ) , sinPsi[j] = sin( (j-_bw+1)*psi );
+
+	// The coefficient c at frequencies (i,j) contributes:
+	//		t = c.r * cos( i*theta + j*psi ) + c.i * sin( i*theta + j*psi )
+	// whose derivative with respect to the angle i*theta + j*psi is:
+	//		s = c.i * cos( i*theta + j*psi ) - c.r * sin( i*theta + j*psi )
+	double value = 0;
+	for( int i=0 ; i<3 ; i++ ){ gradient[i] = 0 ; for( int j=0 ; j<3 ; j++ ) hessian[i][j] = 0; }
+	for( int i=0 ; i<_bw ; i++ ) for( int _j=0 ; _j<size ; _j++ )
 	{
-		for( int j=0 ; j<bw ; j++ )
+		int j = _j-_bw+1;
+		double c = cosTheta[i]*cosPsi[_j] - sinTheta[i]*sinPsi[_j];
+		double s = sinTheta[i]*cosPsi[_j] + cosTheta[i]*sinPsi[_j];
+		const double* c0 = &_slice[0][ 2*( i*size + _j ) ];
+		const double* c1 = &_slice[1][ 2*( i*size + _j ) ];
+		const double* c2 = &_slice[2][ 2*( i*size + _j ) ];
+		double t0 = c0[0]*c + c0[1]*s , s0 = c0[1]*c - c0[0]*s;
+		double t1 = c1[0]*c + c1[1]*s , s1 = c1[1]*c - c1[0]*s;
+		double t2 = c2[0]*c + c2[1]*s;
+		value += t0;
+		gradient[0] += i*s0 , gradient[1] += t1 , gradient[2] += j*s0;
+		hessian[0][0] -= i*i*t0 , hessian[0][1] += i*s1 , hessian[0][2] -= i*j*t0;
+		hessian[1][1] += t2 , hessian[1][2] += j*s1 , hessian[2][2] -= j*j*t0;
+	}
+	hessian[1][0] = hessian[0][1] , hessian[2][0] = hessian[0][2] , hessian[2][1] = hessian[1][2];
+	return value;
+}
+template< class Real >
+Real WignerDSeries< Real >::operator() ( Real theta , Real phi , Real psi )
+{
+	if( !_bw ) return Real(0);
+	double gradient[3] , hessian[3][3];
+	if( double(phi)!=_phi ) _setSlice( phi );
+	return Real( _evaluate( theta , psi , gradient , hessian ) );
+}
+template< class Real >
+Real WignerDSeries< Real >::refine( Real& theta , Real& phi , Real& psi , bool maximum , Real radius , Real precision , int iterations )
+{
+	if( !_bw ) return Real(0);
+	// The search is for a maximum of sign*f
+	double sign = maximum ? 1. : -1.;
+	double x[] = { theta , phi , psi } , gradient[3] , hessian[3][3] , r = radius;
+	if( x[1]!=_phi ) _setSlice( x[1] );
+	double value = _evaluate( x[0] , x[2] , gradient , hessian );
+	for( int it=0 ; it<iterations && r>=precision ; it++ )
+	{
+		// Take the Newton step if the Hessian of sign*f is negative definite (i.e. if the Cholesky factorization of its
+		// negation succeeds) and otherwise step along the gradient, in either case clamping the step to the trust region.
+		double l[3][3] , step[3] , length = 0;
+		bool newton = true;
+		for( int i=0 ; i<3 && newton ; i++ ) for( int j=0 ; j<=i && newton ; j++ )
 		{
-			temp = ((i%2)==0) ? 1 : -1;
-			if(i>j)
-			{
-				if((i-j)%2){temp*=-1;}
-				m=i;
-			}
-			else
-			{
-				if((j-i)%2){temp*=-1;}
-				m=j;
-			}
-			h = bw-m;
-			for( int k=0 ; k<h ; k++ )
-			{
-				n=sqrt(8.0*PI*PI/(2*(m+k)+1));
-				scratch.coeffs[idx][0]= key(m+k,i,-j).r*n*temp;
-				scratch.coeffs[idx][1]=-key(m+k,i,-j).i*n*temp;
-				idx++;
-			}
+			double s = -sign*hessian[i][j];
+			for( int k=0 ; k<j ; k++ ) s -= l[i][k] * l[j][k];
+			if( i==j ) newton = s>0 , l[i][i] = newton ? sqrt( s ) : 0;
+			else       l[i][j] = s / l[j][j];
 		}
-		for( int j=bw-1 ; j>0 ; j-- )
+		for( int i=0 ; i<3 ; i++ ) step[i] = sign*gradient[i];
+		if( newton )
 		{
-			temp = ((i+j)%2)==0 ? 1 : -1;
-			if(i>j)
-			{
-				if((i-j)%2){temp*=-1;}
-				m=i;
-			}
-			else
-			{
-				if((j-i)%2){temp*=-1;}
-				m=j;
-			}
-			h = bw-m;
-			for( int k=0 ; k<h ; k++ )
-			{
-				n=sqrt(8.0*PI*PI/(2*(m+k)+1));
-				scratch.coeffs[idx][0]= key(m+k,i,j).r*n*temp;
-				scratch.coeffs[idx][1]=-key(m+k,i,j).i*n*temp;
-				idx++;
-			}
+			for( int i=0 ; i<3 ; i++ ){ for( int k=0 ; k<i ; k++ ) step[i] -= l[i][k] * step[k] ; step[i] /= l[i][i]; }
+			for( int i=2 ; i>=0 ; i-- ){ for( int k=i+1 ; k<3 ; k++ ) step[i] -= l[k][i] * step[k] ; step[i] /= l[i][i]; }
 		}
+		for( int i=0 ; i<3 ; i++ ) length += step[i] * step[i];
+		length = sqrt( length );
+		if( !(length>0) ) break;
+		if( !newton || length>r )
+		{
+			for( int i=0 ; i<3 ; i++ ) step[i] *= r / length;
+			length = r , newton = false;
+		}
+
+		double y[] = { x[0]+step[0] , x[1]+step[1] , x[2]+step[2] } , _gradient[3] , _hessian[3][3];
+		_setSlice( y[1] );
+		double _value = _evaluate( y[0] , y[2] , _gradient , _hessian );
+		if( sign*_value>sign*value )
+		{
+			value = _value;
+			for( int i=0 ; i<3 ; i++ ){ x[i] = y[i] , gradient[i] = _gradient[i] ; for( int j=0 ; j<3 ; j++ ) hessian[i][j] = _hessian[i][j]; }
+			if( newton && length<precision ) break;
+		}
+		else r /= 4;
 	}
-	Inverse_SO3_Naive_fftw( bw , scratch.coeffs , scratch.data , scratch.workspace_cx , scratch.workspace_cx2 , scratch.workspace_re , &scratch.p , 1 );
-	idx=0;
-	Real* _g = g[0];
-	for( int i=0 ; i<2*bw ; i++ ) for( int j=0 ; j<2*bw ; j++ ) for( int k=0 ; k<2*bw ; k++ ) _g[idx++]=Real(scratch.data[2*bw*i+4*bw*bw*j+k][0]);
-	return 1;
+	theta = Real( x[0] ) , phi = Real( x[1] ) , psi = Real( x[2] );
+	return Real( value );
 }
@@ -0,0 +1,91 @@
+/*
+Copyright (c) 2013, Michael Kazhdan
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list of
+conditions and the following disclaimer. Redistributions in binary form must reproduce
+the above copyright notice, this list of conditions and the following disclaimer
+in the documentation and/or other materials provided with the distribution. 
+
+Neither the name of the Johns Hopkins University nor the names of its contributors
+may be used to endorse or promote products derived from this software without specific
+prior written permission. 
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO THE IMPLIED WARRANTIES 
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+DAMAGE.
+*/
+#ifndef GAUSS_LEGENDRE_GRID_INCLUDED
+#define GAUSS_LEGENDRE_GRID_INCLUDED
+
+#include <vector>
+
+#ifndef PI
+#define PI 3.1415926535897932384
+#endif 
+
+// This templated class represents a spherical function sampled on a Gauss-Legendre grid, where index (i,j) corresponds
+// to the point on the sphere with spherical coordinates:
+//			theta = 2PI*i/r
+//			phi   = arccos( x_j )
+//			(theta,phi) -> [cos(theta)*sin(phi),cos(phi),sin(theta)*sin(phi)]
+// where r is the resolution of the sampling and x_0 > x_1 > ... are the r/2 Gauss-Legendre nodes.
+// Compared to the equiangular SphericalGrid of the same resolution, there are only half as many latitudes,
+// and the quadrature is still exact for the band-limited functions (see HarmonicTransform).
+template< class Real=float >
+class GaussLegendreGrid
+{
+protected:
+	Real* values;
+	int res;
+	// The quadrature, computed when the grid is resized
+	std::vector< double > nodes , weights;
+public:
+	GaussLegendreGrid( void );
+	GaussLegendreGrid( int resolution );
+	~GaussLegendreGrid( void );
+
+	// Returns the number of samples along a latitude
+	int resolution( void ) const;
+	// Returns the number of latitudes
+	int latitudes( void ) const;
+	// Allocates memory for the array (the resolution should be even)
+	int resize( const int& resolution );
+
+	// Clears the values of the array to 0
+	void clear( void );
+
+	// Returns a reference to the indexed array element
+	Real& operator() ( const int& i , const int& j );
+	Real  operator() ( const int& i , const int& j ) const;
+	// Returns the samples along the j-th latitude
+	Real* operator[] ( const int& j );
+	const Real* operator[] ( const int& j ) const;
+
+	// Returns the square of the L2-norm of the function
+	Real squareNorm( void ) const;
+
+	// Sets the (x,y,z) coordinates of the spherical point indexed by (i,j)
+	void setCoordinates( const int& i , const int& j , Real coords[3] ) const;
+	// Returns the cosine of the j-th latitude and its quadrature weight
+	double node( const int& j ) const;
+	double weight( const int& j ) const;
+
+	// Returns the dot-product of two Gauss-Legendre grids
+	static Real Dot( const GaussLegendreGrid& g1 , const GaussLegendreGrid& g2 );
+
+	// Computes the Gauss-Legendre nodes (in decreasing order) and weights, with the weights summing to 2
+	static void Quadrature( int count , std::vector< double >& nodes , std::vector< double >& weights );
+};
+#include "GaussLegendreGrid.inl"
+#endif // GAUSS_LEGENDRE_GRID_INCLUDED
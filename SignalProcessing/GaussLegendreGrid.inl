@@ -0,0 +1,148 @@
+/*
+Copyright (c) 2013, Michael Kazhdan
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list of
+conditions and the following disclaimer. Redistributions in binary form must reproduce
+the above copyright notice, this list of conditions and the following disclaimer
+in the documentation and/or other materials provided with the distribution. 
+
+Neither the name of the Johns Hopkins University nor the names of its contributors
+may be used to endorse or promote products derived from this software without specific
+prior written permission. 
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO THE IMPLIED WARRANTIES 
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+DAMAGE.
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <Include/fftw3.h>
+
+template< class Real > GaussLegendreGrid< Real >::GaussLegendreGrid( void ) : values(NULL) , res(0) { ; }
+template< class Real > GaussLegendreGrid< Real >::GaussLegendreGrid( int r ) : values(NULL) , res(0) { if( r ) resize( r ); }
+template< class Real > GaussLegendreGrid< Real >::~GaussLegendreGrid( void ){ if( values ) resize( 0 ); }
+template< class Real > int GaussLegendreGrid< Real >::resolution( void ) const { return res; }
+template< class Real > int GaussLegendreGrid< Real >::latitudes( void ) const { return res/2; }
+// Use FFTW's allocator for floating-point grids so that the samples have the alignment the harmonic transform plans for
+int GaussLegendreGrid< float >::resize( const int& r )
+{
+	if( r<0 || ( r&1 ) ) return 0;
+	if( values ) fftwf_free( values );
+	values = NULL;
+	res = 0;
+	if( r )
+	{
+		values = (float*)fftwf_malloc( sizeof(float)*r*(r/2) );
+		if( !values ) return 0;
+		res = r;
+	}
+	Quadrature( res/2 , nodes , weights );
+	clear();
+	return 1;
+}
+int GaussLegendreGrid< double >::resize( const int& r )
+{
+	if( r<0 || ( r&1 ) ) return 0;
+	if( values ) fftw_free( values );
+	values = NULL;
+	res = 0;
+	if( r )
+	{
+		values = (double*)fftw_malloc( sizeof(double)*r*(r/2) );
+		if( !values ) return 0;
+		res = r;
+	}
+	Quadrature( res/2 , nodes , weights );
+	clear();
+	return 1;
+}
+template< class Real >
+int GaussLegendreGrid< Real >::resize( const int& r )
+{
+	if( r<0 || ( r&1 ) ) return 0;
+	if( values ) delete[] values;
+	values = NULL;
+	res = 0;
+	if( r )
+	{
+		values = new Real[ r*(r/2) ];
+		if( !values ) return 0;
+		res = r;
+	}
+	Quadrature( res/2 , nodes , weights );
+	clear();
+	return 1;
+}
+template< class Real > void GaussLegendreGrid< Real >::clear( void ){ if( res ) memset( values , 0 , sizeof(Real)*res*(res/2) ); }
+template< class Real > Real& GaussLegendreGrid< Real >::operator() ( const int& i , const int& j ){ return values[ j*res + ( (i%res)+res )%res ]; }
+template< class Real > Real  GaussLegendreGrid< Real >::operator() ( const int& i , const int& j ) const { return values[ j*res + ( (i%res)+res )%res ]; }
+template< class Real > Real* GaussLegendreGrid< Real >::operator[] ( const int& j ){ return values + j*res; }
+template< class Real > const Real* GaussLegendreGrid< Real >::operator[] ( const int& j ) const { return values + j*res; }
+
+template< class Real >
+void GaussLegendreGrid< Real >::setCoordinates( const int& i , const int& j , Real coords[3] ) const
+{
+	double theta = 2.0*PI*i/res , z = nodes[j] , r = sqrt( 1.0 - z*z );
+	coords[0] = Real( r*cos(theta) );
+	coords[1] = Real( z );
+	coords[2] = Real( r*sin(theta) );
+}
+template< class Real > double GaussLegendreGrid< Real >::node( const int& j ) const { return nodes[j]; }
+template< class Real > double GaussLegendreGrid< Real >::weight( const int& j ) const { return weights[j]; }
+template< class Real > Real GaussLegendreGrid< Real >::squareNorm( void ) const { return Dot( *this , *this ); }
+template< class Real >
+Real GaussLegendreGrid< Real >::Dot( const GaussLegendreGrid& g1 , const GaussLegendreGrid& g2 )
+{
+	if( g1.res!=g2.res )
+	{
+		fprintf( stderr , "[ERROR] GaussLegendreGrid::Dot: Could not compare arrays of different sizes: %d != %d\n" , g1.res , g2.res );
+		exit( 0 );
+	}
+	double d = 0;
+	for( int j=0 ; j<g1.res/2 ; j++ )
+	{
+		double _d = 0;
+		for( int i=0 ; i<g1.res ; i++ ) _d += g1.values[j*g1.res+i] * g2.values[j*g1.res+i];
+		d += _d * g1.weights[j];
+	}
+	return Real( d*2*PI/g1.res );
+}
+template< class Real >
+void GaussLegendreGrid< Real >::Quadrature( int count , std::vector< double >& nodes , std::vector< double >& weights )
+{
+	nodes.resize( count ) , weights.resize( count );
+	// The nodes are symmetric about zero, so only the positive half is solved for (with Newton's method)
+	for( int j=0 ; j<(count+1)/2 ; j++ )
+	{
+		double x = cos( PI*(j+0.75)/(count+0.5) ) , dp = 1;
+		for( int iter=0 ; iter<100 ; iter++ )
+		{
+			// Evaluate P_count(x) and its derivative with the three-term recurrence
+			double p0 = 1 , p1 = x;
+			for( int l=2 ; l<=count ; l++ )
+			{
+				double p2 = ( (2*l-1)*x*p1 - (l-1)*p0 ) / l;
+				p0 = p1 , p1 = p2;
+			}
+			dp = count*( x*p1 - p0 ) / ( x*x - 1 );
+			double dx = p1/dp;
+			x -= dx;
+			if( fabs(dx)<1e-16 ) break;
+		}
+		nodes[j] = x , nodes[count-1-j] = -x;
+		weights[j] = weights[count-1-j] = 2. / ( ( 1-x*x )*dp*dp );
+	}
+}
@@ -29,6 +29,7 @@ DAMAGE.
 #define ROTATION_GRID_INCLUDED
 
 
+#include <vector>
 #include "CubeGrid.h"
 #ifndef PI
 #define PI 3.1415926535897932384
@@ -44,7 +45,17 @@ DAMAGE.
 
 template< class Real=float >
 class RotationGrid : public CubeGrid< Real >{
+	// Returns the offset of the indexed array element, wrapping and flipping the index as in operator()
+	int _index( int i , int j , int k ) const;
 public:
+	// A local extremum of the grid, given by the index of the sample (as in operator()), its value and its rotation
+	struct Peak
+	{
+		int i , j , k;
+		Real value;
+		Real matrix[3][3];
+	};
+
 	RotationGrid( void );
 	RotationGrid( int res );
 	~RotationGrid( void );
@@ -53,7 +64,13 @@ public:
 	Real& operator() (const int& x,const int& y,const int& z);
 	Real operator() (const int& x,const int& y,const int& z) const;
 	// Returns the linear interpolation of the value at the spedified index
+	// (When the cell is in the interior of the grid, its corners are read directly, without the wrapping of operator().)
 	Real sample( Real x , Real y , Real z ) const;
+	// Writes the linear interpolations of the values at the "count" specified indices into "samples"
+	// The samples are processed in chunks: the offsets of the corners are computed first (directly for the cells in the
+	// interior of the grid, and as in operator() for the ones on its boundary), then the corners are gathered, and then
+	// they are blended in a branch-free loop that the compiler can vectorize.
+	void sample( int count , const Real* x , const Real* y , const Real* z , Real* samples ) const;
 
 	// Sets the matrix coordinates of the Euler angle (theta,phi,psi)
 	static void SetCoordinates(const Real& theta,const Real& phi,const Real& psi,Real matrix[3][3]);
@@ -69,6 +86,14 @@ public:
 	// Sets the coordinates (i,j,k) associated to the specified rotation matrix
 	void setCoordinates(const Real matrix[3][3],Real& i,Real& j,Real& k) const;
 
+	// Returns the (at most) "count" strongest local maxima (or local minima, if "maximum" is not set) of the grid, strongest first.
+	// A sample is a local extremum if it is no smaller (larger) than any of its 26 neighbors, which are indexed as in operator(),
+	// so that they wrap around in theta and psi and flip across the poles. Peaks whose rotations are within "separation" radians
+	// of a stronger peak are suppressed, so that plateaus and broad extrema are only reported once.
+	// The neighborhoods are compared a row at a time, with branch-free loops that the compiler can vectorize, and the rows are
+	// distributed over "threads" threads. The rotations are only computed for the peaks that are considered for the output.
+	void getPeaks( int count , Real separation , bool maximum , std::vector< Peak >& peaks , int threads=1 ) const;
+
 	// Returns the square of the L2-norm of the array elements
 	Real squareNorm(void) const;
 
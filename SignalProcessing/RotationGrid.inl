@@ -30,6 +30,7 @@ DAMAGE.
 #include <string.h>
 #include <math.h>
 #include <float.h>
+#include <algorithm>
 
 template< class Real >
 RotationGrid< Real >::RotationGrid(void){;}
@@ -109,27 +110,95 @@ void RotationGrid<Real>::setCoordinates(const Real matrix[3][3],Real& i,Real& j,
 	j=Real(2.0*res*phi-PI)/Real(2*PI);
 	k=(psi*res)/Real(2.0*PI);
 }
-template<class Real>
-Real& RotationGrid<Real>::operator() (const int& i,const int& j,const int& k){
-	int x=i+res/2;
-	int y=j;
-	int z=k+res/2;
+template< class Real >
+void RotationGrid< Real >::getPeaks( int count , Real separation , bool maximum , std::vector< Peak >& peaks , int threads ) const
+{
+	peaks.clear();
+	if( count<=0 || !res ) return;
 
-	if(y<0){y=2*res-((-y)%(2*res));}
-	y%=2*res;
-	if(y>=res){
-		y=2*res-y-1;
-		x+=res/2;
-		z+=res/2;
+	// The minima are found as the maxima of the negated samples
+	Real sign = maximum ? Real(1) : Real(-1);
+	// The candidates are stored as (-sign*value,offset) pairs, so that sorting them puts the strongest first
+	std::vector< std::pair< Real , int > > candidates;
+#pragma omp parallel num_threads( threads )
+	{
+		int size = res+2;
+		// The maxima over theta of the rows at three consecutive phis (padded with their wrapped-around neighbors in psi),
+		// followed by their maximum over phi and the maximum of that over the neighborhood in psi. Since the maximum over
+		// the neighborhood is separable, each row of samples only requires a single new maximum over theta.
+		std::vector< Real > buffer( 5*size );
+		std::vector< std::pair< Real , int > > _candidates;
+#pragma omp for
+		for( int x=0 ; x<res ; x++ ) for( int yy=-1 ; yy<=res ; yy++ )
+		{
+			Real* rows = &buffer[0];
+			{
+				int y = yy , xx = x , shift = 0;
+				// Across the poles, the rows are reflected and offset by half a turn in theta and psi (as in operator())
+				if( y<0 || y>=res ) y = y<0 ? 0 : res-1 , xx += res/2 , shift = res/2;
+				Real* _row = rows + ( (yy+1)%3 )*size;
+				for( int dx=-1 ; dx<=1 ; dx++ )
+				{
+					const Real* row = values + ( (xx+dx+res)%res )*res*res + y*res;
+					if( dx==-1 )
+					{
+						for( int z=0 ; z<res-shift ; z++ ) _row[z+1] = sign * row[z+shift];
+						for( int z=res-shift ; z<res ; z++ ) _row[z+1] = sign * row[z+shift-res];
+					}
+					else
+					{
+						for( int z=0 ; z<res-shift ; z++ ) _row[z+1] = _row[z+1]<sign*row[z+shift]     ? sign*row[z+shift]     : _row[z+1];
+						for( int z=res-shift ; z<res ; z++ ) _row[z+1] = _row[z+1]<sign*row[z+shift-res] ? sign*row[z+shift-res] : _row[z+1];
+					}
+				}
+				_row[0] = _row[res] , _row[res+1] = _row[1];
+			}
+			// Once the rows at the phis on either side are set, the samples of the middle row can be compared
+			if( yy<1 ) continue;
+			int y = yy-1;
+			Real* rowMax = rows + 3*size;
+			Real* neighborMax = rows + 4*size;
+			for( int z=0 ; z<size ; z++ )
+			{
+				Real m = rows[z]<rows[z+size] ? rows[z+size] : rows[z];
+				rowMax[z] = m<rows[z+2*size] ? rows[z+2*size] : m;
+			}
+			for( int z=0 ; z<res ; z++ )
+			{
+				Real m = rowMax[z]<rowMax[z+1] ? rowMax[z+1] : rowMax[z];
+				neighborMax[z] = m<rowMax[z+2] ? rowMax[z+2] : m;
+			}
+			// Since the neighborhood includes the sample, it is a local maximum if it is the maximum of the neighborhood
+			const Real* center = values + x*res*res + y*res;
+			for( int z=0 ; z<res ; z++ ) if( sign*center[z]>=neighborMax[z] ) _candidates.push_back( std::pair< Real , int >( -sign*center[z] , x*res*res + y*res + z ) );
+		}
+#pragma omp critical (RotationGridPeaks)
+		candidates.insert( candidates.end() , _candidates.begin() , _candidates.end() );
+	}
+	std::sort( candidates.begin() , candidates.end() );
+
+	// Two rotations are within "separation" radians of each other if the trace of R1^t * R2 is greater than 1 + 2 cos( separation )
+	Real threshold = Real( 1 + 2*cos( separation ) );
+	for( size_t c=0 ; c<candidates.size() && int( peaks.size() )<count ; c++ )
+	{
+		int offset = candidates[c].second;
+		int x = offset/(res*res) , y = (offset/res)%res , z = offset%res;
+		Peak peak;
+		peak.i = ( x + res - res/2 ) % res , peak.j = y , peak.k = ( z + res - res/2 ) % res;
+		peak.value = values[offset];
+		setCoordinates( peak.i , peak.j , peak.k , peak.matrix );
+		bool suppressed = false;
+		for( int p=0 ; p<int( peaks.size() ) && separation>0 && !suppressed ; p++ )
+		{
+			Real trace = 0;
+			for( int ii=0 ; ii<3 ; ii++ ) for( int jj=0 ; jj<3 ; jj++ ) trace += peak.matrix[ii][jj] * peaks[p].matrix[ii][jj];
+			suppressed = trace>threshold;
+		}
+		if( !suppressed ) peaks.push_back( peak );
 	}
-	if(x<0){x=res-((-x)%res);}
-	x=x%res;
-	if(z<0){z=res-((-z)%res);}
-	z=z%res;
-	return values[x*res*res+y*res+z];
 }
 template<class Real>
-Real RotationGrid<Real>::operator() (const int& i,const int& j,const int& k) const {
+int RotationGrid<Real>::_index( int i , int j , int k ) const {
 	int x=i+res/2;
 	int y=j;
 	int z=k+res/2;
@@ -145,8 +214,12 @@ Real RotationGrid<Real>::operator() (const int& i,const int& j,const int& k) con
 	x=x%res;
 	if(z<0){z=res-((-z)%res);}
 	z=z%res;
-	return values[x*res*res+y*res+z];
+	return x*res*res+y*res+z;
 }
+template<class Real>
+Real& RotationGrid<Real>::operator() (const int& i,const int& j,const int& k){ return values[ _index(i,j,k) ]; }
+template<class Real>
+Real RotationGrid<Real>::operator() (const int& i,const int& j,const int& k) const { return values[ _index(i,j,k) ]; }
 #if 0
 template<class Real>
 Real RotationGrid<Real>::operator() (const double& x,const double& y,const double& z){
@@ -189,6 +262,22 @@ Real RotationGrid<Real>::sample( Real x , Real y , Real z ) const {
 	dx=x-x1;
 	dy=y-y1;
 	dz=z-z1;
+
+	// In the interior, the corners are at fixed offsets from the first one
+	int _x=x1+res/2 , _z=z1+res/2;
+	if( _x>=0 && _x<res-1 && y1>=0 && y1<res-1 && _z>=0 && _z<res-1 )
+	{
+		const Real* v = values + _x*res*res + y1*res + _z;
+		return
+			v[0            ]*(Real(1.0)-dx)*(Real(1.0)-dy)*(Real(1.0)-dz)+
+			v[res*res      ]*(          dx)*(Real(1.0)-dy)*(Real(1.0)-dz)+
+			v[        res  ]*(Real(1.0)-dx)*(          dy)*(Real(1.0)-dz)+
+			v[res*res+res  ]*(          dx)*(          dy)*(Real(1.0)-dz)+
+			v[            1]*(Real(1.0)-dx)*(Real(1.0)-dy)*(          dz)+
+			v[res*res    +1]*(          dx)*(Real(1.0)-dy)*(          dz)+
+			v[        res+1]*(Real(1.0)-dx)*(          dy)*(          dz)+
+			v[res*res+res+1]*(          dx)*(          dy)*(          dz);
+	}
 	return 
 		(*this)(x1  ,y1  ,z1  )*(Real(1.0)-dx)*(Real(1.0)-dy)*(Real(1.0)-dz)+
 		(*this)(x1+1,y1  ,z1  )*(          dx)*(Real(1.0)-dy)*(Real(1.0)-dz)+
@@ -199,6 +288,45 @@ Real RotationGrid<Real>::sample( Real x , Real y , Real z ) const {
 		(*this)(x1  ,y1+1,z1+1)*(Real(1.0)-dx)*(          dy)*(          dz)+
 		(*this)(x1+1,y1+1,z1+1)*(          dx)*(          dy)*(          dz);
 }
+template< class Real >
+void RotationGrid< Real >::sample( int count , const Real* x , const Real* y , const Real* z , Real* samples ) const
+{
+	const int ChunkSize = 64;
+	// The offsets and values of the corners (ordered as in the single-sample method), and the fractional parts of the indices
+	int offsets[8][ChunkSize];
+	Real corners[8][ChunkSize] , dx[ChunkSize] , dy[ChunkSize] , dz[ChunkSize];
+	for( int start=0 ; start<count ; start+=ChunkSize )
+	{
+		int size = std::min< int >( ChunkSize , count-start );
+		for( int c=0 ; c<size ; c++ )
+		{
+			Real _x = x[start+c] , _y = y[start+c] , _z = z[start+c];
+			int x1 = _x<0 ? -int(-_x)-1 : int(_x);
+			int y1 = _y<0 ? -int(-_y)-1 : int(_y);
+			int z1 = _z<0 ? -int(-_z)-1 : int(_z);
+			dx[c] = _x-x1 , dy[c] = _y-y1 , dz[c] = _z-z1;
+
+			int xx = x1+res/2 , zz = z1+res/2;
+			if( xx>=0 && xx<res-1 && y1>=0 && y1<res-1 && zz>=0 && zz<res-1 )
+			{
+				int offset = xx*res*res + y1*res + zz;
+				for( int k=0 ; k<8 ; k++ ) offsets[k][c] = offset + ( (k&1) ? res*res : 0 ) + ( (k&2) ? res : 0 ) + ( (k&4) ? 1 : 0 );
+			}
+			else for( int k=0 ; k<8 ; k++ ) offsets[k][c] = _index( x1 + (k&1) , y1 + ((k>>1)&1) , z1 + ((k>>2)&1) );
+		}
+		for( int k=0 ; k<8 ; k++ ) for( int c=0 ; c<size ; c++ ) corners[k][c] = values[ offsets[k][c] ];
+		for( int c=0 ; c<size ; c++ )
+			samples[start+c] =
+				corners[0][c]*(Real(1.0)-dx[c])*(Real(1.0)-dy[c])*(Real(1.0)-dz[c])+
+				corners[1][c]*(          dx[c])*(Real(1.0)-dy[c])*(Real(1.0)-dz[c])+
+				corners[2][c]*(Real(1.0)-dx[c])*(          dy[c])*(Real(1.0)-dz[c])+
+				corners[3][c]*(          dx[c])*(          dy[c])*(Real(1.0)-dz[c])+
+				corners[4][c]*(Real(1.0)-dx[c])*(Real(1.0)-dy[c])*(          dz[c])+
+				corners[5][c]*(          dx[c])*(Real(1.0)-dy[c])*(          dz[c])+
+				corners[6][c]*(Real(1.0)-dx[c])*(          dy[c])*(          dz[c])+
+				corners[7][c]*(          dx[c])*(          dy[c])*(          dz[c]);
+	}
+}
 template<class Real>
 Real RotationGrid<Real>::squareNorm(void) const{return Dot(*this,*this);}
 template<class Real>
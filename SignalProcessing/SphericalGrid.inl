@@ -30,6 +30,7 @@ DAMAGE.
 #include <string.h>
 #include <math.h>
 #include <float.h>
+#include <Include/fftw3.h>
 
 template<class Real>
 Real ArcTan2(const Real& y,const Real& x){
@@ -53,11 +54,7 @@ SphericalGrid<Real>::SphericalGrid( int r )
 	if( r ) resize( r );
 }
 template<class Real>
-SphericalGrid<Real>::~SphericalGrid(void){
-	if(values){delete[] values;}
-	values=NULL;
-	res=0;
-}
+SphericalGrid<Real>::~SphericalGrid(void){if(values){resize(0);}}
 template<class Real>
 int SphericalGrid<Real>::read(const char* fileName){
 	FILE* fp=fopen(fileName,"rb");
@@ -95,6 +92,37 @@ int SphericalGrid<Real>::write(FILE* fp) const {
 }
 template<class Real>
 int SphericalGrid<Real>::resolution(void) const{return res;}
+// Use FFTW's allocator for floating-point grids so that the samples have the alignment the harmonic transform plans for
+int SphericalGrid<float>::resize(const int& r){
+	if(r<0){return 0;}
+	else{
+		if(values){fftwf_free(values);}
+		values=NULL;
+		res=0;
+		if(r){
+			values=(float*)fftwf_malloc(sizeof(float)*r*r);
+			if(!values){return 0;}
+			else{res=r;}
+		}
+		clear();
+		return 1;
+	}
+}
+int SphericalGrid<double>::resize(const int& r){
+	if(r<0){return 0;}
+	else{
+		if(values){fftw_free(values);}
+		values=NULL;
+		res=0;
+		if(r){
+			values=(double*)fftw_malloc(sizeof(double)*r*r);
+			if(!values){return 0;}
+			else{res=r;}
+		}
+		clear();
+		return 1;
+	}
+}
 template<class Real>
 int SphericalGrid<Real>::resize(const int& r){
 	if(r<0){return 0;}
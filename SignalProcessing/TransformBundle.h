@@ -0,0 +1,123 @@
+/*
+Copyright (c) 2013, Michael Kazhdan
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list of
+conditions and the following disclaimer. Redistributions in binary form must reproduce
+the above copyright notice, this list of conditions and the following disclaimer
+in the documentation and/or other materials provided with the distribution.
+
+Neither the name of the Johns Hopkins University nor the names of its contributors
+may be used to endorse or promote products derived from this software without specific
+prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+DAMAGE.
+*/
+#ifndef TRANSFORM_BUNDLE_INCLUDED
+#define TRANSFORM_BUNDLE_INCLUDED
+#include <stdio.h>
+#include <vector>
+
+// This class provides read access to a bundle of precomputed transform data:
+// the associated Legendre tables (and their transposes) used by the spherical harmonic transform,
+// the Wigner-d tables used by the inverse Wigner-D transform, the FFTW wisdom for the plans, and the
+// Legendre profile selecting the fastest projection engine for each order.
+// The bundle is memory-mapped, so the tables are read directly from the file (and shared by all processes using it).
+// The data is stored in the native byte-order of the machine that generated the bundle.
+class TransformBundle
+{
+public:
+	// The types of data stored in the bundle
+	enum
+	{
+		LEGENDRE_TABLE ,
+		TRANSPOSE_LEGENDRE_TABLE ,
+		WIGNER_D_TABLE ,
+		FFTW_WISDOM ,
+		LEGENDRE_PROFILE ,
+		ENTRY_TYPE_COUNT
+	};
+	static const int Version = 1;
+
+	// The description of a single entry to be written out
+	struct EntryData
+	{
+		int type , bw , elementSize;
+		const void* data;
+		size_t size;
+		EntryData( void ) : type(-1) , bw(0) , elementSize(0) , data(NULL) , size(0) { ; }
+		EntryData( int t , int b , int e , const void* d , size_t s ) : type(t) , bw(b) , elementSize(e) , data(d) , size(s) { ; }
+	};
+
+	TransformBundle( void );
+	~TransformBundle( void );
+
+	// Maps the bundle into memory
+	// Returns 0 if the file could not be mapped or is not a valid bundle
+	int read( const char* fileName );
+	void close( void );
+
+	// Returns a pointer to the data of the given type, band-width and element size (in bytes),
+	// or NULL if the bundle does not contain it. If "size" is not NULL, it is set to the size of the data (in bytes).
+	const void* entry( int type , int bw , int elementSize , size_t* size=NULL ) const;
+
+	// The Legendre tables are the "resultspace" arrays filled in by Spharmonic_Pml_Table and Transpose_Spharmonic_Pml_Table
+	template< class Real > const Real* legendreTable( int bw ) const;
+	template< class Real > const Real* transposeLegendreTable( int bw ) const;
+	// The Wigner-d tables are the (transposed) tables computed by genWigAllTrans
+	const double* wignerDTable( int bw ) const;
+
+	// The Legendre profile is the fastest engine for each order, as measured by HarmonicTransform::TuneLegendreEngines
+	// (an array of "bw" integers, for the given precision)
+	template< class Real > const int* legendreEngines( int bw ) const;
+
+	// Imports the FFTW wisdom stored in the bundle
+	int importWisdom( void ) const;
+
+	// Writes out the entries to a bundle file
+	static int Write( const char* fileName , const std::vector< EntryData >& entries );
+
+	// The number of elements in the Wigner-d table for the given band-width
+	static size_t WignerDTableSize( int bw );
+
+	// The process-wide bundle consulted by the transforms
+	static TransformBundle& Default( void );
+	// Maps the process-wide bundle and imports its FFTW wisdom.
+	// This should be called before any transforms are created.
+	static int Load( const char* fileName );
+private:
+	struct Header
+	{
+		char magic[8];
+		int version , entryCount;
+	};
+	struct Entry
+	{
+		int type , bw , elementSize , reserved;
+		long long offset , size;
+	};
+	static const char* _Magic( void ){ return "SPHBNDL"; }
+	// The alignment (in bytes) of the entries within the file
+	static const int _Alignment = 64;
+
+	const char* _data;
+	size_t _size;
+	const Entry* _entries;
+	int _entryCount;
+	void *_file , *_mapping;
+};
+
+#include "TransformBundle.inl"
+#endif // TRANSFORM_BUNDLE_INCLUDED
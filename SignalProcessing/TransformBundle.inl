@@ -0,0 +1,269 @@
+/*
+Copyright (c) 2013, Michael Kazhdan
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list of
+conditions and the following disclaimer. Redistributions in binary form must reproduce
+the above copyright notice, this list of conditions and the following disclaimer
+in the documentation and/or other materials provided with the distribution.
+
+Neither the name of the Johns Hopkins University nor the names of its contributors
+may be used to endorse or promote products derived from this software without specific
+prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+DAMAGE.
+*/
+#include <stdlib.h>
+#include <string.h>
+#ifdef WIN32
+#include <windows.h>
+#else // !WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif // WIN32
+#include "fftw3.h"
+#include <cospmls.h>
+
+/////////////////////
+// TransformBundle //
+/////////////////////
+inline TransformBundle::TransformBundle( void )
+{
+	_data = NULL;
+	_size = 0;
+	_entries = NULL;
+	_entryCount = 0;
+	_file = _mapping = NULL;
+}
+inline TransformBundle::~TransformBundle( void ){ close(); }
+
+inline int TransformBundle::read( const char* fileName )
+{
+	close();
+#ifdef WIN32
+	HANDLE file = CreateFileA( fileName , GENERIC_READ , FILE_SHARE_READ , NULL , OPEN_EXISTING , FILE_ATTRIBUTE_NORMAL , NULL );
+	if( file==INVALID_HANDLE_VALUE )
+	{
+		fprintf( stderr , "[ERROR] TransformBundle::read: Failed to open file: %s\n" , fileName );
+		return 0;
+	}
+	LARGE_INTEGER fileSize;
+	if( !GetFileSizeEx( file , &fileSize ) || !fileSize.QuadPart )
+	{
+		fprintf( stderr , "[ERROR] TransformBundle::read: Failed to get file size: %s\n" , fileName );
+		CloseHandle( file );
+		return 0;
+	}
+	HANDLE mapping = CreateFileMappingA( file , NULL , PAGE_READONLY , 0 , 0 , NULL );
+	void* data = mapping ? MapViewOfFile( mapping , FILE_MAP_READ , 0 , 0 , 0 ) : NULL;
+	if( !data )
+	{
+		fprintf( stderr , "[ERROR] TransformBundle::read: Failed to map file: %s\n" , fileName );
+		if( mapping ) CloseHandle( mapping );
+		CloseHandle( file );
+		return 0;
+	}
+	_file = file , _mapping = mapping;
+	_data = (const char*)data;
+	_size = size_t( fileSize.QuadPart );
+#else // !WIN32
+	int fd = open( fileName , O_RDONLY );
+	if( fd<0 )
+	{
+		fprintf( stderr , "[ERROR] TransformBundle::read: Failed to open file: %s\n" , fileName );
+		return 0;
+	}
+	struct stat fileStat;
+	if( fstat( fd , &fileStat ) || !fileStat.st_size )
+	{
+		fprintf( stderr , "[ERROR] TransformBundle::read: Failed to get file size: %s\n" , fileName );
+		::close( fd );
+		return 0;
+	}
+	void* data = mmap( NULL , size_t( fileStat.st_size ) , PROT_READ , MAP_SHARED , fd , 0 );
+	// The mapping remains valid after the file descriptor is closed
+	::close( fd );
+	if( data==MAP_FAILED )
+	{
+		fprintf( stderr , "[ERROR] TransformBundle::read: Failed to map file: %s\n" , fileName );
+		return 0;
+	}
+	_data = (const char*)data;
+	_size = size_t( fileStat.st_size );
+#endif // WIN32
+
+	const Header* header = (const Header*)_data;
+	if( _size<sizeof(Header) || strncmp( header->magic , _Magic() , sizeof(header->magic) ) )
+	{
+		fprintf( stderr , "[ERROR] TransformBundle::read: Not a transform bundle: %s\n" , fileName );
+		close();
+		return 0;
+	}
+	if( header->version!=Version )
+	{
+		fprintf( stderr , "[ERROR] TransformBundle::read: Bundle version does not match: %d != %d\n" , header->version , Version );
+		close();
+		return 0;
+	}
+	if( header->entryCount<0 || sizeof(Header)+sizeof(Entry)*size_t(header->entryCount)>_size )
+	{
+		fprintf( stderr , "[ERROR] TransformBundle::read: Truncated bundle: %s\n" , fileName );
+		close();
+		return 0;
+	}
+	_entries = (const Entry*)( _data + sizeof(Header) );
+	_entryCount = header->entryCount;
+	for( int i=0 ; i<_entryCount ; i++ ) if( _entries[i].offset<0 || _entries[i].size<0 || size_t( _entries[i].offset + _entries[i].size )>_size )
+	{
+		fprintf( stderr , "[ERROR] TransformBundle::read: Truncated bundle: %s\n" , fileName );
+		close();
+		return 0;
+	}
+	return 1;
+}
+inline void TransformBundle::close( void )
+{
+	if( _data )
+	{
+#ifdef WIN32
+		UnmapViewOfFile( _data );
+		if( _mapping ) CloseHandle( (HANDLE)_mapping );
+		if( _file ) CloseHandle( (HANDLE)_file );
+#else // !WIN32
+		munmap( (void*)_data , _size );
+#endif // WIN32
+	}
+	_data = NULL;
+	_size = 0;
+	_entries = NULL;
+	_entryCount = 0;
+	_file = _mapping = NULL;
+}
+inline const void* TransformBundle::entry( int type , int bw , int elementSize , size_t* size ) const
+{
+	for( int i=0 ; i<_entryCount ; i++ ) if( _entries[i].type==type && _entries[i].bw==bw && _entries[i].elementSize==elementSize )
+	{
+		if( size ) *size = size_t( _entries[i].size );
+		return _data + _entries[i].offset;
+	}
+	return NULL;
+}
+// The tables are only returned if they have the size the transforms will read, so that a mismatched entry is recomputed
+template< class Real >
+const Real* TransformBundle::legendreTable( int bw ) const
+{
+	size_t size;
+	const Real* table = (const Real*)entry( LEGENDRE_TABLE , bw , sizeof(Real) , &size );
+	return ( table && size==sizeof(Real)*size_t( Spharmonic_TableSize( bw ) ) ) ? table : NULL;
+}
+template< class Real >
+const Real* TransformBundle::transposeLegendreTable( int bw ) const
+{
+	size_t size;
+	const Real* table = (const Real*)entry( TRANSPOSE_LEGENDRE_TABLE , bw , sizeof(Real) , &size );
+	return ( table && size==sizeof(Real)*size_t( Spharmonic_TableSize( bw ) ) ) ? table : NULL;
+}
+inline const double* TransformBundle::wignerDTable( int bw ) const
+{
+	size_t size;
+	const double* table = (const double*)entry( WIGNER_D_TABLE , bw , sizeof(double) , &size );
+	return ( table && size==sizeof(double)*WignerDTableSize( bw ) ) ? table : NULL;
+}
+template< class Real >
+const int* TransformBundle::legendreEngines( int bw ) const
+{
+	size_t size;
+	const int* engines = (const int*)entry( LEGENDRE_PROFILE , bw , sizeof(Real) , &size );
+	return ( engines && size==sizeof(int)*bw ) ? engines : NULL;
+}
+
+inline int TransformBundle::importWisdom( void ) const
+{
+	// The wisdom is stored as null-terminated strings, one for each precision
+	const char *wisdom = (const char*)entry( FFTW_WISDOM , 0 , sizeof(double) ) , *wisdomf = (const char*)entry( FFTW_WISDOM , 0 , sizeof(float) );
+	int success = 1;
+	// FFTW's planner is not thread-safe
+#pragma omp critical (FFTWPlanner)
+	{
+		if( wisdom  && !fftw_import_wisdom_from_string ( wisdom  ) ) success = 0;
+		if( wisdomf && !fftwf_import_wisdom_from_string( wisdomf ) ) success = 0;
+	}
+	if( !success ) fprintf( stderr , "[WARNING] TransformBundle::importWisdom: Failed to import FFTW wisdom\n" );
+	return success;
+}
+
+inline int TransformBundle::Write( const char* fileName , const std::vector< EntryData >& entries )
+{
+	FILE* fp = fopen( fileName , "wb" );
+	if( !fp )
+	{
+		fprintf( stderr , "[ERROR] TransformBundle::Write: Failed to open file for writing: %s\n" , fileName );
+		return 0;
+	}
+	Header header;
+	memset( &header , 0 , sizeof(Header) );
+	strncpy( header.magic , _Magic() , sizeof(header.magic) );
+	header.version = Version;
+	header.entryCount = int( entries.size() );
+
+	// Lay out the data after the table of entries, aligning each entry
+	std::vector< Entry > _entries( entries.size() );
+	long long offset = sizeof(Header) + sizeof(Entry)*entries.size();
+	for( int i=0 ; i<entries.size() ; i++ )
+	{
+		offset = ( ( offset + _Alignment - 1 ) / _Alignment ) * _Alignment;
+		_entries[i].type = entries[i].type;
+		_entries[i].bw = entries[i].bw;
+		_entries[i].elementSize = entries[i].elementSize;
+		_entries[i].reserved = 0;
+		_entries[i].offset = offset;
+		_entries[i].size = (long long)entries[i].size;
+		offset += _entries[i].size;
+	}
+
+	bool success = fwrite( &header , sizeof(Header) , 1 , fp )==1;
+	if( success && entries.size() ) success = fwrite( &_entries[0] , sizeof(Entry) , entries.size() , fp )==entries.size();
+	long long position = sizeof(Header) + sizeof(Entry)*entries.size();
+	char padding[_Alignment];
+	memset( padding , 0 , sizeof(padding) );
+	for( int i=0 ; i<entries.size() && success ; i++ )
+	{
+		if( _entries[i].offset>position ) success = fwrite( padding , 1 , size_t( _entries[i].offset-position ) , fp )==size_t( _entries[i].offset-position );
+		if( success && entries[i].size ) success = fwrite( entries[i].data , 1 , entries[i].size , fp )==entries[i].size;
+		position = _entries[i].offset + _entries[i].size;
+	}
+	fclose( fp );
+	if( !success ) fprintf( stderr , "[ERROR] TransformBundle::Write: Failed to write bundle: %s\n" , fileName );
+	return success ? 1 : 0;
+}
+
+inline size_t TransformBundle::WignerDTableSize( int bw )
+{
+	// 1/3 * bw^2 * (2 + 3*bw + bw^2), as in genWigAllTrans
+	return ( size_t(bw) * bw * ( 2 + 3*size_t(bw) + size_t(bw)*bw ) ) / 3;
+}
+
+inline TransformBundle& TransformBundle::Default( void )
+{
+	static TransformBundle bundle;
+	return bundle;
+}
+inline int TransformBundle::Load( const char* fileName )
+{
+	if( !Default().read( fileName ) ) return 0;
+	return Default().importWisdom();
+}
@@ -19,6 +19,13 @@ void SubSampleSpheres( const CubeGrid< Real >& grid , std::vector< SphericalGrid
 template< class Real >
 void SubSampleSpheres( const CubeGrid< Real >& grid , std::vector< FourierKeyS2< Real > >& sphericalHarmonics , Point3D< Real > center , Real maxRadius , int radii , int sphereResolution , int subSphereResolution , int threads=1 );
 
+// These versions read a single prefiltered value per sample from the grid's mip pyramid, rather than super-sampling the dual cell.
+// (The pyramid only needs to be built once per grid.)
+template< class Real >
+void SubSampleSpheres( const CubeGridPyramid< Real >& pyramid , std::vector< SphericalGrid< Real > >& spheres , Point3D< Real > center , Real maxRadius , int radii , int sphereResolution , int threads=1 );
+template< class Real >
+void SubSampleSpheres( const CubeGridPyramid< Real >& pyramid , std::vector< FourierKeyS2< Real > >& sphericalHarmonics , Point3D< Real > center , Real maxRadius , int radii , int sphereResolution , int threads=1 );
+
 
 template< class Real >
 void SampleSpheres( const std::vector< SphericalGrid< Real > >& spheres , CubeGrid< Real >& grid , Point3D< Real > center , Real maxRadius , int gridResolution , int threads=1 );
@@ -45,19 +52,9 @@ template< class Real >
 void SampleSpheres( const CubeGrid< Real >& grid , std::vector< FourierKeyS2< Real > >& sphericalHarmonics , Point3D< Real > center , Real maxRadius , int radii , int sphereResolution , int threads )
 {
 	HarmonicTransform< Real > xForm( sphereResolution );
-	SphericalGrid< Real > sphere( sphereResolution );
-	sphericalHarmonics.resize( radii );
-	for( int i=0 ; i<radii ; i++ )
-	{
-		Real radius = ( Real(i+0.5)/radii ) * maxRadius;
-		sphericalHarmonics[i].resize( sphereResolution );
-		grid.SphereSample( &center[0] , radius , sphere , threads );
-		Real scale = Real( sqrt( 4*M_PI*radius*radius ) );
-		Real* _sphere = sphere[0];
-#pragma omp parallel for num_threads( threads )
-		for( int j=0 ; j<sphereResolution*sphereResolution ; j++ ) _sphere[j] *= scale;
-		xForm.ForwardFourier( sphere , sphericalHarmonics[i] );
-	}
+	std::vector< SphericalGrid< Real > > spheres;
+	SampleSpheres( grid , spheres , center , maxRadius , radii , sphereResolution , threads );
+	xForm.ForwardFourier( spheres , sphericalHarmonics );
 }
 template< class Real >
 void SubSampleSpheres( const CubeGrid< Real >& grid , std::vector< SphericalGrid< Real > >& spheres , Point3D< Real > center , Real maxRadius , int radii , int sphereResolution , int subSphereResolution , int threads )
@@ -78,23 +75,36 @@ void SubSampleSpheres( const CubeGrid< Real >& grid , std::vector< SphericalGrid
 template< class Real >
 void SubSampleSpheres( const CubeGrid< Real >& grid , std::vector< FourierKeyS2< Real > >& sphericalHarmonics , Point3D< Real > center , Real maxRadius , int radii , int sphereResolution , int subSphereResolution , int threads )
 {
-	Real thickness = Real( maxRadius/radii );
 	HarmonicTransform< Real > xForm( sphereResolution );
-	SphericalGrid< Real > sphere( sphereResolution );
-	sphericalHarmonics.resize( radii );
+	std::vector< SphericalGrid< Real > > spheres;
+	SubSampleSpheres( grid , spheres , center , maxRadius , radii , sphereResolution , subSphereResolution , threads );
+	xForm.ForwardFourier( spheres , sphericalHarmonics );
+}
+template< class Real >
+void SubSampleSpheres( const CubeGridPyramid< Real >& pyramid , std::vector< SphericalGrid< Real > >& spheres , Point3D< Real > center , Real maxRadius , int radii , int sphereResolution , int threads )
+{
+	Real thickness = Real( maxRadius/radii );
+	spheres.resize( radii );
 	for( int i=0 ; i<radii ; i++ )
 	{
 		Real radius = ( Real(i+0.5)/radii ) * maxRadius;
-		sphericalHarmonics[i].resize( sphereResolution );
-		grid.SphereSample( &center[0] , radius , sphere , subSphereResolution , thickness , threads );
+		spheres[i].resize( sphereResolution );
+		pyramid.SphereSample( &center[0] , radius , spheres[i] , thickness , threads );
 		Real scale = Real( sqrt( 4*M_PI*radius*radius ) );
-		Real* _sphere = sphere[0];
+		Real* _sphere = spheres[i][0];
 #pragma omp parallel for num_threads( threads )
 		for( int j=0 ; j<sphereResolution*sphereResolution ; j++ ) _sphere[j] *= scale;
-		xForm.ForwardFourier( sphere , sphericalHarmonics[i] );
 	}
 }
 template< class Real >
+void SubSampleSpheres( const CubeGridPyramid< Real >& pyramid , std::vector< FourierKeyS2< Real > >& sphericalHarmonics , Point3D< Real > center , Real maxRadius , int radii , int sphereResolution , int threads )
+{
+	HarmonicTransform< Real > xForm( sphereResolution );
+	std::vector< SphericalGrid< Real > > spheres;
+	SubSampleSpheres( pyramid , spheres , center , maxRadius , radii , sphereResolution , threads );
+	xForm.ForwardFourier( spheres , sphericalHarmonics );
+}
+template< class Real >
 void SampleSpheres( const std::vector< SphericalGrid< Real > >& spheres , CubeGrid< Real >& grid , Point3D< Real > center , Real maxRadius , int gridResolution , int threads )
 {
 	grid.resize( gridResolution );